@@ -31,6 +31,17 @@ typedef struct tile
 	int soil_energy;
 	Fish_Pool *local_fish;
 } Tile;
+/* Stores information of a file-backed, memory-mapped vegetation layer. */
+typedef struct grid_storage
+{
+	Tile *tiles;
+	long long n_tiles;
+	void *mapping;
+	size_t mapping_size;
+	int file_descriptor;
+	int size_x;
+	int size_y;
+} Grid_Storage;
 /* Stores fishery settings. */
 typedef struct fishery_settings
 {
@@ -57,28 +68,203 @@ typedef struct fishery_settings
 	int fishing_chance;
 
 } Fishery_Settings;
+/* Stores quantities derived from fishery settings, built once per fishery
+   so the update loops don't recompute them. Also selects the update kernels
+   specialized for the settings. */
+typedef struct fishery_plan
+{
+	Fishery_Settings settings;		/* Copy of settings the plan was built from. */
+
+	int *fish_appetite;				/* Food a fish pool of each level can eat. */
+	int *fish_growth_threshold;		/* Food needed for growth at each level. */
+	int *vegetation_spreads;		/* 1 if vegetation level spreads, 0 otherwise. */
+	double fishing_probability;
+	double fishing_probability_eff;	/* Probability of a fishing trial with rand(). */
+	double random_fishes_probability;
+
+	int fish_kernel;				/* Index of specialized fish update kernel. */
+} Fishery_Plan;
+/* Stores time spent in each phase of UpdateFishery. The times are only 
+   measured if the simulation is compiled with FISHERY_PROFILE defined. */
+typedef struct fishery_profile
+{
+	double vegetation_time;
+	double fish_time;
+	double fishing_time;
+	double statistics_time;		/* Population and vegetation sums. */
+	long long steps;
+} Fishery_Profile;
+/* Stores counts of the events of the fish population during one call
+   of UpdateFishery. */
+typedef struct fishery_events
+{
+	long long moves;
+	long long failed_moves;			/* No tile to move to found. */
+	long long splits;
+	long long failed_splits;		/* No tile to split to found. */
+	long long starvation_deaths;
+	long long fishing_deaths;
+	long long spawns;
+} Fishery_Events;
+/* Stores optional engine modes of a fishery. Every option is off (zero)
+   by default, which keeps the results of the original simulation. */
+typedef struct fishery_options
+{
+	int fishing_sampling;		/* Draw only the fished pools in FishingEvent. */
+	int private_rng;			/* Draw random numbers from the stream of the
+								   fishery instead of rand(). */
+	int directed_moves;			/* Move hungry fish pools towards the nearest
+								   vegetation instead of random hops. */
+	int toroidal;				/* Opposite borders of the vegetation layer
+								   are neighbors. */
+	int phased_metabolism;		/* Move and feed all fish pools before the
+								   metabolism of the whole population. */
+	int spatial_sort;			/* Sort fish pools by position before each
+								   fish population update. */
+	int move_radius;			/* Radius of the random moves of fish pools,
+								   one if zero. */
+} Fishery_Options;
+/* Stores the layout of the vegetation layer, i.e. the index of the tile at
+   each position, see LayoutIndex. */
+typedef struct fishery_layout
+{
+	int type;					/* FISHERY_LAYOUT_COLUMNS or _TILED. */
+	int size_x;
+	int size_y;
+	int blocks_y;				/* Blocks in y direction of tiled layout. */
+	long long n_tiles;			/* Tiles in vegetation layer, including the 
+								   padding of the blocks of tiled layout. */
+} Fishery_Layout;
+/* Stores the move index of a fishery, see fishery_index.h. The counts are
+   two-dimensional Fenwick trees, node (i, j) from one at (j - 1) + 
+   (i - 1)*size_y. */
+typedef struct fishery_move_index
+{
+	int size_x;
+	int size_y;
+	int valid;					/* 1 while the index matches the vegetation 
+								   layer, i.e. during fish population updates. */
+	int *free_counts;			/* Free tiles. */
+	int *vegetation_counts;		/* Free tiles with vegetation level over one. */
+	unsigned char *states;		/* State of each tile, column by column. */
+} Fishery_Move_Index;
+/* Stores state of a random number stream, see NextRNG. */
+typedef struct fishery_rng
+{
+	unsigned long long state;
+} Fishery_RNG;
 /* Stores fishery simulation, including settings, vegetation layer 
    and fish population. */
 typedef struct fishery
 {
 	Tile *vegetation_layer;
+	Fishery_Layout layout;
 	LList_Node *fish_list;
 	unsigned int fishery_id;
 	Fishery_Settings *settings;
+	void *settings_owner;		/* Owner of shared settings, NULL if the 
+								   fishery owns its settings. */
+	Grid_Storage *storage;		/* NULL if vegetation layer is in heap memory. */
+	Fishery_Plan *plan;
+	Fishery_Profile profile;
+	Fishery_Events events;		/* Reset at the start of UpdateFishery. */
+	Fishery_Options options;
+	Fishery_RNG rng;			/* Used if options.private_rng is set. */
+	Fishery_Move_Index *move_index;	/* Used with large options.move_radius,
+								   NULL until the first fish update. */
 } Fishery;
 /* Stores fishery simulation results. */
 typedef struct fishery_results
 {
-	int yield;
-	int fish_n;
-	int vegetation_n;
-	int debug_stuff;
+	long long yield;
+	long long fish_n;
+	long long vegetation_n;
+	long long debug_stuff;
 
 	double yield_std_dev;
 	double fish_n_std_dev;
 	double vegetation_n_std_dev;
 
-	int steps;
+	long long steps;
+	Fishery_Events events;
 } Fishery_Results;
+/* Stores the totals of a single simulation step. */
+typedef struct fishery_step
+{
+	long long step;					/* Number of the step in the run, from 1. */
+	long long fish_n;
+	long long yield;
+	long long vegetation_n;
+} Fishery_Step;
+/* Called after steps of UpdateFisheryCallback, returns nonzero to stop. */
+typedef int (*Fishery_Step_Callback)(void *data, const Fishery_Step *step);
+/* Stores fisheries with the same settings, which are updated in lockstep. 
+   The vegetation layers are interleaved during the vegetation update, the
+   values of lane l at tile i are at index i*n_lanes + l. */
+typedef struct fishery_ensemble
+{
+	Fishery **lanes;
+	int n_lanes;
+	long long n_tiles;
+	int *vegetation_levels;
+	int *new_vegetation_levels;
+	int *soil_energies;
+	int *spreads;					/* Spread to current tile, for each lane. */
+} Fishery_Ensemble;
+
+/* Stores a transport of the messages between neighboring domains of a 
+   decomposed fishery, see fishery_domain.h. Link 0 leads to the domain on
+   the left, link 1 to the domain on the right. */
+typedef struct fishery_transport
+{
+	/* Sends message on link, returns 1 if successful. The message may be 
+	   delivered later, at the latest when the transport is destroyed. */
+	int (*send)(struct fishery_transport *transport, int link, const void *data, size_t size);
+	/* Returns next message of link, freed by the caller. NULL if failed. */
+	void *(*receive)(struct fishery_transport *transport, int link, size_t *size);
+	void (*destroy)(struct fishery_transport *transport);
+	void *state;
+} Fishery_Transport;
+/* Stores a domain of a decomposed fishery, i.e. a strip of columns of the
+   vegetation layer with halo columns copied from the neighboring domains. */
+typedef struct fishery_domain
+{
+	int domain;
+	int n_domains;
+	int x0;						/* First column owned by the domain. */
+	int x1;						/* Column after the last owned column. */
+	int halo_left;				/* Halo columns on each side, zero at the */
+	int halo_right;				/* borders of the vegetation layer. */
+	unsigned long long seed;
+	long long step;				/* Steps run. */
+	Fishery_Settings settings;	/* Settings of the strip. */
+	Fishery *fishery;			/* Strip including the halo columns. */
+	int *halo_vegetation;		/* Vegetation of the halo columns after the
+								   vegetation update. */
+	double spawn_probability;	/* Chance of a random fish pool spawning on
+								   the owned columns in a step. */
+} Fishery_Domain;
+
+/* Stores the result of a job of an executor, see fishery_executor.h. All
+   fields are eight bytes, so the table has no padding. */
+typedef struct fishery_job_result
+{
+	long long status;			/* FISHERY_JOB_PENDING, _RUNNING, _DONE or 
+								   _FAILED. */
+	long long worker;			/* Process id of the worker of the job. */
+	Fishery_Results results;
+} Fishery_Job_Result;
+/* Stores the jobs of an executor in shared memory, see fishery_executor.h. */
+typedef struct fishery_job_table
+{
+	long long n_jobs;
+	long long n;				/* Steps of each job. */
+	long long *next_job;		/* Next job of the queue of the workers. */
+	Fishery_Job_Result *results;	/* Result of each job. */
+	Fishery_Step *series;		/* Steps of each job, job by job. NULL unless
+								   the steps are recorded. */
+	void *mapping;
+	size_t mapping_size;
+} Fishery_Job_Table;
 
 #endif /* FISHERY_DATA_TYPES_H_ */
\ No newline at end of file
@@ -0,0 +1,33 @@
+/*****************************************************************************
+* Filename: fishery_domain.h												 *
+*																			 *
+* Contains functions for domain-decomposed simulation, i.e. updating strips *
+* of columns of a fishery in separate domains, which exchange halo columns  *
+* and migrating fish pools with their neighbors through a transport.		 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_DOMAIN_H_
+#define FISHERY_DOMAIN_H_
+
+#include "fishery_data_types.h"
+
+/* Transports of UpdateFisheryDomains. */
+#define FISHERY_TRANSPORT_LOCAL		0	/* All domains in the calling process. */
+#define FISHERY_TRANSPORT_SOCKETS	1	/* A process per domain, connected with
+										   Unix domain sockets. */
+/* Halo columns on each interior side of a domain. */
+#define FISHERY_DOMAIN_HALO			2
+
+Fishery_Domain *CreateFisheryDomain(const Fishery *fishery, Fishery_Settings settings,
+	int domain, int n_domains, unsigned long long seed);
+int RunFisheryDomain(Fishery_Domain *domain, Fishery_Transport *transport, long long n,
+	Fishery_Step *steps);
+void DestroyFisheryDomain(Fishery_Domain *domain);
+Fishery_Transport *CreateLocalTransports(int n_domains);
+Fishery_Transport *CreateSocketTransports(int n_domains);
+void DestroyTransports(Fishery_Transport *transports, int n_domains);
+int UpdateFisheryDomains(Fishery *fishery, Fishery_Settings settings, long long n,
+	int n_domains, int transport_type, unsigned long long seed, Fishery_Results *results);
+
+#endif /* FISHERY_DOMAIN_H_ */
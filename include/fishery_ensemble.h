@@ -0,0 +1,20 @@
+/*****************************************************************************
+* Filename: fishery_ensemble.h												 *
+*																			 *
+* Contains functions for updating ensembles, i.e. fisheries with the same	 *
+* settings updated in lockstep.											 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_ENSEMBLE_H_
+#define FISHERY_ENSEMBLE_H_
+
+#include "fishery_data_types.h"
+
+Fishery_Ensemble *CreateEnsemble(Fishery **lanes, int n_lanes, Fishery_Settings settings);
+void UpdateEnsembleVegetation(Fishery_Ensemble *ensemble, Fishery_Settings settings);
+void UpdateEnsemble(Fishery_Ensemble *ensemble, Fishery_Settings settings, long long n,
+	Fishery_Results *results);
+void DestroyEnsemble(Fishery_Ensemble *ensemble);
+
+#endif /* FISHERY_ENSEMBLE_H_ */
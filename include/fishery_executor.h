@@ -0,0 +1,26 @@
+/*****************************************************************************
+* Filename: fishery_executor.h												 *
+*																			 *
+* Contains functions for running fisheries in worker processes, which take	 *
+* jobs from a shared queue and write the results to a table in shared		 *
+* memory.																	 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_EXECUTOR_H_
+#define FISHERY_EXECUTOR_H_
+
+#include "fishery_data_types.h"
+
+/* Status of a job in Fishery_Job_Result. */
+#define FISHERY_JOB_PENDING		0
+#define FISHERY_JOB_RUNNING		1
+#define FISHERY_JOB_DONE		2
+#define FISHERY_JOB_FAILED		3
+
+Fishery_Job_Table *CreateJobTable(long long n_jobs, long long n, int record_series);
+long long RunJobTable(Fishery_Job_Table *table, Fishery **fisheries, 
+	const Fishery_Settings *settings, const unsigned long long *seeds, int n_workers);
+void DestroyJobTable(Fishery_Job_Table *table);
+
+#endif /* FISHERY_EXECUTOR_H_ */
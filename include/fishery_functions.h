@@ -10,15 +10,40 @@
 
 #include "fishery_data_types.h"
 #include "help_functions.h"
+#include "fishery_storage.h"
+#include "fishery_plan.h"
+#include "fishery_ensemble.h"
+#include "fishery_layout.h"
+#include "fishery_index.h"
+#include "fishery_domain.h"
+#include "fishery_executor.h"
+#include "fishery_reference.h"
 
 int CheckFishMemory(Fishery *fishery, Fishery_Settings settings);
 
 Fishery *CreateFishery(Fishery_Settings settings);
+Fishery *CreateFisheryFromState(Fishery_Settings settings, const int *vegetation_levels,
+	const int *soil_energies, const Fish_Pool *fish_pools, long long n_fish);
+Fishery *CreateFisheryEmpty(Fishery_Settings settings);
+Fishery *CreateFisheryMapped(Fishery_Settings settings, const char *path);
+Fishery *OpenFisheryMapped(Fishery_Settings settings, const char *path);
+int SyncFishery(Fishery *fishery);
 void DestroyFishery(void *fishery);
 
-Fishery_Results UpdateFishery(Fishery *fishery, Fishery_Settings settings, int n);
+void ResetFisheryProfile(Fishery *fishery);
+void SeedFisheryRNG(Fishery *fishery, unsigned long long seed);
+Fishery_Plan *GetFisheryPlan(Fishery *fishery, Fishery_Settings settings);
+Fishery_Results UpdateFishery(Fishery *fishery, Fishery_Settings settings, long long n);
+Fishery_Results UpdateFisheryCallback(Fishery *fishery, Fishery_Settings settings, 
+	long long n, long long every, Fishery_Step_Callback callback, void *data);
+Fishery_Step StepFishery(Fishery *fishery, Fishery_Settings settings);
+Fishery_Step StepFisheryPopulation(Fishery *fishery, Fishery_Settings settings);
+void InitFisheryResults(Fishery_Results *results, Fishery *fishery);
+void AddFisheryStep(Fishery_Results *results, const Fishery_Step *step);
+void FinishFisheryResults(Fishery_Results *results, Fishery *fishery, long long n);
 void UpdateFisheryVegetation(Fishery *fishery, Fishery_Settings settings);
 void UpdateFisheryFishPopulation(Fishery *fishery, Fishery_Settings settings);
-int FishingEvent(Fishery *fishery, Fishery_Settings settings);
+int SortFisheryFish(Fishery *fishery);
+long long FishingEvent(Fishery *fishery, Fishery_Settings settings);
 
 #endif /* FISHERY_FUNCTIONS_H_ */
\ No newline at end of file
@@ -0,0 +1,27 @@
+/*****************************************************************************
+* Filename: fishery_index.h													 *
+*																			 *
+* Contains functions for the move index of a fishery, i.e. two-dimensional	 *
+* Fenwick trees counting the free tiles and the free tiles with vegetation	 *
+* of the vegetation layer. The index finds new coordinates of fish pools in *
+* a large window without scanning every tile of the window.				 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_INDEX_H_
+#define FISHERY_INDEX_H_
+
+#include "fishery_data_types.h"
+
+/* Smallest radius of moves which uses the move index. Smaller windows are
+   faster to scan. */
+#define MOVE_INDEX_MIN_RADIUS	3
+
+Fishery_Move_Index *CreateMoveIndex(int size_x, int size_y);
+void BuildMoveIndex(Fishery_Move_Index *index, const Fishery *fishery);
+void UpdateMoveIndex(Fishery_Move_Index *index, const Fishery *fishery, long long coords);
+long long SampleMoveIndex(const Fishery_Move_Index *index, const Fishery *fishery,
+	long long cur_coords, int radius);
+void DestroyMoveIndex(Fishery_Move_Index *index);
+
+#endif /* FISHERY_INDEX_H_ */
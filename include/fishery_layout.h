@@ -0,0 +1,64 @@
+/*****************************************************************************
+* Filename: fishery_layout.h												 *
+*																			 *
+* Contains functions for the layout of the vegetation layer. By default the *
+* tiles are stored column by column, i.e. the tile at (x, y) is at index	 *
+* y + x*size_y. The tiled layout stores blocks of 8x8 tiles, so the tiles	 *
+* of a neighborhood are close to each other in memory on large layers.		 *
+* The engine accesses tiles only through LayoutIndex and LayoutCoords.		 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_LAYOUT_H_
+#define FISHERY_LAYOUT_H_
+
+#include "fishery_data_types.h"
+#include "help_functions.h"
+
+#define FISHERY_LAYOUT_COLUMNS	0
+#define FISHERY_LAYOUT_TILED	1
+#define FISHERY_LAYOUT_N		2
+
+/* Blocks of the tiled layout have 2^FISHERY_BLOCK_SHIFT tiles per side. */
+#define FISHERY_BLOCK_SHIFT		3
+#define FISHERY_BLOCK_SIZE		(1 << FISHERY_BLOCK_SHIFT)
+#define FISHERY_BLOCK_MASK		(FISHERY_BLOCK_SIZE - 1)
+
+extern const char *FISHERY_LAYOUT_NAMES[FISHERY_LAYOUT_N];
+
+void InitLayout(Fishery_Layout *layout, int type, int size_x, int size_y);
+int SetFisheryLayout(Fishery *fishery, int type);
+
+/* Function: LayoutIndex
+ * ---------------------
+ * Returns index of the tile at (pos_x, pos_y) in the vegetation layer.
+ */
+static FISHERY_INLINE long long LayoutIndex(const Fishery_Layout *layout, int pos_x, int pos_y) {
+	if (layout->type == FISHERY_LAYOUT_COLUMNS)
+		return pos_y + (long long)pos_x*layout->size_y;
+	return ((((long long)(pos_x >> FISHERY_BLOCK_SHIFT)*layout->blocks_y +
+		(pos_y >> FISHERY_BLOCK_SHIFT)) << (2*FISHERY_BLOCK_SHIFT)) |
+		((pos_x & FISHERY_BLOCK_MASK) << FISHERY_BLOCK_SHIFT) | (pos_y & FISHERY_BLOCK_MASK));
+}
+/* Function: LayoutCoords
+ * ----------------------
+ * Sets position of the tile at index of the vegetation layer, i.e. the 
+ * inverse of LayoutIndex.
+ */
+static FISHERY_INLINE void LayoutCoords(const Fishery_Layout *layout, long long index,
+	int *pos_x, int *pos_y) {
+	long long block;
+
+	if (layout->type == FISHERY_LAYOUT_COLUMNS) {
+		*pos_x = (int)(index / layout->size_y);
+		*pos_y = (int)(index % layout->size_y);
+		return;
+	}
+	block = index >> (2*FISHERY_BLOCK_SHIFT);
+	*pos_x = ((int)(block / layout->blocks_y) << FISHERY_BLOCK_SHIFT) |
+		(int)((index >> FISHERY_BLOCK_SHIFT) & FISHERY_BLOCK_MASK);
+	*pos_y = ((int)(block % layout->blocks_y) << FISHERY_BLOCK_SHIFT) |
+		(int)(index & FISHERY_BLOCK_MASK);
+}
+
+#endif /* FISHERY_LAYOUT_H_ */
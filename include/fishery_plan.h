@@ -0,0 +1,24 @@
+/*****************************************************************************
+* Filename: fishery_plan.h													 *
+*																			 *
+* Contains functions for building the compiled plan of a fishery, i.e.		 *
+* lookup tables derived from the settings and the selection of the update	 *
+* kernels specialized for the settings.									 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_PLAN_H_
+#define FISHERY_PLAN_H_
+
+#include "fishery_data_types.h"
+
+/* Fish update kernels, specialized by splitting and random spawning. */
+#define FISH_KERNEL_SPLIT		1
+#define FISH_KERNEL_SPAWN		2
+#define FISH_KERNEL_N			4
+
+Fishery_Plan *CreatePlan(Fishery_Settings settings);
+int PlanMatchesSettings(const Fishery_Plan *plan, Fishery_Settings settings);
+void DestroyPlan(Fishery_Plan *plan);
+
+#endif /* FISHERY_PLAN_H_ */
@@ -0,0 +1,23 @@
+/*****************************************************************************
+* Filename: fishery_reference.h												 *
+*																			 *
+* Contains the reference engine of the fishery simulation, i.e. frozen		 *
+* copies of the original vegetation, fish population and fishing updates,	 *
+* and functions for comparing the state of two fisheries. Optimized		 *
+* updates are checked against the reference engine.						 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_REFERENCE_H_
+#define FISHERY_REFERENCE_H_
+
+#include "fishery_data_types.h"
+
+void ReferenceUpdateVegetation(Fishery *fishery, Fishery_Settings settings);
+void ReferenceUpdateFishPopulation(Fishery *fishery, Fishery_Settings settings);
+long long ReferenceFishingEvent(Fishery *fishery, Fishery_Settings settings);
+Fishery_Step ReferenceStepFishery(Fishery *fishery, Fishery_Settings settings);
+int CompareFisheryState(const Fishery *fishery1, const Fishery *fishery2,
+	Fishery_Settings settings, int output_print);
+
+#endif /* FISHERY_REFERENCE_H_ */
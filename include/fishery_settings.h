@@ -8,11 +8,16 @@
 
 
 #ifndef FISHERY_SETTINGS_H_
-#define FISHERY_SETTINGS_H
+#define FISHERY_SETTINGS_H_
 
 #include "fishery_data_types.h"
 #include "help_functions.h"
 
+/* Upper limits for the size of the vegetation layer. Cell counts and
+   indices are 64-bit, the limits keep the memory requirements sane. */
+#define FISHERY_MAX_SIZE_DIM	(1 << 24)
+#define FISHERY_MAX_CELLS		(1LL << 36)
+
 int ValidateSettings(
 	Fishery_Settings settings, int output_print);
 Fishery_Settings CreateSettings(
@@ -29,4 +34,4 @@ void PrintSettings(
 int AddSetting(
 	Fishery_Settings *settings, const char *setting_name, void *setting_value);
 
-#endif
\ No newline at end of file
+#endif /* FISHERY_SETTINGS_H_ */
\ No newline at end of file
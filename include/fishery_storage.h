@@ -0,0 +1,20 @@
+/*****************************************************************************
+* Filename: fishery_storage.h												 *
+*																			 *
+* Contains functions for storing the vegetation layer of a fishery in a	 *
+* memory-mapped file. The file doubles as a checkpoint of the simulation.	 *
+*																			 *
+******************************************************************************/
+
+#ifndef FISHERY_STORAGE_H_
+#define FISHERY_STORAGE_H_
+
+#include "fishery_data_types.h"
+
+Grid_Storage *StorageCreate(const char *path, int size_x, int size_y);
+Grid_Storage *StorageOpen(const char *path, int size_x, int size_y);
+int StorageWriteFish(Grid_Storage *storage, LList_Node *fish_list);
+long long StorageReadFish(Grid_Storage *storage, Fish_Pool **fish_pools);
+void StorageRelease(Grid_Storage *storage);
+
+#endif /* FISHERY_STORAGE_H_ */
@@ -7,16 +7,37 @@
 ******************************************************************************/
 
 #ifndef HELP_FUNCTIONS_H_
-#define HELP_FUNCTIONS_H
+#define HELP_FUNCTIONS_H_
 
 #include "fishery_data_types.h"
 
-#define GENERATERANDINT(a, b)  ((int) ((double) rand() / (RAND_MAX + 1L) * ((b-a) + 1) + a))
+/* The C compiler of Visual Studio only knows __inline. */
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define FISHERY_INLINE __inline
+#else
+#define FISHERY_INLINE inline
+#endif
+/* Arrays of the vectorized loops do not overlap, Visual Studio only knows
+   __restrict. */
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define FISHERY_RESTRICT __restrict
+#else
+#define FISHERY_RESTRICT restrict
+#endif
+
+/* Random numbers of the simulation are drawn from fishery_rng_stream while
+   it is set, otherwise from rand(). */
+#define FISHERY_RAND() (fishery_rng_stream != NULL ? NextRNG(fishery_rng_stream) : rand())
+#define GENERATERANDINT(a, b)  ((int) ((double) FISHERY_RAND() / (RAND_MAX + 1L) * ((b-a) + 1) + a))
+
+extern Fishery_RNG *fishery_rng_stream;
 
 /* Functions for creating, manipulating and destroying linked list structures. */
 LList_Node *LListCreate(void);
 int LListIsEmpty(LList_Node *root);
 LList_Node *LListAdd(LList_Node *root, void *node_value);
+LList_Node *LListAppend(LList_Node *tail, void *node_value);
+void *LListRemove(LList_Node *root, LList_Node *prev, LList_Node *node);
 void *LListPop(LList_Node *root, const void *node_value, 
 	int (*CompareValues)(const void *value1, const void *value2));
 void *LListSearch(LList_Node *root, const void *node_value,
@@ -27,10 +48,15 @@ void LListDestroy(LList_Node *root, void (*FreeValue)(void *node_value));
 
 
 /* Other help functions.*/
-int GetNewCoords(int cur_pos, int radius, int size_x, int size_y, Fishery *fishery);
+void SeedRNG(Fishery_RNG *rng, unsigned long long seed);
+int NextRNG(Fishery_RNG *rng);
+long long GenerateRandLong(long long a, long long b);
+long long *GenerateRandSample(long long n, long long k);
+long long GetNewCoords(long long cur_pos, int radius, int size_x, int size_y, Fishery *fishery);
 int ComparePointers(const void *ptr1, const void *ptr2);
 int CompareFisheries(const void *fishery1, const void *fishery2);
 int CompareInts(const void *int1, const void *int2);
+double GetTimeSeconds(void);
 
-#endif /* HELP_FUNCTIONS_H */
+#endif /* HELP_FUNCTIONS_H_ */
 
@@ -0,0 +1,379 @@
+// fishery_batch.c : Command-line batch runner for parameter sweeps.
+//
+// Reads the settings of a fishery from a settings file and a sweep from a
+// sweep file, and runs every combination of the swept settings with a number
+// of seeds. Jobs are divided between worker processes and the results are
+// streamed to the standard output as CSV or as binary records.
+//
+// Usage: fishery_batch [-j workers] [-b] settings_file sweep_file
+//
+// Settings file: one setting per line, the name followed by its value(s),
+// e.g. "fish_consumption 0 1 2 3 4 5". Lines starting with # are ignored.
+// All settings of MASTER_SETTING_LIST must be present.
+//
+// Sweep file: lines "steps n", "seeds n" (runs per combination), "seed n"
+// (seed of the first job, job i uses seed + i) and any number of lines with
+// an integer setting followed by the values to sweep, e.g.
+// "fishing_chance 0 5 10". Settings which determine the size of a list
+// cannot be swept.
+//
+// Binary output (-b) is a sequence of native Batch_Record structures.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+#include "fishery_data_types.h"
+#include "fishery_functions.h"
+#include "fishery_settings.h"
+#include "help_functions.h"
+
+#define BATCH_LINE_MAX 4096
+#define BATCH_VALUES_MAX 128
+#define BATCH_SWEEP_MAX 17
+
+extern const char *MASTER_SETTING_LIST[17][3];
+extern const int SETTINGS_SIZE;
+
+/* Setting swept over a list of values. */
+typedef struct batch_sweep
+{
+	int setting;				/* Index in MASTER_SETTING_LIST. */
+	int values[BATCH_VALUES_MAX];
+	int n_values;
+} Batch_Sweep;
+/* Stores sweep specification. */
+typedef struct batch_spec
+{
+	Batch_Sweep sweeps[BATCH_SWEEP_MAX];
+	int n_sweeps;
+	long long steps;
+	long long seeds;
+	long long first_seed;
+	long long n_jobs;
+} Batch_Spec;
+/* Binary output record of one job. */
+typedef struct batch_record
+{
+	long long job;
+	long long seed;
+	int values[BATCH_SWEEP_MAX];	/* Values of swept settings, in sweep order. */
+	Fishery_Results results;
+} Batch_Record;
+
+/* Function: FindSetting
+ * ---------------------
+ * Returns index of setting in MASTER_SETTING_LIST, -1 if not found.
+ */
+static int FindSetting(const char *name) {
+	int i;
+
+	for (i = 0; i < SETTINGS_SIZE; i++) {
+		if (strcmp(MASTER_SETTING_LIST[i][0], name) == 0)
+			return i;
+	}
+	return -1;
+}
+/* Function: ReadValues
+ * --------------------
+ * Splits line into name and integer values.
+ *
+ * *line:		Line to split, modified.
+ * **name:		Set to name at the start of line, NULL for empty lines.
+ * *values:		Values after name.
+ *
+ * Returns:		Amount of values, -1 if a value is not an integer.
+ */
+static int ReadValues(char *line, char **name, int *values) {
+	char *token, *end;
+	int n = 0;
+
+	*name = strtok(line, " \t\r\n");
+	if (*name == NULL || (*name)[0] == '#') {
+		*name = NULL;
+		return 0;
+	}
+	while ((token = strtok(NULL, " \t\r\n")) != NULL && n < BATCH_VALUES_MAX) {
+		values[n++] = (int)strtol(token, &end, 10);
+		if (*end != '\0')
+			return -1;
+	}
+	return n;
+}
+/* Function: ReadSettings
+ * ----------------------
+ * Reads settings file. Settings are added in the order of
+ * MASTER_SETTING_LIST, so list sizes are known before the lists.
+ *
+ * *path:		Path of settings file.
+ * *settings:	Settings to fill.
+ *
+ * Returns:		1 if all settings were read, 0 otherwise.
+ */
+static int ReadSettings(const char *path, Fishery_Settings *settings) {
+	static int values[17][BATCH_VALUES_MAX];
+	int line_values[BATCH_VALUES_MAX], n_values[17], i, n, setting, size;
+	char line[BATCH_LINE_MAX], *name;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Failed to open settings file %s.\n", path);
+		return 0;
+	}
+	for (i = 0; i < SETTINGS_SIZE; i++)
+		n_values[i] = 0;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		n = ReadValues(line, &name, line_values);
+		if (name == NULL)
+			continue;
+		setting = FindSetting(name);
+		if (setting == -1 || n <= 0) {
+			fprintf(stderr, "Invalid setting line for %s.\n", name);
+			fclose(file);
+			return 0;
+		}
+		memcpy(values[setting], line_values, sizeof(int)*n);
+		n_values[setting] = n;
+	}
+	fclose(file);
+	memset(settings, 0, sizeof(Fishery_Settings));
+	for (i = 0; i < SETTINGS_SIZE; i++) {
+		if (n_values[i] == 0) {
+			fprintf(stderr, "Setting %s missing.\n", MASTER_SETTING_LIST[i][0]);
+			return 0;
+		}
+		if (strcmp(MASTER_SETTING_LIST[i][1], "list") == 0) {
+			size = values[FindSetting(MASTER_SETTING_LIST[i][2])][0] + 1;
+			if (size != n_values[i]) {
+				fprintf(stderr, "Setting %s should have %d values.\n", MASTER_SETTING_LIST[i][0], size);
+				return 0;
+			}
+		}
+		if (!AddSetting(settings, MASTER_SETTING_LIST[i][0], values[i]))
+			return 0;
+	}
+	return 1;
+}
+/* Function: ReadSpec
+ * ------------------
+ * Reads sweep file.
+ *
+ * *path:	Path of sweep file.
+ * *spec:	Sweep specification to fill.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int ReadSpec(const char *path, Batch_Spec *spec) {
+	int values[BATCH_VALUES_MAX], i, n, setting;
+	char line[BATCH_LINE_MAX], *name;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Failed to open sweep file %s.\n", path);
+		return 0;
+	}
+	spec->n_sweeps = 0;
+	spec->steps = 100;
+	spec->seeds = 1;
+	spec->first_seed = 1;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		n = ReadValues(line, &name, values);
+		if (name == NULL)
+			continue;
+		if (n <= 0) {
+			fprintf(stderr, "Invalid sweep line for %s.\n", name);
+			fclose(file);
+			return 0;
+		}
+		if (strcmp(name, "steps") == 0)
+			spec->steps = values[0];
+		else if (strcmp(name, "seeds") == 0)
+			spec->seeds = values[0];
+		else if (strcmp(name, "seed") == 0)
+			spec->first_seed = values[0];
+		else {
+			setting = FindSetting(name);
+			for (i = 0; setting != -1 && i < SETTINGS_SIZE; i++) {
+				if (strcmp(MASTER_SETTING_LIST[i][2], name) == 0)
+					setting = -1;
+			}
+			if (setting == -1 || strcmp(MASTER_SETTING_LIST[setting][1], "int") != 0 ||
+				spec->n_sweeps == BATCH_SWEEP_MAX) {
+				fprintf(stderr, "Setting %s cannot be swept.\n", name);
+				fclose(file);
+				return 0;
+			}
+			spec->sweeps[spec->n_sweeps].setting = setting;
+			memcpy(spec->sweeps[spec->n_sweeps].values, values, sizeof(int)*n);
+			spec->sweeps[spec->n_sweeps].n_values = n;
+			spec->n_sweeps++;
+		}
+	}
+	fclose(file);
+	if (spec->steps < 0 || spec->seeds < 1) {
+		fprintf(stderr, "Invalid steps or seeds.\n");
+		return 0;
+	}
+	spec->n_jobs = spec->seeds;
+	for (i = 0; i < spec->n_sweeps; i++)
+		spec->n_jobs *= spec->sweeps[i].n_values;
+	return 1;
+}
+/* Function: RunJob
+ * ----------------
+ * Runs job of sweep. The combination of swept values is job / seeds, the
+ * last swept setting changing fastest.
+ *
+ * settings:	Base settings.
+ * *spec:		Sweep specification.
+ * job:			Index of job.
+ * *record:		Filled with results of job.
+ *
+ * Returns:		1 if successful, 0 if settings of job are invalid.
+ */
+static int RunJob(Fishery_Settings settings, const Batch_Spec *spec,
+	long long job, Batch_Record *record) {
+	Fishery *fishery;
+	long long combination = job / spec->seeds;
+	int i;
+
+	memset(record, 0, sizeof(Batch_Record));
+	record->job = job;
+	record->seed = spec->first_seed + job;
+	for (i = spec->n_sweeps - 1; i >= 0; i--) {
+		record->values[i] = spec->sweeps[i].values[combination % spec->sweeps[i].n_values];
+		combination /= spec->sweeps[i].n_values;
+		AddSetting(&settings, MASTER_SETTING_LIST[spec->sweeps[i].setting][0],
+			&record->values[i]);
+	}
+	if (!ValidateSettings(settings, 0))
+		return 0;
+	srand((unsigned int)record->seed);
+	fishery = CreateFishery(settings);
+	record->results = UpdateFishery(fishery, settings, spec->steps);
+	DestroyFishery(fishery);
+	return 1;
+}
+/* Function: WriteRecord
+ * ---------------------
+ * Writes record to the standard output and flushes it at once. Records are
+ * smaller than the stdio buffer and PIPE_BUF, so records of parallel 
+ * workers are not interleaved.
+ */
+static void WriteRecord(const Batch_Record *record, const Batch_Spec *spec, int binary) {
+	char line[BATCH_LINE_MAX];
+	const Fishery_Results *results = &record->results;
+	const Fishery_Events *events = &record->results.events;
+	int i, n;
+
+	if (binary) {
+		fwrite(record, sizeof(Batch_Record), 1, stdout);
+		fflush(stdout);
+		return;
+	}
+	n = sprintf(line, "%lld,%lld", record->job, record->seed);
+	for (i = 0; i < spec->n_sweeps; i++)
+		n += sprintf(line + n, ",%d", record->values[i]);
+	n += sprintf(line + n, ",%lld,%lld,%lld,%lld,%.9g,%.9g,%.9g,%lld,%lld,%lld,%lld,%lld,%lld,%lld\n",
+		results->steps, results->fish_n, results->yield, results->vegetation_n,
+		results->fish_n_std_dev, results->yield_std_dev, results->vegetation_n_std_dev,
+		events->moves, events->failed_moves, events->splits, events->failed_splits,
+		events->starvation_deaths, events->fishing_deaths, events->spawns);
+	fwrite(line, 1, n, stdout);
+	fflush(stdout);
+}
+/* Function: RunWorker
+ * -------------------
+ * Runs jobs worker, worker + workers, worker + 2*workers, ...
+ *
+ * Returns:	Amount of jobs with invalid settings.
+ */
+static int RunWorker(Fishery_Settings settings, const Batch_Spec *spec,
+	int worker, int workers, int binary) {
+	Batch_Record record;
+	long long job;
+	int failed = 0;
+
+	for (job = worker; job < spec->n_jobs; job += workers) {
+		if (RunJob(settings, spec, job, &record))
+			WriteRecord(&record, spec, binary);
+		else {
+			fprintf(stderr, "Job %lld has invalid settings.\n", job);
+			failed++;
+		}
+	}
+	return failed;
+}
+
+int main(int argc, char *argv[]) {
+	Fishery_Settings settings;
+	Batch_Spec spec;
+	int i, workers = 1, binary = 0, failed = 0, status;
+	const char *settings_path = NULL, *spec_path = NULL;
+#ifndef _WIN32
+	pid_t pid;
+#endif
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			workers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-b") == 0)
+			binary = 1;
+		else if (settings_path == NULL)
+			settings_path = argv[i];
+		else
+			spec_path = argv[i];
+	}
+	if (settings_path == NULL || spec_path == NULL || workers < 1) {
+		fprintf(stderr, "Usage: %s [-j workers] [-b] settings_file sweep_file\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	/* Messages of the settings functions are printed to the standard
+	   output, keep them out of the results. */
+	if (!ReadSettings(settings_path, &settings) || !ReadSpec(spec_path, &spec) ||
+		!ValidateSettings(settings, 0)) {
+		fprintf(stderr, "Invalid settings or sweep file.\n");
+		return EXIT_FAILURE;
+	}
+	if (!binary) {
+		printf("job,seed");
+		for (i = 0; i < spec.n_sweeps; i++)
+			printf(",%s", MASTER_SETTING_LIST[spec.sweeps[i].setting][0]);
+		printf(",steps,fish_n,yield,vegetation_n,fish_n_std_dev,yield_std_dev,"
+			"vegetation_n_std_dev,moves,failed_moves,splits,failed_splits,"
+			"starvation_deaths,fishing_deaths,spawns\n");
+	}
+	fflush(stdout);
+#ifndef _WIN32
+	if (workers > 1) {
+		for (i = 0; i < workers; i++) {
+			pid = fork();
+			if (pid == 0)
+				_exit(RunWorker(settings, &spec, i, workers, binary) ? EXIT_FAILURE : EXIT_SUCCESS);
+			if (pid == -1) {
+				/* Run the jobs of the worker here, so no rows are missing. */
+				fprintf(stderr, "Failed to fork worker %d, running its jobs in this process.\n", i);
+				if (RunWorker(settings, &spec, i, workers, binary))
+					failed = 1;
+			}
+		}
+		while (wait(&status) > 0) {
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+				failed = 1;
+		}
+	}
+	else
+#endif
+	failed = RunWorker(settings, &spec, 0, 1, binary);
+	free(settings.vegetation_consumption);
+	free(settings.fish_consumption);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
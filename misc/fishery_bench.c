@@ -0,0 +1,182 @@
+// fishery_bench.c : Benchmark of the phases of the fishery simulation.
+//
+// Sweeps grid size, fish density and fishing pressure and measures the time
+// spent in CreateFishery, UpdateFisheryVegetation, UpdateFisheryFishPopulation,
+// FishingEvent and GetNewCoords. The results are written to the standard
+// output as JSON.
+//
+// Usage: fishery_bench [repetitions] [warmup] [steps]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "fishery_data_types.h"
+#include "fishery_functions.h"
+#include "fishery_settings.h"
+#include "help_functions.h"
+
+#define BENCH_PHASES 5
+#define BENCH_COORDS_CALLS 10000
+
+static const char *BENCH_PHASE_NAMES[BENCH_PHASES] = { "CreateFishery",
+	"UpdateFisheryVegetation", "UpdateFisheryFishPopulation", "FishingEvent",
+	"GetNewCoords" };
+static const int BENCH_SIZES[] = { 32, 128, 512 };
+static const double BENCH_FISH_DENSITIES[] = { 0.01, 0.05, 0.2 };
+static const int BENCH_FISHING_CHANCES[] = { 0, 10, 40 };
+
+/* Function: CompareDoubles
+ * ------------------------
+ * Compares doubles for qsort.
+ */
+static int CompareDoubles(const void *double1, const void *double2) {
+	double a = *(const double *)double1, b = *(const double *)double2;
+
+	return (a > b) - (a < b);
+}
+/* Function: PrintTimes
+ * --------------------
+ * Prints minimum, median and mean of times as a JSON object. Sorts times.
+ *
+ * *name:	Name of measured function.
+ * *times:	Seconds per call of each repetition.
+ * n:		Number of repetitions.
+ */
+static void PrintTimes(const char *name, double *times, int n) {
+	double sum = 0;
+	int i;
+
+	qsort(times, n, sizeof(double), CompareDoubles);
+	for (i = 0; i < n; i++)
+		sum += times[i];
+	printf("\"%s\": {\"min\": %.9e, \"median\": %.9e, \"mean\": %.9e}",
+		name, times[0], n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2,
+		sum / n);
+}
+/* Function: BenchPoint
+ * --------------------
+ * Measures phases for settings. Each repetition creates a new fishery and
+ * progresses it steps steps, warmup repetitions are not recorded.
+ *
+ * settings:	Settings of fishery.
+ * repetitions:	Number of recorded repetitions.
+ * warmup:		Number of repetitions before recording.
+ * steps:		Steps per repetition.
+ * **times:		Seconds per call, for each phase and repetition.
+ *
+ * Returns:		Amount of fish pools after the last repetition.
+ */
+static long long BenchPoint(Fishery_Settings settings, int repetitions,
+	int warmup, int steps, double **times) {
+	Fishery *fishery;
+	LList_Node *node;
+	double start, phase_times[BENCH_PHASES];
+	long long fish_n = 0, n_cells = (long long)settings.size_x*settings.size_y;
+	int i, j, rep;
+
+	for (rep = 0; rep < warmup + repetitions; rep++) {
+		srand((unsigned int)rep + 1);
+		for (i = 0; i < BENCH_PHASES; i++)
+			phase_times[i] = 0;
+		start = GetTimeSeconds();
+		fishery = CreateFishery(settings);
+		phase_times[0] = GetTimeSeconds() - start;
+		for (j = 0; j < steps; j++) {
+			start = GetTimeSeconds();
+			UpdateFisheryVegetation(fishery, settings);
+			phase_times[1] += GetTimeSeconds() - start;
+			start = GetTimeSeconds();
+			UpdateFisheryFishPopulation(fishery, settings);
+			phase_times[2] += GetTimeSeconds() - start;
+			start = GetTimeSeconds();
+			FishingEvent(fishery, settings);
+			phase_times[3] += GetTimeSeconds() - start;
+		}
+		start = GetTimeSeconds();
+		for (j = 0; j < BENCH_COORDS_CALLS; j++)
+			GetNewCoords(GenerateRandLong(0, n_cells - 1), 1,
+				settings.size_x, settings.size_y, fishery);
+		phase_times[4] = GetTimeSeconds() - start;
+		if (rep >= warmup) {
+			times[0][rep - warmup] = phase_times[0];
+			for (i = 1; i < 4; i++)
+				times[i][rep - warmup] = steps > 0 ? phase_times[i] / steps : 0;
+			times[4][rep - warmup] = phase_times[4] / BENCH_COORDS_CALLS;
+		}
+		fish_n = 0;
+		for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+			fish_n++;
+		DestroyFishery(fishery);
+	}
+	return fish_n;
+}
+
+int main(int argc, char *argv[]) {
+	Fishery_Settings settings;
+	double *times[BENCH_PHASES];
+	long long fish_n;
+	int vegetation_consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	int i, j, k, phase, first = 1, repetitions = 5, warmup = 1, steps = 10;
+
+	if (argc > 1)
+		repetitions = atoi(argv[1]);
+	if (argc > 2)
+		warmup = atoi(argv[2]);
+	if (argc > 3)
+		steps = atoi(argv[3]);
+	if (repetitions < 1 || warmup < 0 || steps < 0) {
+		printf("Usage: %s [repetitions] [warmup] [steps]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	for (phase = 0; phase < BENCH_PHASES; phase++) {
+		times[phase] = malloc(sizeof(double)*repetitions);
+		if (times[phase] == NULL)
+			return EXIT_FAILURE;
+	}
+
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = vegetation_consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 10;
+
+	printf("{\"benchmark\": \"fishery_phases\", \"repetitions\": %d, \"warmup\": %d, "
+		"\"steps\": %d, \"results\": [\n", repetitions, warmup, steps);
+	for (i = 0; i < (int)(sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0])); i++) {
+		for (j = 0; j < (int)(sizeof(BENCH_FISH_DENSITIES) / sizeof(BENCH_FISH_DENSITIES[0])); j++) {
+			for (k = 0; k < (int)(sizeof(BENCH_FISHING_CHANCES) / sizeof(BENCH_FISHING_CHANCES[0])); k++) {
+				settings.size_x = BENCH_SIZES[i];
+				settings.size_y = BENCH_SIZES[i];
+				settings.initial_vegetation_size = BENCH_SIZES[i] * BENCH_SIZES[i] / 4;
+				settings.initial_fish_size = (int)(BENCH_FISH_DENSITIES[j] *
+					BENCH_SIZES[i] * BENCH_SIZES[i]);
+				settings.fishing_chance = BENCH_FISHING_CHANCES[k];
+				if (!ValidateSettings(settings, 1))
+					return EXIT_FAILURE;
+				fish_n = BenchPoint(settings, repetitions, warmup, steps, times);
+
+				printf("%s{\"size_x\": %d, \"size_y\": %d, \"fish_density\": %g, "
+					"\"fishing_chance\": %d, \"fish_n\": %lld, \"phases\": {",
+					first ? "" : ",\n", settings.size_x, settings.size_y,
+					BENCH_FISH_DENSITIES[j], settings.fishing_chance, fish_n);
+				for (phase = 0; phase < BENCH_PHASES; phase++) {
+					PrintTimes(BENCH_PHASE_NAMES[phase], times[phase], repetitions);
+					printf(phase < BENCH_PHASES - 1 ? ", " : "}}");
+				}
+				fflush(stdout);
+				first = 0;
+			}
+		}
+	}
+	printf("\n]}\n");
+	for (phase = 0; phase < BENCH_PHASES; phase++)
+		free(times[phase]);
+	return EXIT_SUCCESS;
+}
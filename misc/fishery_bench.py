@@ -0,0 +1,97 @@
+"""Benchmark of the Python interface of the fishery simulation.
+
+Sweeps grid size, fish density and fishing pressure and measures the time
+spent in the MPy* functions of the fishery module. The results are written
+to the standard output as JSON, laid out like the output of fishery_bench.c.
+
+Usage: python3 fishery_bench.py [repetitions] [warmup] [steps]
+"""
+import json
+import statistics
+import sys
+import time
+
+import fishery
+
+SIZES = [32, 128, 512]
+FISH_DENSITIES = [0.01, 0.05, 0.2]
+FISHING_CHANCES = [0, 10, 40]
+
+
+def make_settings(size, fish_density, fishing_chance):
+    return {"size_x": size, "size_y": size,
+            "initial_vegetation_size": size * size // 4,
+            "vegetation_level_max": 5, "vegetation_level_spread_at": 3,
+            "vegetation_level_growth_req": 3, "soil_energy_max": 10,
+            "soil_energy_increase_turn": 3,
+            "vegetation_consumption": [0, 1, 1, 2, 2, 3],
+            "initial_fish_size": int(fish_density * size * size),
+            "fish_level_max": 5, "fish_growth_req": 1, "fish_moves_turn": 5,
+            "fish_consumption": [0, 1, 2, 3, 4, 5],
+            "random_fishes_interval": 10, "split_fishes_at_max": 1,
+            "fishing_chance": fishing_chance}
+
+
+def timed(function, *args):
+    start = time.perf_counter()
+    result = function(*args)
+    return time.perf_counter() - start, result
+
+
+def bench_point(settings, repetitions, warmup, steps):
+    """Returns seconds per call of each function and repetition."""
+    times = {"MPyCreateFishery": [], "MPyUpdateFishery": [],
+             "MPyGetFisheryVegetation": [], "MPyGetFisheryFishPopulation": [],
+             "MPyDestroyFishery": []}
+    fish_n = 0
+    for rep in range(warmup + repetitions):
+        fishery.MPySetRNGSeed(rep + 1)
+        elapsed = {}
+        elapsed["MPyCreateFishery"], fishery_id = timed(
+            fishery.MPyCreateFishery, settings)
+        elapsed["MPyUpdateFishery"], _ = timed(
+            fishery.MPyUpdateFishery, fishery_id, steps)
+        elapsed["MPyUpdateFishery"] /= max(steps, 1)
+        elapsed["MPyGetFisheryVegetation"], _ = timed(
+            fishery.MPyGetFisheryVegetation, fishery_id)
+        elapsed["MPyGetFisheryFishPopulation"], fish = timed(
+            fishery.MPyGetFisheryFishPopulation, fishery_id)
+        elapsed["MPyDestroyFishery"], _ = timed(
+            fishery.MPyDestroyFishery, fishery_id)
+        fish_n = 0 if fish == [-1] else len(fish)
+        if rep >= warmup:
+            for name in times:
+                times[name].append(elapsed[name])
+    return times, fish_n
+
+
+def main(argv):
+    repetitions, warmup, steps = 5, 1, 10
+    if len(argv) > 1:
+        repetitions = int(argv[1])
+    if len(argv) > 2:
+        warmup = int(argv[2])
+    if len(argv) > 3:
+        steps = int(argv[3])
+    results = []
+    for size in SIZES:
+        for fish_density in FISH_DENSITIES:
+            for fishing_chance in FISHING_CHANCES:
+                settings = make_settings(size, fish_density, fishing_chance)
+                times, fish_n = bench_point(settings, repetitions, warmup, steps)
+                results.append({
+                    "size_x": size, "size_y": size,
+                    "fish_density": fish_density,
+                    "fishing_chance": fishing_chance, "fish_n": fish_n,
+                    "functions": {name: {"min": min(values),
+                                         "median": statistics.median(values),
+                                         "mean": statistics.mean(values)}
+                                  for name, values in times.items()}})
+    json.dump({"benchmark": "fishery_python", "repetitions": repetitions,
+               "warmup": warmup, "steps": steps, "results": results},
+              sys.stdout, indent=1)
+    print()
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,208 @@
+// fishery_diff.c : Differential test of the engine against the reference engine.
+//
+// Runs fisheries with randomized, valid settings on the engine and on the
+// reference engine (see fishery_reference.c) from identical seeds, and
+// compares the full state of the fisheries and the totals of the steps every
+// few steps. Each trial is run in every configuration of layout and random
+// number stream. Reports the mismatches and the time spent by both engines,
+// i.e. the speedup of the engine, for each configuration as JSON to the
+// standard output. Exits with failure if any state differs.
+//
+// A mismatch is reproduced by running its trial seed with a single trial.
+//
+// Usage: fishery_diff [trials] [steps] [every] [seed] [max_size]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "fishery_data_types.h"
+#include "fishery_functions.h"
+#include "fishery_settings.h"
+#include "help_functions.h"
+
+#define DIFF_CONFIGS 4
+#define DIFF_LEVEL_MAX 10
+
+static const int DIFF_LAYOUTS[DIFF_CONFIGS] = { FISHERY_LAYOUT_COLUMNS,
+	FISHERY_LAYOUT_COLUMNS, FISHERY_LAYOUT_TILED, FISHERY_LAYOUT_TILED };
+static const int DIFF_PRIVATE_RNG[DIFF_CONFIGS] = { 0, 1, 0, 1 };
+
+/* Measurements of a configuration. */
+typedef struct diff_config
+{
+	long long steps;
+	int mismatches;
+	unsigned int first_mismatch_seed;
+	long long first_mismatch_step;
+	double reference_time;
+	double engine_time;
+} Diff_Config;
+
+/* Function: RandomSettings
+ * ------------------------
+ * Draws random settings with rand() until they pass ValidateSettings.
+ *
+ * *settings:				Settings to set.
+ * *vegetation_consumption:	Array of DIFF_LEVEL_MAX + 1 integers for the
+ *							vegetation consumption of settings.
+ * *fish_consumption:		Array of DIFF_LEVEL_MAX + 1 integers for the
+ *							fish consumption of settings.
+ * max_size:				Largest width and height of the vegetation layer.
+ */
+static void RandomSettings(Fishery_Settings *settings, int *vegetation_consumption,
+	int *fish_consumption, int max_size) {
+	int i, n_cells;
+
+	do {
+		settings->size_x = GENERATERANDINT(1, max_size);
+		settings->size_y = GENERATERANDINT(1, max_size);
+		n_cells = settings->size_x*settings->size_y;
+		settings->initial_vegetation_size = GENERATERANDINT(0, n_cells);
+		settings->vegetation_level_max = GENERATERANDINT(1, DIFF_LEVEL_MAX);
+		/* Spreading at a level above the maximum never spreads. */
+		settings->vegetation_level_spread_at = GENERATERANDINT(0,
+			settings->vegetation_level_max + 1);
+		settings->vegetation_level_growth_req = GENERATERANDINT(0, 5);
+		settings->soil_energy_max = GENERATERANDINT(0, 30);
+		settings->soil_energy_increase_turn = GENERATERANDINT(0, 10);
+		for (i = 0; i <= DIFF_LEVEL_MAX; i++)
+			vegetation_consumption[i] = i == 0 ? 0 : GENERATERANDINT(0, i);
+		settings->vegetation_consumption = vegetation_consumption;
+
+		settings->initial_fish_size = GENERATERANDINT(0, n_cells / 4);
+		settings->fish_level_max = GENERATERANDINT(1, DIFF_LEVEL_MAX);
+		settings->fish_growth_req = GENERATERANDINT(0, 5);
+		settings->fish_moves_turn = GENERATERANDINT(0, 8);
+		for (i = 0; i <= DIFF_LEVEL_MAX; i++)
+			fish_consumption[i] = i == 0 ? 0 : GENERATERANDINT(0, i + 1);
+		settings->fish_consumption = fish_consumption;
+
+		settings->random_fishes_interval = GENERATERANDINT(0, 1) ? GENERATERANDINT(1, 150) : 0;
+		settings->split_fishes_at_max = GENERATERANDINT(0, 1);
+		settings->fishing_chance = GENERATERANDINT(0, 30);
+	} while (!ValidateSettings(*settings, 0));
+}
+/* Function: CreateDiffFishery
+ * ---------------------------
+ * Creates fishery of a trial for the engine or the reference engine.
+ *
+ * Returns:	Pointer to fishery, NULL if it could not be created.
+ */
+static Fishery *CreateDiffFishery(Fishery_Settings settings, unsigned int seed,
+	int layout, int private_rng) {
+	Fishery *fishery;
+
+	srand(seed);
+	fishery = CreateFishery(settings);
+	if (fishery == NULL)
+		return NULL;
+	if (layout != FISHERY_LAYOUT_COLUMNS && !SetFisheryLayout(fishery, layout)) {
+		DestroyFishery(fishery);
+		return NULL;
+	}
+	if (private_rng)
+		SeedFisheryRNG(fishery, seed);
+	return fishery;
+}
+/* Function: RunTrial
+ * ------------------
+ * Runs a trial in a configuration on both engines, comparing the state
+ * and the totals of the steps every every steps. Records the first
+ * mismatch of the configuration.
+ *
+ * Returns:	1 if the engines agree, 0 otherwise.
+ */
+static int RunTrial(Fishery_Settings settings, unsigned int seed, int config,
+	int steps, int every, Diff_Config *diff) {
+	Fishery *reference, *engine;
+	Fishery_Results results;
+	Fishery_Step step;
+	long long fish_n, yield, vegetation_n;
+	double start;
+	int i, j, n, equal;
+
+	reference = CreateDiffFishery(settings, seed, FISHERY_LAYOUT_COLUMNS, DIFF_PRIVATE_RNG[config]);
+	engine = CreateDiffFishery(settings, seed, DIFF_LAYOUTS[config], DIFF_PRIVATE_RNG[config]);
+	equal = reference != NULL && engine != NULL &&
+		CompareFisheryState(reference, engine, settings, 0);
+	for (i = 0; i < steps && equal; i += n) {
+		n = steps - i < every ? steps - i : every;
+		/* Both engines draw from the same rand() sequence. */
+		srand(seed + i + 1);
+		fish_n = yield = vegetation_n = 0;
+		start = GetTimeSeconds();
+		for (j = 0; j < n; j++) {
+			step = ReferenceStepFishery(reference, settings);
+			fish_n += step.fish_n;
+			yield += step.yield;
+			vegetation_n += step.vegetation_n;
+		}
+		diff->reference_time += GetTimeSeconds() - start;
+		srand(seed + i + 1);
+		start = GetTimeSeconds();
+		results = UpdateFishery(engine, settings, n);
+		diff->engine_time += GetTimeSeconds() - start;
+		diff->steps += n;
+		equal = results.fish_n == fish_n && results.yield == yield &&
+			results.vegetation_n == vegetation_n &&
+			CompareFisheryState(reference, engine, settings, 0);
+	}
+	if (!equal && diff->mismatches++ == 0) {
+		diff->first_mismatch_seed = seed;
+		diff->first_mismatch_step = i;
+	}
+	if (reference != NULL)
+		DestroyFishery(reference);
+	if (engine != NULL)
+		DestroyFishery(engine);
+	return equal;
+}
+
+int main(int argc, char *argv[]) {
+	Fishery_Settings settings;
+	Diff_Config diffs[DIFF_CONFIGS] = { { 0 } };
+	int vegetation_consumption[DIFF_LEVEL_MAX + 1], fish_consumption[DIFF_LEVEL_MAX + 1];
+	int trial, config, trials = 20, steps = 200, every = 10, max_size = 96, failed = 0;
+	unsigned int seed = 1, trial_seed;
+
+	if (argc > 1)
+		trials = atoi(argv[1]);
+	if (argc > 2)
+		steps = atoi(argv[2]);
+	if (argc > 3)
+		every = atoi(argv[3]);
+	if (argc > 4)
+		seed = (unsigned int)strtoul(argv[4], NULL, 10);
+	if (argc > 5)
+		max_size = atoi(argv[5]);
+	if (trials < 1 || steps < 0 || every < 1 || max_size < 1) {
+		printf("Usage: %s [trials] [steps] [every] [seed] [max_size]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (trial = 0; trial < trials; trial++) {
+		/* Seeds of the trials are far apart, the chunks of a trial use the
+		   following seeds. */
+		trial_seed = seed + (unsigned int)trial*(unsigned int)(steps + 1);
+		srand(trial_seed);
+		RandomSettings(&settings, vegetation_consumption, fish_consumption, max_size);
+		for (config = 0; config < DIFF_CONFIGS; config++)
+			failed |= !RunTrial(settings, trial_seed, config, steps, every, &diffs[config]);
+	}
+
+	printf("{\"benchmark\": \"fishery_diff\", \"trials\": %d, \"steps\": %d, \"every\": %d, "
+		"\"seed\": %u, \"max_size\": %d, \"results\": [\n", trials, steps, every, seed, max_size);
+	for (config = 0; config < DIFF_CONFIGS; config++) {
+		printf("{\"layout\": \"%s\", \"private_rng\": %d, \"steps\": %lld, \"mismatches\": %d, ",
+			FISHERY_LAYOUT_NAMES[DIFF_LAYOUTS[config]], DIFF_PRIVATE_RNG[config],
+			diffs[config].steps, diffs[config].mismatches);
+		if (diffs[config].mismatches > 0)
+			printf("\"first_mismatch\": {\"seed\": %u, \"step\": %lld}, ",
+				diffs[config].first_mismatch_seed, diffs[config].first_mismatch_step);
+		printf("\"reference_seconds\": %.9e, \"engine_seconds\": %.9e, \"speedup\": %.3f}%s\n",
+			diffs[config].reference_time, diffs[config].engine_time,
+			diffs[config].engine_time > 0 ? diffs[config].reference_time / diffs[config].engine_time : 0.0,
+			config < DIFF_CONFIGS - 1 ? "," : "");
+	}
+	printf("]}\n");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -110,7 +110,7 @@ int main(void)
 			if (fishery) {
 				for (i = 0; i < settings.size_y; i++) {
 					for (j = 0; j < settings.size_x; j++) {
-						printf("%d ", fishery->vegetation_layer[i + j*settings.size_y].vegetation_level);
+						printf("%d ", fishery->vegetation_layer[LayoutIndex(&fishery->layout, j, i)].vegetation_level);
 					}
 					printf("\n");
 				}
@@ -119,8 +119,8 @@ int main(void)
 			if (fishery) {
 				for (i = 0; i < settings.size_y; i++) {
 					for (j = 0; j < settings.size_x; j++) {
-						if (fishery->vegetation_layer[i + j*settings.size_y].local_fish) {
-							printf("%d ", fishery->vegetation_layer[i + j*settings.size_y].local_fish->pop_level);
+						if (fishery->vegetation_layer[LayoutIndex(&fishery->layout, j, i)].local_fish) {
+							printf("%d ", fishery->vegetation_layer[LayoutIndex(&fishery->layout, j, i)].local_fish->pop_level);
 						}
 						else
 							printf("0 ");
@@ -133,7 +133,7 @@ int main(void)
 			for (i = 0; i < 100; i++) {
 				fishery = CreateFishery(settings);
 				results = UpdateFishery(fishery, settings, tt);
-				printf("[%d, %d, %d],\n", results.fish_n, results.yield, results.debug_stuff);
+				printf("[%lld, %lld, %lld],\n", results.fish_n, results.yield, results.debug_stuff);
 			}
 			printf("Yield was: %f (%f)\n", (double) results.yield / tt, results.yield_std_dev);
 			printf("Fish pop was: %f (%f)\n", (double)results.fish_n / tt, results.fish_n_std_dev);
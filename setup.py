@@ -5,9 +5,22 @@ include_files = [
  os.path.join(os.getcwd(), "src", "fishery_py_module.c"),
  os.path.join(os.getcwd(), "src", "fishery_functions.c"),
  os.path.join(os.getcwd(), "src", "help_functions.c"),
-os.path.join(os.getcwd(), "src", "fishery_settings.c")]
+os.path.join(os.getcwd(), "src", "fishery_settings.c"),
+os.path.join(os.getcwd(), "src", "fishery_storage.c"),
+os.path.join(os.getcwd(), "src", "fishery_plan.c"),
+os.path.join(os.getcwd(), "src", "fishery_ensemble.c"),
+os.path.join(os.getcwd(), "src", "fishery_layout.c"),
+os.path.join(os.getcwd(), "src", "fishery_index.c"),
+os.path.join(os.getcwd(), "src", "fishery_domain.c"),
+os.path.join(os.getcwd(), "src", "fishery_executor.c"),
+os.path.join(os.getcwd(), "src", "fishery_reference.c")]
 
-fishery_module = Extension('fishery',include_files, include_dirs=[os.path.join(os.getcwd(), "include")])
+# Set FISHERY_PROFILE in the environment to measure the time spent in each
+# phase of the simulation, see MPyGetFisheryProfile.
+define_macros = [("FISHERY_PROFILE", "1")] if os.environ.get("FISHERY_PROFILE") else []
+
+fishery_module = Extension('fishery',include_files, include_dirs=[os.path.join(os.getcwd(), "include")],
+                           define_macros=define_macros)
 
 setup(name='Fishery Simulation', 
       version='1.0', 
@@ -0,0 +1,1270 @@
+/*****************************************************************************
+ * Filename: fishery_domain.c												 *
+ *																			 *
+ * Contains functions for domain-decomposed simulation. The vegetation		 *
+ * layer is split into strips of columns (domains), each updated as a		 *
+ * fishery of its own with halo columns copied from its neighbors. A step	 *
+ * of a domain has three phases:											 *
+ *   1. The owned columns next to each neighbor are sent to the neighbor.	 *
+ *   2. The halo columns are received, the vegetation and the fish			 *
+ *      population of the domain are updated, and the fish pools which		 *
+ *      ended up in the halo are sent to the neighbor owning the tiles,		 *
+ *      together with the vegetation they ate there.						 *
+ *   3. The migrating fish pools of the neighbors are received and placed,	 *
+ *      then random fish pools are spawned and the domain is fished and	 *
+ *      its totals are counted.												 *
+ * Every domain draws its random numbers from a stream seeded from the		 *
+ * seed of the run, the domain and the step, so the results only depend on	 *
+ * the seed and the number of domains, not on the transport or the			 *
+ * processes running the domains.											 *
+ *																			 *
+ *****************************************************************************/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#include "fishery_domain.h"
+#include "fishery_functions.h"
+
+#if !defined(_WIN32) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL		0
+#endif
+/* Bytes read from a socket at a time. */
+#define SOCKET_READ_SIZE	65536
+
+/* Stands in for the fish pools of the neighbors on the tiles of the halo. */
+static Fish_Pool DOMAIN_HALO_FISH;
+
+/* Stores the messages of a link, each message after its size. */
+typedef struct transport_buffer
+{
+	char *data;
+	size_t size;
+	size_t capacity;
+	size_t offset;				/* Bytes already received or sent. */
+} Transport_Buffer;
+/* Stores the state of a transport of CreateLocalTransports. */
+typedef struct local_endpoint
+{
+	Transport_Buffer incoming[2];
+	struct local_endpoint *neighbors[2];
+} Local_Endpoint;
+/* Stores the state of a transport of CreateSocketTransports. */
+typedef struct socket_endpoint
+{
+	int fds[2];					/* -1 without neighbor or after closing. */
+	Transport_Buffer incoming[2];
+	Transport_Buffer outgoing[2];
+} Socket_Endpoint;
+
+/* Function: BufferReserve
+ * -----------------------
+ * Makes room for extra bytes at the end of buffer. Bytes before the offset
+ * are dropped once they make up half of the buffer.
+ *
+ * *buffer:	Buffer of link.
+ * extra:	Bytes to make room for.
+ *
+ * Returns:	1 if successful, 0 if memory could not be reserved.
+ */
+static int BufferReserve(Transport_Buffer *buffer, size_t extra) {
+	size_t capacity;
+	char *data;
+
+	if (buffer->offset > 0 && buffer->offset >= buffer->size / 2) {
+		memmove(buffer->data, buffer->data + buffer->offset, buffer->size - buffer->offset);
+		buffer->size -= buffer->offset;
+		buffer->offset = 0;
+	}
+	if (buffer->size + extra <= buffer->capacity)
+		return 1;
+	capacity = buffer->capacity > 0 ? 2*buffer->capacity : 4096;
+	if (capacity < buffer->size + extra)
+		capacity = buffer->size + extra;
+	data = realloc(buffer->data, capacity);
+	if (data == NULL)
+		return 0;
+	buffer->data = data;
+	buffer->capacity = capacity;
+	return 1;
+}
+/* Function: BufferPut
+ * -------------------
+ * Appends message to buffer.
+ *
+ * *buffer:	Buffer of link.
+ * *data:	Message.
+ * size:	Bytes in message.
+ *
+ * Returns:	1 if successful, 0 if memory could not be reserved.
+ */
+static int BufferPut(Transport_Buffer *buffer, const void *data, size_t size) {
+	if (!BufferReserve(buffer, sizeof(size_t) + size))
+		return 0;
+	memcpy(buffer->data + buffer->size, &size, sizeof(size_t));
+	if (size > 0)
+		memcpy(buffer->data + buffer->size + sizeof(size_t), data, size);
+	buffer->size += sizeof(size_t) + size;
+	return 1;
+}
+/* Function: BufferTake
+ * --------------------
+ * Takes first complete message out of buffer.
+ *
+ * *buffer:	Buffer of link.
+ * *size:	Set to the bytes in message.
+ *
+ * Returns:	Message freed by the caller, NULL if there is no complete message
+ *			or memory could not be reserved.
+ */
+static void *BufferTake(Transport_Buffer *buffer, size_t *size) {
+	void *message;
+
+	if (buffer->size - buffer->offset < sizeof(size_t))
+		return NULL;
+	memcpy(size, buffer->data + buffer->offset, sizeof(size_t));
+	if (buffer->size - buffer->offset - sizeof(size_t) < *size)
+		return NULL;
+	message = malloc(*size > 0 ? *size : 1);
+	if (message == NULL)
+		return NULL;
+	memcpy(message, buffer->data + buffer->offset + sizeof(size_t), *size);
+	buffer->offset += sizeof(size_t) + *size;
+	if (buffer->offset == buffer->size)
+		buffer->offset = buffer->size = 0;
+	return message;
+}
+/* Function: LocalSend
+ * -------------------
+ * Sends message of a local transport, see Fishery_Transport.
+ */
+static int LocalSend(Fishery_Transport *transport, int link, const void *data, size_t size) {
+	Local_Endpoint *endpoint = transport->state;
+
+	if (endpoint->neighbors[link] == NULL) {
+		printf("Domain has no neighbor on link %d.\n", link);
+		return 0;
+	}
+	return BufferPut(&endpoint->neighbors[link]->incoming[1 - link], data, size);
+}
+/* Function: LocalReceive
+ * ----------------------
+ * Receives message of a local transport, see Fishery_Transport. The
+ * message must have been sent before.
+ */
+static void *LocalReceive(Fishery_Transport *transport, int link, size_t *size) {
+	Local_Endpoint *endpoint = transport->state;
+	void *message = BufferTake(&endpoint->incoming[link], size);
+
+	if (message == NULL)
+		printf("No message from neighbor of domain on link %d.\n", link);
+	return message;
+}
+/* Function: LocalDestroy
+ * ----------------------
+ * Frees memory used by a local transport.
+ */
+static void LocalDestroy(Fishery_Transport *transport) {
+	Local_Endpoint *endpoint = transport->state;
+
+	if (endpoint == NULL)
+		return;
+	free(endpoint->incoming[0].data);
+	free(endpoint->incoming[1].data);
+	free(endpoint);
+	transport->state = NULL;
+}
+/* Function: CreateLocalTransports
+ * -------------------------------
+ * Creates transports of domains in the same process. A message is
+ * delivered when it is sent, so all domains must finish a phase of a step
+ * before any domain starts the next phase.
+ *
+ * n_domains:	Number of domains.
+ *
+ * Returns:		Transport of each domain, freed with DestroyTransports. NULL
+ *				if memory could not be reserved.
+ */
+Fishery_Transport *CreateLocalTransports(int n_domains) {
+	Fishery_Transport *transports;
+	Local_Endpoint *endpoint;
+	int i;
+
+	transports = calloc(n_domains, sizeof(Fishery_Transport));
+	if (transports == NULL)
+		return NULL;
+	for (i = 0; i < n_domains; i++) {
+		transports[i].send = LocalSend;
+		transports[i].receive = LocalReceive;
+		transports[i].destroy = LocalDestroy;
+		endpoint = calloc(1, sizeof(Local_Endpoint));
+		transports[i].state = endpoint;
+		if (endpoint == NULL) {
+			DestroyTransports(transports, n_domains);
+			return NULL;
+		}
+		if (i > 0) {
+			endpoint->neighbors[0] = transports[i - 1].state;
+			endpoint->neighbors[0]->neighbors[1] = endpoint;
+		}
+	}
+	return transports;
+}
+#ifndef _WIN32
+/* Function: CloseSocketLink
+ * -------------------------
+ * Closes socket of link, pending messages to the neighbor are dropped.
+ */
+static void CloseSocketLink(Socket_Endpoint *endpoint, int link) {
+	close(endpoint->fds[link]);
+	endpoint->fds[link] = -1;
+	endpoint->outgoing[link].size = endpoint->outgoing[link].offset = 0;
+}
+/* Function: PumpSockets
+ * ---------------------
+ * Waits until a socket of endpoint is ready, then sends pending messages
+ * and receives available bytes on all ready links. Always receiving on
+ * both links keeps the neighbors from blocking on full sockets.
+ *
+ * *endpoint:	State of socket transport.
+ *
+ * Returns:		1 if successful, 0 if no link is open or memory could not be
+ *				reserved.
+ */
+static int PumpSockets(Socket_Endpoint *endpoint) {
+	struct pollfd fds[2];
+	Transport_Buffer *buffer;
+	ssize_t bytes;
+	int links[2], n = 0, i, link;
+
+	for (link = 0; link < 2; link++) {
+		if (endpoint->fds[link] == -1)
+			continue;
+		fds[n].fd = endpoint->fds[link];
+		fds[n].events = POLLIN;
+		if (endpoint->outgoing[link].size > endpoint->outgoing[link].offset)
+			fds[n].events |= POLLOUT;
+		fds[n].revents = 0;
+		links[n++] = link;
+	}
+	if (n == 0)
+		return 0;
+	if (poll(fds, n, -1) == -1)
+		return errno == EINTR;
+	for (i = 0; i < n; i++) {
+		link = links[i];
+		if (fds[i].revents & POLLOUT) {
+			buffer = &endpoint->outgoing[link];
+			bytes = send(fds[i].fd, buffer->data + buffer->offset,
+				buffer->size - buffer->offset, MSG_NOSIGNAL);
+			if (bytes > 0) {
+				buffer->offset += bytes;
+				if (buffer->offset == buffer->size)
+					buffer->offset = buffer->size = 0;
+			}
+			else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				CloseSocketLink(endpoint, link);
+				continue;
+			}
+		}
+		if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+			buffer = &endpoint->incoming[link];
+			if (!BufferReserve(buffer, SOCKET_READ_SIZE))
+				return 0;
+			bytes = read(fds[i].fd, buffer->data + buffer->size, SOCKET_READ_SIZE);
+			if (bytes > 0)
+				buffer->size += bytes;
+			else if (bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+				CloseSocketLink(endpoint, link);
+		}
+	}
+	return 1;
+}
+/* Function: SocketSend
+ * --------------------
+ * Sends message of a socket transport, see Fishery_Transport. The message
+ * is written to the socket while the domain waits for messages.
+ */
+static int SocketSend(Fishery_Transport *transport, int link, const void *data, size_t size) {
+	Socket_Endpoint *endpoint = transport->state;
+
+	if (endpoint->fds[link] == -1) {
+		printf("Domain has no neighbor on link %d.\n", link);
+		return 0;
+	}
+	return BufferPut(&endpoint->outgoing[link], data, size);
+}
+/* Function: SocketReceive
+ * -----------------------
+ * Receives message of a socket transport, see Fishery_Transport. Blocks
+ * until the message has arrived.
+ */
+static void *SocketReceive(Fishery_Transport *transport, int link, size_t *size) {
+	Socket_Endpoint *endpoint = transport->state;
+	void *message;
+
+	while ((message = BufferTake(&endpoint->incoming[link], size)) == NULL) {
+		if (endpoint->fds[link] == -1 || !PumpSockets(endpoint)) {
+			printf("No message from neighbor of domain on link %d.\n", link);
+			return NULL;
+		}
+	}
+	return message;
+}
+/* Function: SocketDestroy
+ * -----------------------
+ * Sends pending messages, then closes the sockets of a socket transport
+ * and frees its memory.
+ */
+static void SocketDestroy(Fishery_Transport *transport) {
+	Socket_Endpoint *endpoint = transport->state;
+	int link;
+
+	if (endpoint == NULL)
+		return;
+	for (;;) {
+		for (link = 0; link < 2; link++) {
+			if (endpoint->fds[link] != -1 &&
+				endpoint->outgoing[link].size > endpoint->outgoing[link].offset)
+				break;
+		}
+		if (link == 2 || !PumpSockets(endpoint))
+			break;
+	}
+	for (link = 0; link < 2; link++) {
+		if (endpoint->fds[link] != -1)
+			close(endpoint->fds[link]);
+		free(endpoint->incoming[link].data);
+		free(endpoint->outgoing[link].data);
+	}
+	free(endpoint);
+	transport->state = NULL;
+}
+#endif
+/* Function: CreateSocketTransports
+ * --------------------------------
+ * Creates transports of domains connected with Unix domain sockets, for
+ * running the domains in separate processes. The sockets are inherited by
+ * processes forked afterwards, each process should destroy the transports
+ * of the domains it does not run.
+ *
+ * n_domains:	Number of domains.
+ *
+ * Returns:		Transport of each domain, freed with DestroyTransports. NULL
+ *				if the sockets could not be created.
+ */
+Fishery_Transport *CreateSocketTransports(int n_domains) {
+#ifndef _WIN32
+	Fishery_Transport *transports;
+	Socket_Endpoint *endpoint;
+	int i, pair[2];
+
+	transports = calloc(n_domains, sizeof(Fishery_Transport));
+	if (transports == NULL)
+		return NULL;
+	for (i = 0; i < n_domains; i++) {
+		transports[i].send = SocketSend;
+		transports[i].receive = SocketReceive;
+		transports[i].destroy = SocketDestroy;
+		endpoint = calloc(1, sizeof(Socket_Endpoint));
+		transports[i].state = endpoint;
+		if (endpoint == NULL) {
+			DestroyTransports(transports, n_domains);
+			return NULL;
+		}
+		endpoint->fds[0] = endpoint->fds[1] = -1;
+		if (i == 0)
+			continue;
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == -1) {
+			printf("Failed to create sockets of domains.\n");
+			DestroyTransports(transports, n_domains);
+			return NULL;
+		}
+		fcntl(pair[0], F_SETFL, fcntl(pair[0], F_GETFL) | O_NONBLOCK);
+		fcntl(pair[1], F_SETFL, fcntl(pair[1], F_GETFL) | O_NONBLOCK);
+		((Socket_Endpoint *)transports[i - 1].state)->fds[1] = pair[0];
+		endpoint->fds[0] = pair[1];
+	}
+	return transports;
+#else
+	printf("Socket transports are not supported on this platform.\n");
+	return NULL;
+#endif
+}
+/* Function: DestroyTransports
+ * ---------------------------
+ * Destroys transports of domains, see CreateLocalTransports.
+ *
+ * *transports:	Transport of each domain.
+ * n_domains:	Number of domains.
+ */
+void DestroyTransports(Fishery_Transport *transports, int n_domains) {
+	int i;
+
+	if (transports == NULL)
+		return;
+	for (i = 0; i < n_domains; i++) {
+		if (transports[i].destroy != NULL)
+			transports[i].destroy(&transports[i]);
+	}
+	free(transports);
+}
+/* Function: MixSeed
+ * -----------------
+ * Returns the splitmix64 finalizer of z.
+ */
+static unsigned long long MixSeed(unsigned long long z) {
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+/* Function: DomainColumns
+ * -----------------------
+ * Sets the columns owned by a domain, domains own nearly equal strips.
+ */
+static void DomainColumns(int size_x, int domain, int n_domains, int *x0, int *x1) {
+	*x0 = (int)((long long)size_x*domain / n_domains);
+	*x1 = (int)((long long)size_x*(domain + 1) / n_domains);
+}
+/* Function: DomainTile
+ * --------------------
+ * Returns tile at column pos_x of the strip of domain, including halo.
+ */
+static Tile *DomainTile(Fishery_Domain *domain, int pos_x, int pos_y) {
+	return &domain->fishery->vegetation_layer[LayoutIndex(&domain->fishery->layout, pos_x, pos_y)];
+}
+/* Function: CreateFisheryDomain
+ * -----------------------------
+ * Creates domain from the state of its columns of fishery. The fish pools
+ * on the halo columns are taken from the neighbors once the domain runs.
+ *
+ * *fishery:	Fishery to decompose. Its toroidal option and move radius
+ *				over one are not supported, the other options are copied.
+ * settings:	Settings of fishery, the consumption lists must outlive the
+ *				domain.
+ * domain:		Index of domain, from the left.
+ * n_domains:	Number of domains, each must own at least FISHERY_DOMAIN_HALO
+ *				columns.
+ * seed:		Seed of the run, shared by all domains.
+ *
+ * Returns:		Pointer to Fishery_Domain, NULL if the domain is invalid or
+ *				memory could not be reserved.
+ */
+Fishery_Domain *CreateFisheryDomain(const Fishery *fishery, Fishery_Settings settings,
+	int domain, int n_domains, unsigned long long seed) {
+	Fishery_Domain *created;
+	LList_Node *node, *tail;
+	Fish_Pool *fish, *created_fish;
+	Tile *tile, *created_tile;
+	int pos_x, pos_y, width;
+
+	if (n_domains < 1 || domain < 0 || domain >= n_domains ||
+		settings.size_x < FISHERY_DOMAIN_HALO*n_domains) {
+		printf("Invalid domain %d of %d domains for %d columns.\n", domain, n_domains,
+			settings.size_x);
+		return NULL;
+	}
+	if (fishery->options.toroidal || fishery->options.move_radius > 1) {
+		printf("Domains do not support the toroidal option or move radius over one.\n");
+		return NULL;
+	}
+	created = calloc(1, sizeof(Fishery_Domain));
+	if (created == NULL)
+		return NULL;
+	created->domain = domain;
+	created->n_domains = n_domains;
+	created->seed = seed;
+	DomainColumns(settings.size_x, domain, n_domains, &created->x0, &created->x1);
+	created->halo_left = domain > 0 ? FISHERY_DOMAIN_HALO : 0;
+	created->halo_right = domain < n_domains - 1 ? FISHERY_DOMAIN_HALO : 0;
+	width = created->x1 - created->x0 + created->halo_left + created->halo_right;
+	created->settings = settings;
+	created->settings.size_x = width;
+	/* The fish update of the strip does not spawn, the domain spawns on
+	   its owned columns with its share of the chance of the fishery, so 
+	   the spawn rate does not depend on the number of domains. */
+	created->settings.random_fishes_interval = 0;
+	created->spawn_probability = settings.random_fishes_interval >= 100 ? 1.0 :
+		settings.random_fishes_interval / 100.0;
+	created->spawn_probability *= (double)(created->x1 - created->x0) / settings.size_x;
+	created->fishery = CreateFisheryEmpty(created->settings);
+	created->halo_vegetation = malloc(sizeof(int)*
+		((created->halo_left + created->halo_right)*settings.size_y + 1));
+	if (created->fishery == NULL || created->halo_vegetation == NULL) {
+		DestroyFisheryDomain(created);
+		return NULL;
+	}
+	/* The state of a progressed fishery is copied as is, e.g. its fish
+	   pools can have negative food levels. */
+	for (pos_x = 0; pos_x < width; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+			tile = &fishery->vegetation_layer[LayoutIndex(&fishery->layout,
+				created->x0 - created->halo_left + pos_x, pos_y)];
+			created_tile = DomainTile(created, pos_x, pos_y);
+			created_tile->vegetation_level = tile->vegetation_level;
+			created_tile->soil_energy = tile->soil_energy;
+		}
+	}
+	tail = created->fishery->fish_list;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next) {
+		fish = node->node_value;
+		if (fish->pos_x < created->x0 || fish->pos_x >= created->x1)
+			continue;
+		created_fish = malloc(sizeof(Fish_Pool));
+		if (created_fish == NULL) {
+			DestroyFisheryDomain(created);
+			return NULL;
+		}
+		*created_fish = *fish;
+		created_fish->pos_x += created->halo_left - created->x0;
+		tail = LListAppend(tail, created_fish);
+		DomainTile(created, created_fish->pos_x, created_fish->pos_y)->local_fish = created_fish;
+	}
+	created->fishery->options = fishery->options;
+	created->fishery->options.private_rng = 1;
+	return created;
+}
+/* Function: SendDomainHalo
+ * ------------------------
+ * First phase of a step, sends the vegetation level, soil energy and
+ * occupation of the owned tiles in the halo of each neighbor.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int SendDomainHalo(Fishery_Domain *domain, Fishery_Transport *transport) {
+	const int size_y = domain->settings.size_y, width = domain->settings.size_x;
+	int *message, link, start, pos_x, pos_y, i, success = 1;
+	Tile *tile;
+
+	message = malloc(sizeof(int)*3*FISHERY_DOMAIN_HALO*size_y);
+	if (message == NULL)
+		return 0;
+	for (link = 0; link < 2 && success; link++) {
+		if ((link == 0 ? domain->halo_left : domain->halo_right) == 0)
+			continue;
+		start = link == 0 ? domain->halo_left : width - domain->halo_right - FISHERY_DOMAIN_HALO;
+		for (pos_x = start, i = 0; pos_x < start + FISHERY_DOMAIN_HALO; pos_x++) {
+			for (pos_y = 0; pos_y < size_y; pos_y++, i += 3) {
+				tile = DomainTile(domain, pos_x, pos_y);
+				message[i] = tile->vegetation_level;
+				message[i + 1] = tile->soil_energy;
+				message[i + 2] = tile->local_fish != NULL;
+			}
+		}
+		success = transport->send(transport, link, message, sizeof(int)*i);
+	}
+	free(message);
+	return success;
+}
+/* Function: UpdateDomainFish
+ * --------------------------
+ * Second phase of a step, receives the halo and updates the vegetation
+ * and fish population of the domain. The fish pools in the halo afterwards
+ * are removed and sent to the neighbors, after the vegetation eaten in the
+ * halo.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int UpdateDomainFish(Fishery_Domain *domain, Fishery_Transport *transport) {
+	const int size_y = domain->settings.size_y, width = domain->settings.size_x;
+	const int halo_tiles = FISHERY_DOMAIN_HALO*size_y;
+	Fishery *fishery = domain->fishery;
+	LList_Node *node, *prev = NULL;
+	Fish_Pool *fish, *migrants[2];
+	Tile *tile;
+	char *messages[2] = { NULL, NULL };
+	int *message, *halo_vegetation, link, start, pos_x, pos_y, i, success = 1;
+	long long n_migrants[2] = { 0, 0 };
+	size_t size;
+
+	for (link = 0; link < 2; link++) {
+		if ((link == 0 ? domain->halo_left : domain->halo_right) == 0)
+			continue;
+		message = transport->receive(transport, link, &size);
+		if (message == NULL || size != sizeof(int)*3*halo_tiles) {
+			printf("Invalid halo of domain %d.\n", domain->domain);
+			free(message);
+			return 0;
+		}
+		start = link == 0 ? 0 : width - domain->halo_right;
+		for (pos_x = start, i = 0; pos_x < start + FISHERY_DOMAIN_HALO; pos_x++) {
+			for (pos_y = 0; pos_y < size_y; pos_y++, i += 3) {
+				tile = DomainTile(domain, pos_x, pos_y);
+				tile->vegetation_level = message[i];
+				tile->soil_energy = message[i + 1];
+				tile->local_fish = message[i + 2] ? &DOMAIN_HALO_FISH : NULL;
+			}
+		}
+		free(message);
+	}
+	UpdateFisheryVegetation(fishery, domain->settings);
+	/* Vegetation of halo is compared after the fish update to find out how
+	   much was eaten there. */
+	for (link = 0; link < 2; link++) {
+		if ((link == 0 ? domain->halo_left : domain->halo_right) == 0)
+			continue;
+		start = link == 0 ? 0 : width - domain->halo_right;
+		halo_vegetation = domain->halo_vegetation + (link == 0 ? 0 : domain->halo_left*size_y);
+		for (pos_x = start; pos_x < start + FISHERY_DOMAIN_HALO; pos_x++) {
+			for (pos_y = 0; pos_y < size_y; pos_y++)
+				*halo_vegetation++ = DomainTile(domain, pos_x, pos_y)->vegetation_level;
+		}
+	}
+	domain->step++;
+	SeedFisheryRNG(fishery, MixSeed(MixSeed(domain->seed ^ MixSeed(domain->domain + 1)) +
+		(unsigned long long)domain->step));
+	UpdateFisheryFishPopulation(fishery, domain->settings);
+	/* Message of each neighbor has the amount of migrants, the vegetation
+	   eaten in the halo and the migrants in coordinates of the fishery. */
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next) {
+		fish = node->node_value;
+		if (fish->pos_x < domain->halo_left)
+			n_migrants[0]++;
+		else if (fish->pos_x >= width - domain->halo_right)
+			n_migrants[1]++;
+	}
+	for (link = 0; link < 2; link++) {
+		messages[link] = malloc(sizeof(long long) + sizeof(int)*halo_tiles +
+			sizeof(Fish_Pool)*(n_migrants[link] + 1));
+		if (messages[link] == NULL) {
+			free(messages[0]);
+			return 0;
+		}
+		memcpy(messages[link], &n_migrants[link], sizeof(long long));
+		message = (int *)(messages[link] + sizeof(long long));
+		migrants[link] = (Fish_Pool *)(message + halo_tiles);
+		if ((link == 0 ? domain->halo_left : domain->halo_right) == 0)
+			continue;
+		start = link == 0 ? 0 : width - domain->halo_right;
+		halo_vegetation = domain->halo_vegetation + (link == 0 ? 0 : domain->halo_left*size_y);
+		for (pos_x = start, i = 0; pos_x < start + FISHERY_DOMAIN_HALO; pos_x++) {
+			for (pos_y = 0; pos_y < size_y; pos_y++, i++)
+				message[i] = halo_vegetation[i] - DomainTile(domain, pos_x, pos_y)->vegetation_level;
+		}
+	}
+	node = fishery->fish_list;
+	while (node != NULL && node->node_value != NULL) {
+		fish = node->node_value;
+		link = fish->pos_x < domain->halo_left ? 0 :
+			(fish->pos_x >= width - domain->halo_right ? 1 : -1);
+		if (link == -1) {
+			prev = node;
+			node = node->next;
+			continue;
+		}
+		DomainTile(domain, fish->pos_x, fish->pos_y)->local_fish = NULL;
+		*migrants[link] = *fish;
+		migrants[link]++->pos_x += domain->x0 - domain->halo_left;
+		free(LListRemove(fishery->fish_list, prev, node));
+		node = prev != NULL ? prev->next : fishery->fish_list;
+	}
+	for (link = 0; link < 2; link++) {
+		if (success && (link == 0 ? domain->halo_left : domain->halo_right) > 0)
+			success = transport->send(transport, link, messages[link], sizeof(long long) +
+				sizeof(int)*halo_tiles + sizeof(Fish_Pool)*n_migrants[link]);
+		free(messages[link]);
+	}
+	return success;
+}
+/* Function: PlaceMigrant
+ * ----------------------
+ * Adds fish pool from a neighbor to domain. If its tile is occupied, the
+ * fish pool moves to the nearest free owned tile, the first one column by
+ * column among the tiles at the same distance. If the domain has no free
+ * tiles, the fish pool dies and is counted as a starvation death.
+ *
+ * *domain:	Domain receiving fish pool.
+ * *fish:	Fish pool in coordinates of the fishery.
+ * **tail:	Last node of the fish list, updated.
+ */
+static void PlaceMigrant(Fishery_Domain *domain, const Fish_Pool *fish, LList_Node **tail) {
+	Fishery *fishery = domain->fishery;
+	Fish_Pool *migrant;
+	long long coords;
+	int pos_x, pos_y, radius, max_radius, x, y, start_x, end_x, start_y, end_y;
+
+	pos_x = fish->pos_x - domain->x0 + domain->halo_left;
+	pos_y = fish->pos_y;
+	coords = LayoutIndex(&fishery->layout, pos_x, pos_y);
+	if (fishery->vegetation_layer[coords].local_fish != NULL) {
+		max_radius = domain->settings.size_x > domain->settings.size_y ?
+			domain->settings.size_x : domain->settings.size_y;
+		coords = -1;
+		/* Search the owned tiles ring by ring. */
+		for (radius = 1; coords == -1 && radius <= max_radius; radius++) {
+			start_x = pos_x - radius < domain->halo_left ? domain->halo_left : pos_x - radius;
+			end_x = pos_x + radius >= domain->settings.size_x - domain->halo_right ?
+				domain->settings.size_x - domain->halo_right - 1 : pos_x + radius;
+			start_y = pos_y - radius < 0 ? 0 : pos_y - radius;
+			end_y = pos_y + radius >= domain->settings.size_y ? 
+				domain->settings.size_y - 1 : pos_y + radius;
+			for (x = start_x; coords == -1 && x <= end_x; x++) {
+				for (y = start_y; y <= end_y; y++) {
+					/* Only the tiles on the ring of the radius. */
+					if (abs(x - pos_x) != radius && abs(y - pos_y) != radius)
+						continue;
+					if (DomainTile(domain, x, y)->local_fish == NULL) {
+						coords = LayoutIndex(&fishery->layout, x, y);
+						break;
+					}
+				}
+			}
+		}
+		if (coords == -1) {
+			fishery->events.starvation_deaths++;
+			return;
+		}
+	}
+	migrant = malloc(sizeof(Fish_Pool));
+	*migrant = *fish;
+	LayoutCoords(&fishery->layout, coords, &migrant->pos_x, &migrant->pos_y);
+	fishery->vegetation_layer[coords].local_fish = migrant;
+	*tail = LListAppend(*tail, migrant);
+}
+/* Function: SpawnDomainFish
+ * --------------------------
+ * Spawns a random fish pool on a free owned tile of domain with the spawn
+ * probability of the domain. Draws from the selected random number stream.
+ *
+ * *domain:	Domain to spawn in.
+ * **tail:	Last node of the fish list, updated.
+ */
+static void SpawnDomainFish(Fishery_Domain *domain, LList_Node **tail) {
+	Fishery *fishery = domain->fishery;
+	Fish_Pool *new_fish;
+	Tile *tile;
+	long long i, pos_avail_n = 0;
+	int pos_x, pos_y, owned_x1 = domain->settings.size_x - domain->halo_right;
+
+	if (domain->spawn_probability <= 0 ||
+		domain->spawn_probability < FISHERY_RAND() / ((double) RAND_MAX + 1L))
+		return;
+	for (pos_x = domain->halo_left; pos_x < owned_x1; pos_x++) {
+		for (pos_y = 0; pos_y < domain->settings.size_y; pos_y++)
+			pos_avail_n += DomainTile(domain, pos_x, pos_y)->local_fish == NULL;
+	}
+	if (pos_avail_n == 0)
+		return;
+	i = GenerateRandLong(0, pos_avail_n - 1);
+	/* Find the chosen free tile, counted column by column. */
+	for (pos_x = domain->halo_left; pos_x < owned_x1; pos_x++) {
+		for (pos_y = 0; pos_y < domain->settings.size_y; pos_y++) {
+			tile = DomainTile(domain, pos_x, pos_y);
+			if (tile->local_fish != NULL || i-- > 0)
+				continue;
+			new_fish = malloc(sizeof(Fish_Pool));
+			new_fish->food_level = 0;
+			new_fish->pop_level = 1;
+			new_fish->pos_x = pos_x;
+			new_fish->pos_y = pos_y;
+			tile->local_fish = new_fish;
+			*tail = LListAppend(*tail, new_fish);
+			fishery->events.spawns++;
+			return;
+		}
+	}
+}
+/* Function: FinishDomainStep
+ * --------------------------
+ * Third phase of a step, receives the vegetation the neighbors ate from
+ * the domain and their migrating fish pools. Then spawns a random fish
+ * pool, fishes the domain and counts its totals.
+ *
+ * *step:	Set to the totals of the owned columns.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int FinishDomainStep(Fishery_Domain *domain, Fishery_Transport *transport,
+	Fishery_Step *step) {
+	const int size_y = domain->settings.size_y, width = domain->settings.size_x;
+	const int halo_tiles = FISHERY_DOMAIN_HALO*size_y;
+	Fishery *fishery = domain->fishery;
+	Fishery_RNG *previous_stream = fishery_rng_stream;
+	LList_Node *node, *tail;
+	Fish_Pool *migrants;
+	Tile *tile;
+	char *message;
+	int *eaten, link, start, pos_x, pos_y, i;
+	long long j, n_migrants = 0;
+	size_t size;
+
+	for (tail = fishery->fish_list; tail->next != NULL; tail = tail->next)
+		;
+	for (link = 0; link < 2; link++) {
+		if ((link == 0 ? domain->halo_left : domain->halo_right) == 0)
+			continue;
+		message = transport->receive(transport, link, &size);
+		if (message != NULL && size >= sizeof(long long))
+			memcpy(&n_migrants, message, sizeof(long long));
+		if (message == NULL || size < sizeof(long long) || n_migrants < 0 ||
+			size != sizeof(long long) + sizeof(int)*halo_tiles + sizeof(Fish_Pool)*n_migrants) {
+			printf("Invalid migrants of domain %d.\n", domain->domain);
+			free(message);
+			return 0;
+		}
+		eaten = (int *)(message + sizeof(long long));
+		migrants = (Fish_Pool *)(eaten + halo_tiles);
+		start = link == 0 ? domain->halo_left : width - domain->halo_right - FISHERY_DOMAIN_HALO;
+		for (pos_x = start, i = 0; pos_x < start + FISHERY_DOMAIN_HALO; pos_x++) {
+			for (pos_y = 0; pos_y < size_y; pos_y++, i++) {
+				tile = DomainTile(domain, pos_x, pos_y);
+				tile->vegetation_level = tile->vegetation_level > eaten[i] ?
+					tile->vegetation_level - eaten[i] : 0;
+			}
+		}
+		for (j = 0; j < n_migrants; j++)
+			PlaceMigrant(domain, &migrants[j], &tail);
+		free(message);
+	}
+	/* Spawning draws from the stream of the domain. */
+	fishery_rng_stream = &fishery->rng;
+	SpawnDomainFish(domain, &tail);
+	fishery_rng_stream = previous_stream;
+	step->step = domain->step;
+	step->fish_n = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		step->fish_n += ((Fish_Pool *)node->node_value)->pop_level;
+	step->yield = domain->settings.fishing_chance > 0 ?
+		FishingEvent(fishery, domain->settings) : 0;
+	step->vegetation_n = 0;
+	for (pos_x = domain->halo_left; pos_x < width - domain->halo_right; pos_x++) {
+		for (pos_y = 0; pos_y < size_y; pos_y++)
+			step->vegetation_n += DomainTile(domain, pos_x, pos_y)->vegetation_level;
+	}
+	fishery->profile.steps++;
+	return 1;
+}
+/* Function: RunFisheryDomain
+ * --------------------------
+ * Progresses domain n steps, exchanging halos and migrants with the
+ * neighbors through transport. The neighbors must run concurrently,
+ * e.g. in other processes connected with CreateSocketTransports.
+ *
+ * *domain:		Domain created with CreateFisheryDomain.
+ * *transport:	Transport of domain.
+ * n:			Number of steps.
+ * *steps:		Set to the totals of the owned columns of each step.
+ *
+ * Returns:		1 if successful, 0 otherwise.
+ */
+int RunFisheryDomain(Fishery_Domain *domain, Fishery_Transport *transport, long long n,
+	Fishery_Step *steps) {
+	long long i;
+
+	for (i = 0; i < n; i++) {
+		if (!SendDomainHalo(domain, transport) || !UpdateDomainFish(domain, transport) ||
+			!FinishDomainStep(domain, transport, &steps[i]))
+			return 0;
+	}
+	return 1;
+}
+/* Function: DestroyFisheryDomain
+ * ------------------------------
+ * Frees memory used by domain.
+ */
+void DestroyFisheryDomain(Fishery_Domain *domain) {
+	if (domain == NULL)
+		return;
+	if (domain->fishery != NULL)
+		DestroyFishery(domain->fishery);
+	free(domain->halo_vegetation);
+	free(domain);
+}
+/* Function: PackDomainState
+ * -------------------------
+ * Packs the events, the owned tiles and the fish pools of domain into a
+ * message, the fish pools in coordinates of the fishery.
+ *
+ * *size:	Set to the bytes in message.
+ *
+ * Returns:	Message freed by the caller, NULL if memory could not be reserved.
+ */
+static char *PackDomainState(Fishery_Domain *domain, size_t *size) {
+	const int size_y = domain->settings.size_y;
+	const long long n_tiles = (long long)(domain->x1 - domain->x0)*size_y;
+	LList_Node *node;
+	Fish_Pool *fish_pools;
+	Tile *tile;
+	char *message;
+	int *tiles, pos_x, pos_y;
+	long long n_fish = 0;
+
+	for (node = domain->fishery->fish_list; node != NULL && node->node_value != NULL;
+		node = node->next)
+		n_fish++;
+	*size = sizeof(Fishery_Events) + sizeof(long long) + sizeof(int)*2*n_tiles +
+		sizeof(Fish_Pool)*n_fish;
+	message = malloc(*size);
+	if (message == NULL)
+		return NULL;
+	memcpy(message, &domain->fishery->events, sizeof(Fishery_Events));
+	memcpy(message + sizeof(Fishery_Events), &n_fish, sizeof(long long));
+	tiles = (int *)(message + sizeof(Fishery_Events) + sizeof(long long));
+	for (pos_x = domain->halo_left; pos_x < domain->halo_left + domain->x1 - domain->x0; pos_x++) {
+		for (pos_y = 0; pos_y < size_y; pos_y++) {
+			tile = DomainTile(domain, pos_x, pos_y);
+			*tiles++ = tile->vegetation_level;
+			*tiles++ = tile->soil_energy;
+		}
+	}
+	fish_pools = (Fish_Pool *)tiles;
+	for (node = domain->fishery->fish_list; node != NULL && node->node_value != NULL;
+		node = node->next) {
+		*fish_pools = *(Fish_Pool *)node->node_value;
+		fish_pools++->pos_x += domain->x0 - domain->halo_left;
+	}
+	return message;
+}
+/* Function: CheckDomainState
+ * --------------------------
+ * Checks that message of PackDomainState fits the columns of domain.
+ *
+ * Returns:	1 if valid, 0 otherwise.
+ */
+static int CheckDomainState(const char *message, size_t size, Fishery_Settings settings,
+	int domain, int n_domains) {
+	long long n_fish, n_tiles;
+	int x0, x1;
+
+	DomainColumns(settings.size_x, domain, n_domains, &x0, &x1);
+	n_tiles = (long long)(x1 - x0)*settings.size_y;
+	if (message == NULL || size < sizeof(Fishery_Events) + sizeof(long long))
+		return 0;
+	memcpy(&n_fish, message + sizeof(Fishery_Events), sizeof(long long));
+	return n_fish >= 0 && size == sizeof(Fishery_Events) + sizeof(long long) +
+		sizeof(int)*2*n_tiles + sizeof(Fish_Pool)*n_fish;
+}
+/* Function: GatherDomains
+ * -----------------------
+ * Writes the states of all domains back to fishery and sums the totals
+ * of the domains into results.
+ *
+ * *fishery:	Decomposed fishery.
+ * settings:	Settings of fishery.
+ * n:			Number of steps run.
+ * n_domains:	Number of domains.
+ * *steps:		Totals of each step of each domain, domain by domain.
+ * **states:	State of each domain, see PackDomainState.
+ * *results:	Set to results of run.
+ */
+static void GatherDomains(Fishery *fishery, Fishery_Settings settings, long long n,
+	int n_domains, const Fishery_Step *steps, char **states, Fishery_Results *results) {
+	LList_Node *tail;
+	Fishery_Events events;
+	Fishery_Step total;
+	Fish_Pool *fish_pools, *fish;
+	Tile *tile;
+	int *tiles, d, x0, x1, pos_x, pos_y;
+	long long i, n_fish;
+
+	InitFisheryResults(results, fishery);
+	for (i = 0; i < fishery->layout.n_tiles; i++)
+		fishery->vegetation_layer[i].local_fish = NULL;
+	LListDestroy(fishery->fish_list, free);
+	fishery->fish_list = tail = LListCreate();
+	for (d = 0; d < n_domains; d++) {
+		memcpy(&events, states[d], sizeof(Fishery_Events));
+		fishery->events.moves += events.moves;
+		fishery->events.failed_moves += events.failed_moves;
+		fishery->events.splits += events.splits;
+		fishery->events.failed_splits += events.failed_splits;
+		fishery->events.starvation_deaths += events.starvation_deaths;
+		fishery->events.fishing_deaths += events.fishing_deaths;
+		fishery->events.spawns += events.spawns;
+		memcpy(&n_fish, states[d] + sizeof(Fishery_Events), sizeof(long long));
+		tiles = (int *)(states[d] + sizeof(Fishery_Events) + sizeof(long long));
+		DomainColumns(settings.size_x, d, n_domains, &x0, &x1);
+		for (pos_x = x0; pos_x < x1; pos_x++) {
+			for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+				tile = &fishery->vegetation_layer[LayoutIndex(&fishery->layout, pos_x, pos_y)];
+				tile->vegetation_level = *tiles++;
+				tile->soil_energy = *tiles++;
+			}
+		}
+		fish_pools = (Fish_Pool *)tiles;
+		for (i = 0; i < n_fish; i++) {
+			fish = malloc(sizeof(Fish_Pool));
+			*fish = fish_pools[i];
+			fishery->vegetation_layer[LayoutIndex(&fishery->layout, fish->pos_x,
+				fish->pos_y)].local_fish = fish;
+			tail = LListAppend(tail, fish);
+		}
+	}
+	for (i = 0; i < n; i++) {
+		memset(&total, 0, sizeof(Fishery_Step));
+		total.step = i + 1;
+		for (d = 0; d < n_domains; d++) {
+			total.fish_n += steps[d*n + i].fish_n;
+			total.yield += steps[d*n + i].yield;
+			total.vegetation_n += steps[d*n + i].vegetation_n;
+		}
+		AddFisheryStep(results, &total);
+	}
+	FinishFisheryResults(results, fishery, n);
+	fishery->profile.steps += n;
+}
+/* Function: RunDomainsLocal
+ * -------------------------
+ * Runs all domains in the calling process, phase by phase.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int RunDomainsLocal(Fishery *fishery, Fishery_Settings settings, long long n,
+	int n_domains, unsigned long long seed, Fishery_Step *steps, char **states) {
+	Fishery_Domain **domains;
+	Fishery_Transport *transports;
+	size_t size;
+	long long i;
+	int d, success;
+
+	domains = calloc(n_domains, sizeof(Fishery_Domain *));
+	transports = CreateLocalTransports(n_domains);
+	success = domains != NULL && transports != NULL;
+	for (d = 0; success && d < n_domains; d++)
+		success = (domains[d] = CreateFisheryDomain(fishery, settings, d, n_domains, seed)) != NULL;
+	for (i = 0; success && i < n; i++) {
+		for (d = 0; success && d < n_domains; d++)
+			success = SendDomainHalo(domains[d], &transports[d]);
+		for (d = 0; success && d < n_domains; d++)
+			success = UpdateDomainFish(domains[d], &transports[d]);
+		for (d = 0; success && d < n_domains; d++)
+			success = FinishDomainStep(domains[d], &transports[d], &steps[d*n + i]);
+	}
+	for (d = 0; success && d < n_domains; d++)
+		success = (states[d] = PackDomainState(domains[d], &size)) != NULL;
+	for (d = 0; domains != NULL && d < n_domains; d++)
+		DestroyFisheryDomain(domains[d]);
+	free(domains);
+	DestroyTransports(transports, n_domains);
+	return success;
+}
+#ifndef _WIN32
+/* Function: WriteAll
+ * ------------------
+ * Writes size bytes of data to blocking file descriptor.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int WriteAll(int fd, const void *data, size_t size) {
+	const char *bytes = data;
+	ssize_t written;
+
+	while (size > 0) {
+		written = write(fd, bytes, size);
+		if (written <= 0) {
+			if (written == -1 && errno == EINTR)
+				continue;
+			return 0;
+		}
+		bytes += written;
+		size -= written;
+	}
+	return 1;
+}
+/* Function: ReadAll
+ * -----------------
+ * Reads size bytes from blocking file descriptor to data.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int ReadAll(int fd, void *data, size_t size) {
+	char *bytes = data;
+	ssize_t received;
+
+	while (size > 0) {
+		received = read(fd, bytes, size);
+		if (received <= 0) {
+			if (received == -1 && errno == EINTR)
+				continue;
+			return 0;
+		}
+		bytes += received;
+		size -= received;
+	}
+	return 1;
+}
+/* Function: RunDomainProcess
+ * --------------------------
+ * Runs domain in a forked process and writes its totals and state to
+ * the parent.
+ *
+ * *transports:		Socket transports of all domains, the others are closed.
+ * *result_fds:		Socket pair of each domain for its results.
+ *
+ * Returns:			Exit status of process.
+ */
+static int RunDomainProcess(Fishery *fishery, Fishery_Settings settings, long long n,
+	int domain, int n_domains, unsigned long long seed, Fishery_Transport *transports,
+	const int *result_fds, Fishery_Step *steps) {
+	Fishery_Domain *created;
+	char *state = NULL;
+	size_t size;
+	int d, success;
+
+	for (d = 0; d < n_domains; d++) {
+		if (d != domain)
+			transports[d].destroy(&transports[d]);
+		if (d > 0) {
+			close(result_fds[2*d]);
+			if (d != domain)
+				close(result_fds[2*d + 1]);
+		}
+	}
+	created = CreateFisheryDomain(fishery, settings, domain, n_domains, seed);
+	success = created != NULL && RunFisheryDomain(created, &transports[domain], n, steps);
+	if (success)
+		success = (state = PackDomainState(created, &size)) != NULL;
+	/* Neighbors still wait for the last migrants. */
+	transports[domain].destroy(&transports[domain]);
+	if (success)
+		success = WriteAll(result_fds[2*domain + 1], steps, sizeof(Fishery_Step)*n) &&
+			WriteAll(result_fds[2*domain + 1], &size, sizeof(size_t)) &&
+			WriteAll(result_fds[2*domain + 1], state, size);
+	close(result_fds[2*domain + 1]);
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
+/* Function: RunDomainProcesses
+ * ----------------------------
+ * Runs each domain in its own process, connected with socket transports.
+ * The calling process runs the first domain and collects the results of
+ * the forked processes.
+ *
+ * Returns:	1 if successful, 0 otherwise.
+ */
+static int RunDomainProcesses(Fishery *fishery, Fishery_Settings settings, long long n,
+	int n_domains, unsigned long long seed, Fishery_Step *steps, char **states) {
+#ifndef _WIN32
+	Fishery_Domain *domain;
+	Fishery_Transport *transports;
+	pid_t *pids;
+	size_t size;
+	int *result_fds, d, status, success;
+
+	transports = CreateSocketTransports(n_domains);
+	result_fds = malloc(sizeof(int)*2*n_domains);
+	pids = malloc(sizeof(pid_t)*n_domains);
+	if (transports == NULL || result_fds == NULL || pids == NULL) {
+		DestroyTransports(transports, n_domains);
+		free(result_fds);
+		free(pids);
+		return 0;
+	}
+	success = 1;
+	for (d = 1; d < n_domains; d++) {
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, &result_fds[2*d]) == -1) {
+			result_fds[2*d] = result_fds[2*d + 1] = -1;
+			success = 0;
+		}
+	}
+	fflush(stdout);
+	for (d = 1; d < n_domains; d++) {
+		pids[d] = success ? fork() : -1;
+		if (pids[d] == 0)
+			_exit(RunDomainProcess(fishery, settings, n, d, n_domains, seed, transports,
+				result_fds, &steps[d*n]));
+		if (pids[d] == -1)
+			success = 0;
+	}
+	for (d = 1; d < n_domains; d++) {
+		transports[d].destroy(&transports[d]);
+		if (result_fds[2*d + 1] != -1)
+			close(result_fds[2*d + 1]);
+	}
+	domain = success ? CreateFisheryDomain(fishery, settings, 0, n_domains, seed) : NULL;
+	success = domain != NULL && RunFisheryDomain(domain, &transports[0], n, steps);
+	if (success)
+		success = (states[0] = PackDomainState(domain, &size)) != NULL;
+	DestroyFisheryDomain(domain);
+	DestroyTransports(transports, n_domains);
+	for (d = 1; d < n_domains; d++) {
+		if (result_fds[2*d] == -1)
+			continue;
+		if (success) {
+			success = ReadAll(result_fds[2*d], &steps[d*n], sizeof(Fishery_Step)*n) &&
+				ReadAll(result_fds[2*d], &size, sizeof(size_t)) &&
+				(states[d] = malloc(size > 0 ? size : 1)) != NULL &&
+				ReadAll(result_fds[2*d], states[d], size) &&
+				CheckDomainState(states[d], size, settings, d, n_domains);
+		}
+		close(result_fds[2*d]);
+	}
+	for (d = 1; d < n_domains; d++) {
+		if (pids[d] > 0 && (waitpid(pids[d], &status, 0) == -1 || !WIFEXITED(status) ||
+			WEXITSTATUS(status) != EXIT_SUCCESS))
+			success = 0;
+	}
+	free(result_fds);
+	free(pids);
+	return success;
+#else
+	printf("Domain processes are not supported on this platform.\n");
+	return 0;
+#endif
+}
+/* Function: UpdateFisheryDomains
+ * ------------------------------
+ * Progresses fishery n steps decomposed into strips of columns, see
+ * fishery_domain.c. The results depend on the number of domains and the
+ * seed, but not on the transport. Each domain spawns random fish pools on
+ * its own columns with its share of the spawn chance, and fish pools 
+ * crossing into a neighbor eat there in the same step, so the results 
+ * differ from UpdateFishery.
+ *
+ * *fishery:		Initialized or progressed fishery, updated with the final
+ *					state of the domains.
+ * settings:		Settings of fishery.
+ * n:				Number of steps, at least one.
+ * n_domains:		Number of domains, each owns at least FISHERY_DOMAIN_HALO
+ *					columns.
+ * transport_type:	FISHERY_TRANSPORT_LOCAL or FISHERY_TRANSPORT_SOCKETS.
+ * seed:			Seed of the random number streams of the domains.
+ * *results:		Set to the results of the run, see UpdateFishery.
+ *
+ * Returns:			1 if successful, 0 otherwise. The fishery is not changed
+ *					if the run fails.
+ */
+int UpdateFisheryDomains(Fishery *fishery, Fishery_Settings settings, long long n,
+	int n_domains, int transport_type, unsigned long long seed, Fishery_Results *results) {
+	Fishery_Step *steps;
+	char **states;
+	int d, success;
+
+	if (n < 1 || n_domains < 1) {
+		printf("Invalid amount of steps (%lld) or domains (%d).\n", n, n_domains);
+		return 0;
+	}
+	if (transport_type != FISHERY_TRANSPORT_LOCAL && transport_type != FISHERY_TRANSPORT_SOCKETS) {
+		printf("Invalid transport of domains (%d).\n", transport_type);
+		return 0;
+	}
+	steps = calloc((size_t)n*n_domains, sizeof(Fishery_Step));
+	states = calloc(n_domains, sizeof(char *));
+	if (steps == NULL || states == NULL) {
+		free(steps);
+		free(states);
+		return 0;
+	}
+	if (transport_type == FISHERY_TRANSPORT_LOCAL)
+		success = RunDomainsLocal(fishery, settings, n, n_domains, seed, steps, states);
+	else
+		success = RunDomainProcesses(fishery, settings, n, n_domains, seed, steps, states);
+	if (success)
+		GatherDomains(fishery, settings, n, n_domains, steps, states, results);
+	for (d = 0; d < n_domains; d++)
+		free(states[d]);
+	free(states);
+	free(steps);
+	return success;
+}
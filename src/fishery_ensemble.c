@@ -0,0 +1,217 @@
+/*****************************************************************************
+ * Filename: fishery_ensemble.c												 *
+ *																			 *
+ * Contains functions for updating ensembles, i.e. fisheries with the same	 *
+ * settings updated in lockstep. The vegetation layers of the fisheries are	 *
+ * interleaved, so the vegetation update runs the same operations for all	 *
+ * fisheries (lanes) of a tile in a loop the compiler can vectorize. The	 *
+ * fish populations are updated one fishery at a time, each fishery should	 *
+ * have its own random number stream (see SeedFisheryRNG).					 *
+ *																			 *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "fishery_ensemble.h"
+#include "fishery_functions.h"
+
+/* Function: CreateEnsemble
+ * ------------------------
+ * Creates ensemble of fisheries. The fisheries are not copied and must 
+ * outlive the ensemble.
+ *
+ * **lanes:		Fisheries of ensemble, all with vegetation layers of the size
+ *				given in settings.
+ * n_lanes:		Number of fisheries.
+ * settings:	Settings of fisheries.
+ *
+ * Returns:		Pointer to Fishery_Ensemble, NULL if the fisheries do not fit
+ *				the settings or memory could not be reserved.
+ */
+Fishery_Ensemble *CreateEnsemble(Fishery **lanes, int n_lanes, Fishery_Settings settings) {
+	Fishery_Ensemble *ensemble;
+	size_t n_values;
+	int i, j;
+
+	if (n_lanes < 1) {
+		printf("Ensemble should have at least one fishery.\n");
+		return NULL;
+	}
+	for (i = 0; i < n_lanes; i++) {
+		if (lanes[i]->settings != NULL && 
+			(lanes[i]->settings->size_x != settings.size_x || 
+			lanes[i]->settings->size_y != settings.size_y)) {
+			printf("Fishery %d of ensemble does not match settings.\n", i);
+			return NULL;
+		}
+		for (j = 0; j < i; j++) {
+			if (lanes[i] == lanes[j]) {
+				printf("Fishery %d is in the ensemble twice.\n", i);
+				return NULL;
+			}
+		}
+	}
+	ensemble = calloc(1, sizeof(Fishery_Ensemble));
+	if (ensemble == NULL)
+		return NULL;
+	ensemble->n_lanes = n_lanes;
+	ensemble->n_tiles = (long long)settings.size_x*settings.size_y;
+	n_values = (size_t)ensemble->n_tiles*n_lanes;
+	ensemble->lanes = malloc(sizeof(Fishery *)*n_lanes);
+	ensemble->vegetation_levels = malloc(sizeof(int)*n_values);
+	ensemble->new_vegetation_levels = malloc(sizeof(int)*n_values);
+	ensemble->soil_energies = malloc(sizeof(int)*n_values);
+	ensemble->spreads = malloc(sizeof(int)*n_lanes);
+	if (ensemble->lanes == NULL || ensemble->vegetation_levels == NULL ||
+		ensemble->new_vegetation_levels == NULL || ensemble->soil_energies == NULL ||
+		ensemble->spreads == NULL) {
+		DestroyEnsemble(ensemble);
+		return NULL;
+	}
+	for (i = 0; i < n_lanes; i++)
+		ensemble->lanes[i] = lanes[i];
+	return ensemble;
+}
+/* Function: UpdateEnsembleVegetation
+ * ----------------------------------
+ * Updates the vegetation layers of all fisheries of ensemble, with the 
+ * same results as UpdateFisheryVegetation for each fishery. Growth is
+ * computed from the vegetation levels before the update, so the new levels
+ * are written to a separate array.
+ *
+ * *ensemble:	Ensemble of fisheries.
+ * settings:	Settings of fisheries.
+ */
+void UpdateEnsembleVegetation(Fishery_Ensemble *ensemble, Fishery_Settings settings) {
+	const int n_lanes = ensemble->n_lanes, spread_at = settings.vegetation_level_spread_at,
+		growth_req = settings.vegetation_level_growth_req,
+		level_max = settings.vegetation_level_max,
+		energy_increase = settings.soil_energy_increase_turn,
+		energy_max = settings.soil_energy_max;
+	const int *consumption = settings.vegetation_consumption;
+	int *levels = ensemble->vegetation_levels, *new_levels = ensemble->new_vegetation_levels,
+		*energies = ensemble->soil_energies, *spreads = ensemble->spreads;
+	const int *neighbor_levels;
+	int *tile_levels, *tile_energies, *tile_new_levels;
+	int j, k, l, pos_x, pos_y, level, energy, grows, growth;
+	long long i;
+	Tile *tile;
+
+	/* Interleave vegetation layers, tile by tile in column order. */
+	for (l = 0; l < n_lanes; l++) {
+		for (pos_x = 0, i = 0; pos_x < settings.size_x; pos_x++) {
+			for (pos_y = 0; pos_y < settings.size_y; pos_y++, i++) {
+				tile = &ensemble->lanes[l]->vegetation_layer[
+					LayoutIndex(&ensemble->lanes[l]->layout, pos_x, pos_y)];
+				levels[i*n_lanes + l] = tile->vegetation_level;
+				energies[i*n_lanes + l] = tile->soil_energy;
+			}
+		}
+	}
+	for (pos_x = 0; pos_x < settings.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+			i = pos_y + (long long)pos_x*settings.size_y;
+			/* Spread from tiles in the neighborhood, including the tile. */
+			for (l = 0; l < n_lanes; l++)
+				spreads[l] = 0;
+			for (j = -1; j <= 1; j++) {
+				for (k = -1; k <= 1; k++) {
+					neighbor_levels = levels + 
+						((pos_y + k + settings.size_y) % settings.size_y + 
+						(long long)((pos_x + j + settings.size_x) % settings.size_x)*
+						settings.size_y)*n_lanes;
+					if (pos_x + j < 0 || pos_x + j >= settings.size_x ||
+						pos_y + k < 0 || pos_y + k >= settings.size_y) {
+						/* Across the border only for toroidal fisheries. */
+						for (l = 0; l < n_lanes; l++) {
+							if (ensemble->lanes[l]->options.toroidal)
+								spreads[l] |= neighbor_levels[l] >= spread_at;
+						}
+						continue;
+					}
+					for (l = 0; l < n_lanes; l++)
+						spreads[l] |= neighbor_levels[l] >= spread_at;
+				}
+			}
+			tile_levels = levels + i*n_lanes;
+			tile_energies = energies + i*n_lanes;
+			tile_new_levels = new_levels + i*n_lanes;
+			/* Same rules as UpdateFisheryVegetation, written as selects. Tiles
+			   with vegetation grow or consume energy, empty tiles receive 
+			   spread. */
+			for (l = 0; l < n_lanes; l++) {
+				level = tile_levels[l];
+				energy = tile_energies[l];
+				grows = level > 0 && level + growth_req <= energy;
+				energy = grows ? energy - level - growth_req :
+					(level > 0 ? energy - consumption[level] : energy);
+				growth = grows ? 1 : (level > 0 ? -(energy < 0) : spreads[l]);
+				level += growth;
+				tile_new_levels[l] = level > level_max ? level_max : level;
+				energy += energy_increase;
+				tile_energies[l] = energy > energy_max ? energy_max : energy;
+			}
+		}
+	}
+	/* Write vegetation layers back. Padding tiles of tiled layouts are 
+	   not updated, they stay empty. */
+	for (l = 0; l < n_lanes; l++) {
+		for (pos_x = 0, i = 0; pos_x < settings.size_x; pos_x++) {
+			for (pos_y = 0; pos_y < settings.size_y; pos_y++, i++) {
+				tile = &ensemble->lanes[l]->vegetation_layer[
+					LayoutIndex(&ensemble->lanes[l]->layout, pos_x, pos_y)];
+				tile->vegetation_level = new_levels[i*n_lanes + l];
+				tile->soil_energy = energies[i*n_lanes + l];
+			}
+		}
+	}
+}
+/* Function: UpdateEnsemble
+ * ------------------------
+ * Progresses all fisheries of ensemble n steps. The results of each
+ * fishery are the same as with UpdateFishery, provided that the fisheries
+ * have their own random number streams.
+ *
+ * *ensemble:	Ensemble of fisheries.
+ * settings:	Settings of fisheries.
+ * n:			Number of steps to progress the fisheries.
+ * *results:	Set to the results of each fishery.
+ */
+void UpdateEnsemble(Fishery_Ensemble *ensemble, Fishery_Settings settings, long long n,
+	Fishery_Results *results) {
+	Fishery_Step step;
+	long long i;
+	int l;
+
+	if (n < 0) {
+		printf("Steps to progress simulation less than zero: %lld.\n", n);
+		exit(EXIT_FAILURE);
+	}
+	for (l = 0; l < ensemble->n_lanes; l++)
+		InitFisheryResults(&results[l], ensemble->lanes[l]);
+	for (i = 0; i < n; i++) {
+		UpdateEnsembleVegetation(ensemble, settings);
+		for (l = 0; l < ensemble->n_lanes; l++) {
+			step = StepFisheryPopulation(ensemble->lanes[l], settings);
+			AddFisheryStep(&results[l], &step);
+		}
+	}
+	for (l = 0; l < ensemble->n_lanes; l++)
+		FinishFisheryResults(&results[l], ensemble->lanes[l], n);
+}
+/* Function: DestroyEnsemble
+ * -------------------------
+ * Frees memory used by ensemble. The fisheries of the ensemble are not 
+ * freed.
+ *
+ * *ensemble:	Ensemble to free.
+ */
+void DestroyEnsemble(Fishery_Ensemble *ensemble) {
+	if (ensemble == NULL)
+		return;
+	free(ensemble->lanes);
+	free(ensemble->vegetation_levels);
+	free(ensemble->new_vegetation_levels);
+	free(ensemble->soil_energies);
+	free(ensemble->spreads);
+	free(ensemble);
+}
@@ -0,0 +1,302 @@
+/*****************************************************************************
+ * Filename: fishery_executor.c												 *
+ *																			 *
+ * Contains functions for running fisheries in worker processes. The		 *
+ * workers are forked from the calling process, so they start with copies	 *
+ * of its fisheries without serializing them. Each worker takes the next	 *
+ * job from a counter in shared memory, runs a copy of the fishery of the	 *
+ * job and writes its results, and optionally the totals of every step, to	 *
+ * a table in the same shared memory. Workers which crash are replaced and	 *
+ * their jobs are marked as failed.											 *
+ *																			 *
+ *****************************************************************************/
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#include "fishery_executor.h"
+#include "fishery_functions.h"
+
+#if !defined(_WIN32) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS			MAP_ANON
+#endif
+/* Bytes before the results, keeps the queue counter on its own cache line. */
+#define JOB_TABLE_HEADER		64
+/* Time between checks of the workers, in nanoseconds. */
+#define EXECUTOR_POLL_NS		1000000
+
+/* Function: CreateJobTable
+ * ------------------------
+ * Creates table of jobs in shared memory, inherited by processes forked
+ * afterwards. All jobs are pending.
+ *
+ * n_jobs:			Number of jobs, at least one.
+ * n:				Steps of each job.
+ * record_series:	1 to record the totals of every step of the jobs.
+ *
+ * Returns:			Pointer to Fishery_Job_Table, NULL if the arguments are
+ *					invalid or the shared memory could not be reserved.
+ */
+Fishery_Job_Table *CreateJobTable(long long n_jobs, long long n, int record_series) {
+#ifndef _WIN32
+	Fishery_Job_Table *table;
+	size_t size;
+
+	if (n_jobs < 1 || n < 0) {
+		printf("Invalid amount of jobs (%lld) or steps (%lld).\n", n_jobs, n);
+		return NULL;
+	}
+	size = JOB_TABLE_HEADER + sizeof(Fishery_Job_Result)*n_jobs;
+	if (record_series)
+		size += sizeof(Fishery_Step)*n_jobs*n;
+	table = malloc(sizeof(Fishery_Job_Table));
+	if (table == NULL)
+		return NULL;
+	table->mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (table->mapping == MAP_FAILED) {
+		printf("Failed to map shared memory of %zu bytes for jobs.\n", size);
+		free(table);
+		return NULL;
+	}
+	table->mapping_size = size;
+	table->n_jobs = n_jobs;
+	table->n = n;
+	table->next_job = table->mapping;
+	table->results = (Fishery_Job_Result *)((char *)table->mapping + JOB_TABLE_HEADER);
+	table->series = record_series ? (Fishery_Step *)(table->results + n_jobs) : NULL;
+	return table;
+#else
+	printf("Job tables are not supported on this platform.\n");
+	return NULL;
+#endif
+}
+#ifndef _WIN32
+/* Function: CopyFishery
+ * ---------------------
+ * Copies fishery, including its options, layout and random number stream.
+ *
+ * Returns:	Pointer to copy, NULL if memory could not be reserved.
+ */
+static Fishery *CopyFishery(const Fishery *fishery, Fishery_Settings settings) {
+	Fishery *copy;
+	LList_Node *node, *tail;
+	Fish_Pool *fish;
+	long long i;
+
+	/* The state of a progressed fishery is copied as is, e.g. its fish
+	   pools can have negative food levels. */
+	copy = CreateFisheryEmpty(settings);
+	if (copy == NULL)
+		return NULL;
+	if (fishery->layout.type != copy->layout.type && !SetFisheryLayout(copy, fishery->layout.type)) {
+		DestroyFishery(copy);
+		return NULL;
+	}
+	for (i = 0; i < copy->layout.n_tiles; i++) {
+		copy->vegetation_layer[i].vegetation_level = fishery->vegetation_layer[i].vegetation_level;
+		copy->vegetation_layer[i].soil_energy = fishery->vegetation_layer[i].soil_energy;
+	}
+	tail = copy->fish_list;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next) {
+		fish = malloc(sizeof(Fish_Pool));
+		if (fish == NULL) {
+			DestroyFishery(copy);
+			return NULL;
+		}
+		*fish = *(Fish_Pool *)node->node_value;
+		tail = LListAppend(tail, fish);
+		copy->vegetation_layer[LayoutIndex(&copy->layout, fish->pos_x, fish->pos_y)].local_fish = fish;
+	}
+	copy->options = fishery->options;
+	copy->rng = fishery->rng;
+	return copy;
+}
+/* Function: RecordJobStep
+ * -----------------------
+ * Fishery_Step_Callback writing the totals of a step to the series of a
+ * job.
+ */
+static int RecordJobStep(void *data, const Fishery_Step *step) {
+	Fishery_Step *series = data;
+
+	series[step->step - 1] = *step;
+	return 0;
+}
+/* Function: RunJobWorker
+ * ----------------------
+ * Runs jobs of the queue in a worker process until the queue is empty.
+ * The status of a job is set after its other fields, so the parent sees
+ * the job of a crashed worker as running or pending.
+ */
+static void RunJobWorker(Fishery_Job_Table *table, Fishery **fisheries,
+	const Fishery_Settings *settings, const unsigned long long *seeds) {
+	Fishery_Job_Result *result;
+	Fishery_Results results;
+	Fishery *fishery;
+	long long job;
+
+	for (;;) {
+		job = __sync_fetch_and_add(table->next_job, 1);
+		if (job >= table->n_jobs)
+			return;
+		result = &table->results[job];
+		result->worker = getpid();
+		__sync_synchronize();
+		result->status = FISHERY_JOB_RUNNING;
+		fishery = CopyFishery(fisheries[job], settings[job]);
+		if (fishery == NULL) {
+			result->status = FISHERY_JOB_FAILED;
+			continue;
+		}
+		if (seeds != NULL)
+			SeedFisheryRNG(fishery, seeds[job]);
+		if (table->series != NULL)
+			results = UpdateFisheryCallback(fishery, settings[job], table->n, 1, RecordJobStep,
+				&table->series[job*table->n]);
+		else
+			results = UpdateFishery(fishery, settings[job], table->n);
+		DestroyFishery(fishery);
+		result->results = results;
+		__sync_synchronize();
+		result->status = FISHERY_JOB_DONE;
+	}
+}
+/* Function: SpawnJobWorker
+ * ------------------------
+ * Forks worker process running jobs of table.
+ *
+ * Returns:	Process id of worker, -1 if the process could not be forked.
+ */
+static pid_t SpawnJobWorker(Fishery_Job_Table *table, Fishery **fisheries,
+	const Fishery_Settings *settings, const unsigned long long *seeds) {
+	pid_t pid;
+
+	pid = fork();
+	if (pid == 0) {
+		RunJobWorker(table, fisheries, settings, seeds);
+		fflush(stdout);
+		_exit(EXIT_SUCCESS);
+	}
+	return pid;
+}
+/* Function: FailWorkerJobs
+ * ------------------------
+ * Marks the running jobs of a crashed worker as failed.
+ */
+static void FailWorkerJobs(Fishery_Job_Table *table, pid_t worker) {
+	long long job;
+
+	for (job = 0; job < table->n_jobs; job++) {
+		if (table->results[job].status == FISHERY_JOB_RUNNING && table->results[job].worker == worker)
+			table->results[job].status = FISHERY_JOB_FAILED;
+	}
+}
+#endif
+/* Function: RunJobTable
+ * ---------------------
+ * Runs the jobs of table in worker processes and waits for them to
+ * finish. Job i progresses a copy of fisheries[i] by the steps of the
+ * table, the fisheries of the calling process are not changed. A crashed
+ * worker is replaced by a new one while jobs are left, the job it was
+ * running fails.
+ *
+ * *table:		Table of jobs, its results are overwritten.
+ * **fisheries:	Fishery of each job. The same fishery can be used by
+ *				several jobs.
+ * *settings:	Settings of the fishery of each job.
+ * *seeds:		Seed of the random number stream of each job, which sets the
+ *				private_rng option of the copies. NULL to run the copies
+ *				with their own options, the results of copies without
+ *				private_rng then depend on the order of the jobs.
+ * n_workers:	Number of worker processes.
+ *
+ * Returns:		Number of jobs done, -1 if n_workers is invalid.
+ */
+long long RunJobTable(Fishery_Job_Table *table, Fishery **fisheries,
+	const Fishery_Settings *settings, const unsigned long long *seeds, int n_workers) {
+#ifndef _WIN32
+	struct timespec pause = { 0, EXECUTOR_POLL_NS };
+	pid_t *workers, pid;
+	long long job, done = 0, spawned = 0;
+	int i, status, crashed, live = 0;
+
+	if (n_workers < 1) {
+		printf("Invalid amount of workers (%d).\n", n_workers);
+		return -1;
+	}
+	if (n_workers > table->n_jobs)
+		n_workers = (int)table->n_jobs;
+	workers = malloc(sizeof(pid_t)*n_workers);
+	if (workers == NULL)
+		return -1;
+	*table->next_job = 0;
+	memset(table->results, 0, sizeof(Fishery_Job_Result)*table->n_jobs);
+	fflush(stdout);
+	for (i = 0; i < n_workers; i++) {
+		workers[i] = SpawnJobWorker(table, fisheries, settings, seeds);
+		if (workers[i] > 0) {
+			live++;
+			spawned++;
+		}
+	}
+	while (live > 0) {
+		for (i = 0; i < n_workers; i++) {
+			if (workers[i] <= 0)
+				continue;
+			pid = waitpid(workers[i], &status, WNOHANG);
+			if (pid == 0 || (pid == -1 && errno == EINTR))
+				continue;
+			live--;
+			crashed = pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS;
+			if (crashed)
+				FailWorkerJobs(table, workers[i]);
+			workers[i] = 0;
+			/* Replacements are limited in case every job crashes its worker. */
+			if (crashed && *table->next_job < table->n_jobs && spawned < n_workers + table->n_jobs) {
+				workers[i] = SpawnJobWorker(table, fisheries, settings, seeds);
+				if (workers[i] > 0) {
+					live++;
+					spawned++;
+				}
+			}
+		}
+		if (live > 0)
+			nanosleep(&pause, NULL);
+	}
+	free(workers);
+	/* Jobs taken by a crashed worker before it marked them did not run. */
+	for (job = 0; job < table->n_jobs; job++) {
+		if (table->results[job].status == FISHERY_JOB_DONE)
+			done++;
+		else
+			table->results[job].status = FISHERY_JOB_FAILED;
+	}
+	return done;
+#else
+	printf("Worker processes are not supported on this platform.\n");
+	return -1;
+#endif
+}
+/* Function: DestroyJobTable
+ * -------------------------
+ * Frees shared memory of table.
+ */
+void DestroyJobTable(Fishery_Job_Table *table) {
+	if (table == NULL)
+		return;
+#ifndef _WIN32
+	munmap(table->mapping, table->mapping_size);
+#endif
+	free(table);
+}
@@ -11,6 +11,18 @@
 #include <assert.h>
 #include <math.h>
 
+/* Timing of the phases of UpdateFishery. Every PROFILE_STOP adds the time 
+   since the previous reading to total and restarts the measurement. */
+#ifdef FISHERY_PROFILE
+#define PROFILE_START(start) ((start) = GetTimeSeconds())
+#define PROFILE_STOP(start, total) \
+	do { double profile_now = GetTimeSeconds(); \
+		(total) += profile_now - (start); (start) = profile_now; } while (0)
+#else
+#define PROFILE_START(start) ((void)0)
+#define PROFILE_STOP(start, total) ((void)0)
+#endif
+
 /* Function CheckFishMemory()
  * Temporary function used to check no mistakes are made when fish pools are moved
  * around in the simulation, i.e. the fishing list contains the same information
@@ -24,15 +36,15 @@
  * memory_ok    - 1 if memories match, 0 otherwise.
  */
 int CheckFishMemory(Fishery *fishery, Fishery_Settings settings) {
-	int pos, memory_ok=1;
+	long long pos;
+	int memory_ok=1;
 	LList_Node *node;
 	Fish_Pool *fish;
 
 	node = fishery->fish_list;
 	while (node != NULL && node->node_value != NULL) {
 		fish = node->node_value;
-		/* pos = fish->pos_x + fish->pos_y*settings.size_x; */
-		pos = fish->pos_y + fish->pos_x*settings.size_y;
+		pos = LayoutIndex(&fishery->layout, fish->pos_x, fish->pos_y);
 		if (fishery->vegetation_layer[pos].local_fish != fish) {
 			printf("Fish memory doesn't match.\n");
 			memory_ok = 0;
@@ -43,6 +55,53 @@ int CheckFishMemory(Fishery *fishery, Fishery_Settings settings) {
 	/* printf("Fish memory matches.\n"); */
 	return memory_ok;
 }
+/* Function: PopulateFishery
+ * Initializes the tiles of a reserved vegetation layer and places the 
+ * initial vegetation and fish population randomly.
+ *
+ * fishery:  Fishery with reserved vegetation layer.
+ * settings: Initialized Fishery_Settings data structure.
+ */
+static void PopulateFishery(
+	Fishery *fishery, Fishery_Settings settings) {
+	Fish_Pool *fish;
+	LList_Node *tail;
+	long long i, *sample, n_cells = (long long)settings.size_x*settings.size_y;
+
+	/* Vegetation tiles - initialize tiles. */
+	for (i = 0; i < fishery->layout.n_tiles; i++) {
+		fishery->vegetation_layer[i].local_fish = NULL;
+		fishery->vegetation_layer[i].vegetation_level = 0;
+		fishery->vegetation_layer[i].soil_energy = settings.soil_energy_increase_turn;
+	}
+	/* Place initial vegetation randomly. Positions are counted column by
+	   column. */
+	sample = GenerateRandSample(n_cells, settings.initial_vegetation_size);
+	for (i = 0; i < settings.initial_vegetation_size; i++) {
+		fishery->vegetation_layer[LayoutIndex(&fishery->layout, 
+			(int)(sample[i] / settings.size_y), 
+			(int)(sample[i] % settings.size_y))].vegetation_level = 1;
+	}
+	free(sample);
+
+	/* Create initial fish population. */
+	fishery->fish_list = LListCreate();
+	tail = fishery->fish_list;
+	sample = GenerateRandSample(n_cells, settings.initial_fish_size);
+	for (i = 0; i < settings.initial_fish_size; i++) {
+		fish = malloc(sizeof(Fish_Pool));
+		fish->food_level = 0;
+		fish->pop_level = 1;
+		fish->pos_x = (int)(sample[i] / settings.size_y);
+		fish->pos_y = (int)(sample[i] % settings.size_y);
+		tail = LListAppend(tail, fish);
+		fishery->vegetation_layer[LayoutIndex(&fishery->layout, 
+			fish->pos_x, fish->pos_y)].local_fish = fish;
+	}
+	free(sample);
+
+	CheckFishMemory(fishery, settings);
+}
 /* Function: CreateFishery
  * Creates Fishery_Simulation data structure according to provided 
  * fishery settings.
@@ -54,63 +113,391 @@ int CheckFishMemory(Fishery *fishery, Fishery_Settings settings) {
 Fishery *CreateFishery(
 	Fishery_Settings settings) {
 	Fishery *fishery;
-	Fish_Pool *fish;
-	int i, pos, *pos_avail;
 		
 	fishery = malloc(sizeof(Fishery));
 	fishery->fish_list = NULL;
-	/* Vegetation tiles - reserve memory and initialize tiles. */	
-	fishery->vegetation_layer = calloc(settings.size_x*settings.size_y, sizeof(Tile));
-	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+	fishery->settings = NULL;
+	fishery->settings_owner = NULL;
+	fishery->storage = NULL;
+	fishery->plan = CreatePlan(settings);
+	ResetFisheryProfile(fishery);
+	memset(&fishery->events, 0, sizeof(Fishery_Events));
+	memset(&fishery->options, 0, sizeof(Fishery_Options));
+	fishery->move_index = NULL;
+	SeedRNG(&fishery->rng, 0);
+	InitLayout(&fishery->layout, FISHERY_LAYOUT_COLUMNS, settings.size_x, settings.size_y);
+	/* Vegetation tiles - reserve memory, initialized in PopulateFishery. */	
+	fishery->vegetation_layer = malloc(
+		sizeof(Tile)*(size_t)settings.size_x*settings.size_y);
+	PopulateFishery(fishery, settings);
+
+	return fishery;
+}
+/* Function: CreateFisheryEmpty
+ * Creates fishery without vegetation and fish population, i.e. with an
+ * empty fish list and tiles of vegetation level and soil energy zero. Used
+ * to copy the state of progressed fisheries, which is not validated. The
+ * tiles and the fish list are filled by the caller, a fish pool must be 
+ * set as the local fish of its tile.
+ *
+ * settings: Initialized Fishery_Settings data structure.
+ *
+ * Returns: Fishery_Simulation data structure, NULL if memory could not
+ *          be reserved.
+ */
+Fishery *CreateFisheryEmpty(
+	Fishery_Settings settings) {
+	Fishery *fishery;
+	long long i, n_cells = (long long)settings.size_x*settings.size_y;
+
+	fishery = malloc(sizeof(Fishery));
+	if (fishery == NULL)
+		return NULL;
+	fishery->fish_list = LListCreate();
+	fishery->vegetation_layer = malloc(sizeof(Tile)*(size_t)n_cells);
+	if (fishery->fish_list == NULL || fishery->vegetation_layer == NULL) {
+		free(fishery->fish_list);
+		free(fishery->vegetation_layer);
+		free(fishery);
+		return NULL;
+	}
+	fishery->settings = NULL;
+	fishery->settings_owner = NULL;
+	fishery->storage = NULL;
+	fishery->plan = CreatePlan(settings);
+	ResetFisheryProfile(fishery);
+	memset(&fishery->events, 0, sizeof(Fishery_Events));
+	memset(&fishery->options, 0, sizeof(Fishery_Options));
+	fishery->move_index = NULL;
+	SeedRNG(&fishery->rng, 0);
+	InitLayout(&fishery->layout, FISHERY_LAYOUT_COLUMNS, settings.size_x, settings.size_y);
+	for (i = 0; i < n_cells; i++) {
 		fishery->vegetation_layer[i].local_fish = NULL;
 		fishery->vegetation_layer[i].vegetation_level = 0;
-		fishery->vegetation_layer[i].soil_energy = settings.soil_energy_increase_turn;
+		fishery->vegetation_layer[i].soil_energy = 0;
 	}
-	/* Place initial vegetation randomly (using second array
-	   of available positions) .*/
-	pos_avail = malloc(sizeof(int)*settings.size_x*settings.size_y);
-	for (i = 0; i < settings.size_x*settings.size_y; i++) {
-		pos_avail[i] = i;
+
+	return fishery;
+}
+/* Function: CreateFisheryFromState
+ * Creates fishery from a given initial state instead of placing the initial
+ * vegetation and fish population randomly. The initial sizes of settings 
+ * are not used. The state is validated against the settings before any
+ * memory is reserved. Negative soil energies and food levels are
+ * valid, the simulation reaches them.
+ *
+ * settings:			Initialized Fishery_Settings data structure.
+ * vegetation_levels:	Vegetation level of each tile, tile (pos_x, pos_y) 
+ *						at pos_y + pos_x*size_y.
+ * soil_energies:		Soil energy of each tile in the same order, NULL if 
+ *						the tiles start with soil_energy_increase_turn.
+ * fish_pools:			Fish pools, copied. NULL if n_fish is zero.
+ * n_fish:				Number of fish pools.
+ *
+ * Returns: Fishery_Simulation data structure, NULL if the state is invalid.
+ */
+Fishery *CreateFisheryFromState(
+	Fishery_Settings settings, const int *vegetation_levels,
+	const int *soil_energies, const Fish_Pool *fish_pools, long long n_fish) {
+	Fishery *fishery;
+	Fish_Pool *fish;
+	LList_Node *tail;
+	Tile *tile;
+	long long i, n_cells = (long long)settings.size_x*settings.size_y;
+	int pos_x, pos_y;
+
+	for (i = 0; i < n_cells; i++) {
+		if (vegetation_levels[i] < 0 || vegetation_levels[i] > settings.vegetation_level_max) {
+			printf("Vegetation level of tile %lld is invalid (%d).\n", i, vegetation_levels[i]);
+			return NULL;
+		}
+		if (soil_energies != NULL && soil_energies[i] > settings.soil_energy_max) {
+			printf("Soil energy of tile %lld is invalid (%d).\n", i, soil_energies[i]);
+			return NULL;
+		}
 	}
-	for (i = 0; i < settings.initial_vegetation_size; i++) {
-		// pos = (int)((double)rand() / (RAND_MAX + 1L)*(settings.size_x*settings.size_y - 1 - i));
-		pos = GENERATERANDINT(0, settings.size_x*settings.size_y - 1 - i);
-		fishery->vegetation_layer[pos_avail[pos]].vegetation_level = 1;
-		pos_avail[pos] = pos_avail[settings.size_x*settings.size_y - 1 - i];
+	for (i = 0; i < n_fish; i++) {
+		if (fish_pools[i].pos_x < 0 || fish_pools[i].pos_x >= settings.size_x ||
+			fish_pools[i].pos_y < 0 || fish_pools[i].pos_y >= settings.size_y ||
+			fish_pools[i].pop_level < 1 || fish_pools[i].pop_level > settings.fish_level_max) {
+			printf("Fish pool %lld is invalid.\n", i);
+			return NULL;
+		}
 	}
-	free(pos_avail);
-
-	/* Create initial fish population. */
-	fishery->fish_list = LListCreate();
-	pos_avail = malloc(sizeof(int)*settings.size_x*settings.size_y);
-	for (i = 0; i < settings.size_x*settings.size_y; i++) {
-		pos_avail[i] = i;
+	fishery = CreateFisheryEmpty(settings);
+	if (fishery == NULL)
+		return NULL;
+	for (pos_x = 0, i = 0; pos_x < settings.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++, i++) {
+			tile = &fishery->vegetation_layer[LayoutIndex(&fishery->layout, pos_x, pos_y)];
+			tile->vegetation_level = vegetation_levels[i];
+			tile->soil_energy = soil_energies != NULL ? 
+				soil_energies[i] : settings.soil_energy_increase_turn;
+		}
 	}
-	for (i = 0; i < settings.initial_fish_size; i++) {
-		// pos = (int)(rand() / (double)(RAND_MAX + 1L)*(settings.size_x*settings.size_y - 1 - i));
-		pos = GENERATERANDINT(0, settings.size_x*settings.size_y - 1 - i);
+	tail = fishery->fish_list;
+	for (i = 0; i < n_fish; i++) {
+		tile = &fishery->vegetation_layer[LayoutIndex(&fishery->layout, 
+			fish_pools[i].pos_x, fish_pools[i].pos_y)];
+		if (tile->local_fish != NULL) {
+			printf("Fish pool %lld is on the tile of another fish pool.\n", i);
+			DestroyFishery(fishery);
+			return NULL;
+		}
 		fish = malloc(sizeof(Fish_Pool));
-		fish->food_level = 0;
-		fish->pop_level = 1;
-		fish->pos_x = pos_avail[pos] / settings.size_y;
-		fish->pos_y = pos_avail[pos] % settings.size_y;
-		LListAdd(fishery->fish_list, fish);
-		fishery->vegetation_layer[pos_avail[pos]].local_fish = fish;
-		pos_avail[pos] = pos_avail[settings.size_x*settings.size_y - 1 - i];
+		*fish = fish_pools[i];
+		tile->local_fish = fish;
+		tail = LListAppend(tail, fish);
 	}
-	free(pos_avail);
 
-	CheckFishMemory(fishery, settings);
+	return fishery;
+}
+/* Function: CreateFisheryMapped
+ * Creates fishery like CreateFishery, but the vegetation layer is stored
+ * in a memory-mapped file at path instead of heap memory. Allows vegetation 
+ * layers larger than the available memory. The file can be turned into a 
+ * checkpoint with SyncFishery and reopened with OpenFisheryMapped.
+ *
+ * settings: Initialized Fishery_Settings data structure.
+ * path:     Path of storage file, created or truncated.
+ *
+ * Returns: Fishery_Simulation data structure, NULL if the storage 
+ *          could not be created.
+ */
+Fishery *CreateFisheryMapped(
+	Fishery_Settings settings, const char *path) {
+	Fishery *fishery;
+	Grid_Storage *storage;
+
+	storage = StorageCreate(path, settings.size_x, settings.size_y);
+	if (storage == NULL)
+		return NULL;
+	fishery = malloc(sizeof(Fishery));
+	fishery->fish_list = NULL;
+	fishery->settings = NULL;
+	fishery->settings_owner = NULL;
+	fishery->storage = storage;
+	fishery->plan = CreatePlan(settings);
+	ResetFisheryProfile(fishery);
+	memset(&fishery->events, 0, sizeof(Fishery_Events));
+	memset(&fishery->options, 0, sizeof(Fishery_Options));
+	fishery->move_index = NULL;
+	SeedRNG(&fishery->rng, 0);
+	InitLayout(&fishery->layout, FISHERY_LAYOUT_COLUMNS, settings.size_x, settings.size_y);
+	fishery->vegetation_layer = storage->tiles;
+	PopulateFishery(fishery, settings);
 
 	return fishery;
 }
+/* Function: OpenFisheryMapped
+ * Opens fishery from a storage file synced with SyncFishery. The 
+ * vegetation layer is used directly from the file, the fish population
+ * is read from the end of the file.
+ *
+ * settings: Settings the fishery was created with.
+ * path:     Path of storage file.
+ *
+ * Returns: Fishery_Simulation data structure, NULL if the storage 
+ *          could not be opened or does not match the settings.
+ */
+Fishery *OpenFisheryMapped(
+	Fishery_Settings settings, const char *path) {
+	Fishery *fishery;
+	Grid_Storage *storage;
+	Fish_Pool *fish_pools, *fish;
+	LList_Node *tail;
+	long long i, pos, n_fish;
+
+	storage = StorageOpen(path, settings.size_x, settings.size_y);
+	if (storage == NULL)
+		return NULL;
+	n_fish = StorageReadFish(storage, &fish_pools);
+	if (n_fish < 0) {
+		StorageRelease(storage);
+		return NULL;
+	}
+	fishery = malloc(sizeof(Fishery));
+	fishery->settings = NULL;
+	fishery->settings_owner = NULL;
+	fishery->storage = storage;
+	fishery->plan = CreatePlan(settings);
+	ResetFisheryProfile(fishery);
+	memset(&fishery->events, 0, sizeof(Fishery_Events));
+	memset(&fishery->options, 0, sizeof(Fishery_Options));
+	fishery->move_index = NULL;
+	SeedRNG(&fishery->rng, 0);
+	InitLayout(&fishery->layout, FISHERY_LAYOUT_COLUMNS, settings.size_x, settings.size_y);
+	fishery->vegetation_layer = storage->tiles;
+	/* Fish pointers stored in the file are from an earlier process. */
+	for (i = 0; i < storage->n_tiles; i++)
+		fishery->vegetation_layer[i].local_fish = NULL;
+	fishery->fish_list = LListCreate();
+	tail = fishery->fish_list;
+	for (i = 0; i < n_fish; i++) {
+		if (fish_pools[i].pos_x < 0 || fish_pools[i].pos_x >= settings.size_x ||
+			fish_pools[i].pos_y < 0 || fish_pools[i].pos_y >= settings.size_y) {
+			printf("Fish pool outside vegetation layer in storage %s.\n", path);
+			continue;
+		}
+		fish = malloc(sizeof(Fish_Pool));
+		*fish = fish_pools[i];
+		pos = LayoutIndex(&fishery->layout, fish->pos_x, fish->pos_y);
+		fishery->vegetation_layer[pos].local_fish = fish;
+		tail = LListAppend(tail, fish);
+	}
+	free(fish_pools);
+
+	return fishery;
+}
+/* Function: SyncFishery
+ * Writes the fish population of a fishery created with CreateFisheryMapped
+ * into its storage file and flushes the vegetation layer to the file. 
+ *
+ * fishery: Fishery with memory-mapped vegetation layer.
+ *
+ * Returns: 1 if successful, 0 otherwise.
+ */
+int SyncFishery(Fishery *fishery) {
+	if (fishery->storage == NULL)
+		return 0;
+	return StorageWriteFish(fishery->storage, fishery->fish_list);
+}
+/* Function: GetFisheryPlan
+ * Returns the plan of the fishery, rebuilding it if the settings differ 
+ * from the settings the plan was built from.
+ *
+ * fishery:  Initialized or progressed fishery.
+ * settings: Settings for fishery.
+ *
+ * Returns: Plan of fishery.
+ */
+Fishery_Plan *GetFisheryPlan(
+	Fishery *fishery, Fishery_Settings settings) {
+	if (fishery->plan == NULL || !PlanMatchesSettings(fishery->plan, settings)) {
+		DestroyPlan(fishery->plan);
+		fishery->plan = CreatePlan(settings);
+		if (fishery->plan == NULL) {
+			printf("Failed to reserve memory for fishery plan.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	return fishery->plan;
+}
+/* Function: ResetFisheryProfile
+ * ------------------------------
+ * Sets the time spent in each phase and the amount of steps of the 
+ * profile of the fishery to zero.
+ *
+ * fishery:  Initialized or progressed fishery.
+ */
+void ResetFisheryProfile(Fishery *fishery) {
+	fishery->profile.vegetation_time = 0.0;
+	fishery->profile.fish_time = 0.0;
+	fishery->profile.fishing_time = 0.0;
+	fishery->profile.statistics_time = 0.0;
+	fishery->profile.steps = 0;
+}
+/* Function: SeedFisheryRNG
+ * -------------------------
+ * Seeds the random number stream of fishery and sets the private_rng 
+ * option, so the fishery no longer draws random numbers from rand().
+ *
+ * fishery:	Initialized or progressed fishery.
+ * seed:	Seed of stream.
+ */
+void SeedFisheryRNG(Fishery *fishery, unsigned long long seed) {
+	SeedRNG(&fishery->rng, seed);
+	fishery->options.private_rng = 1;
+}
+/* Function: SelectFisheryRNG
+ * --------------------------
+ * Selects random number stream of fishery for FISHERY_RAND, i.e. the 
+ * stream of the fishery if it has the private_rng option, rand() otherwise.
+ *
+ * Returns:	Previously selected stream, to be restored by the caller.
+ */
+static Fishery_RNG *SelectFisheryRNG(Fishery *fishery) {
+	Fishery_RNG *previous_stream = fishery_rng_stream;
+
+	fishery_rng_stream = fishery->options.private_rng ? &fishery->rng : NULL;
+	return previous_stream;
+}
+/* Function FastForwardFishery().
+ *
+ * Progresses a quiescent fishery, i.e. a fishery without fish pools and
+ * without random spawning. Its steps draw no random numbers and only the
+ * deterministic vegetation changes, so the vegetation layer eventually
+ * repeats. The repetition is found with Brent's cycle detection by 
+ * comparing the vegetation layer to a snapshot. The steps of the rest of
+ * the full cycles are then added to results from the recorded steps of 
+ * the cycle without simulating them, and the remaining steps are run.
+ * Steps are added one by one, so the results are exactly those of 
+ * running all steps.
+ *
+ * fishery     - Quiescent fishery.
+ * settings    - Settings for fishery.
+ * results     - Results of the run, the steps are added to these.
+ * n           - Number of steps to progress the simulation.
+ *
+ * steps       - Number of steps progressed, n unless memory could not be
+ *               reserved.
+ */
+static long long FastForwardFishery(Fishery *fishery, Fishery_Settings settings,
+	Fishery_Results *results, long long n) {
+	size_t layer_size = sizeof(Tile)*(size_t)fishery->layout.n_tiles;
+	Tile *snapshot;
+	Fishery_Step step, *cycle = NULL, *new_cycle;
+	long long i = 0, j, power = 1, period = 0, capacity = 0;
+
+	snapshot = malloc(layer_size);
+	if (snapshot == NULL)
+		return 0;
+	memcpy(snapshot, fishery->vegetation_layer, layer_size);
+	/* Step until the vegetation layer equals the snapshot, which is taken
+	   again whenever the period reaches the next power of two. */
+	while (i < n) {
+		if (period == power) {
+			memcpy(snapshot, fishery->vegetation_layer, layer_size);
+			power *= 2;
+			period = 0;
+		}
+		if (period == capacity) {
+			capacity = capacity > 0 ? 2*capacity : 64;
+			new_cycle = realloc(cycle, sizeof(Fishery_Step)*(size_t)capacity);
+			if (new_cycle == NULL)
+				break;
+			cycle = new_cycle;
+		}
+		step = StepFishery(fishery, settings);
+		AddFisheryStep(results, &step);
+		cycle[period++] = step;
+		i++;
+		if (memcmp(snapshot, fishery->vegetation_layer, layer_size) == 0) {
+			/* The steps repeat with the period, the layer after full 
+			   cycles equals the current layer. */
+			for (; i + period <= n; i += period) {
+				for (j = 0; j < period; j++)
+					AddFisheryStep(results, &cycle[j]);
+			}
+			for (; i < n; i++) {
+				step = StepFishery(fishery, settings);
+				AddFisheryStep(results, &step);
+			}
+		}
+	}
+	free(snapshot);
+	free(cycle);
+	return i;
+}
 /* Function UpdateFishery().
  * 
  * Progresses the fishery n steps using the given settings. Returns
  * the results of the simulation steps in a Fishery_Result structure. 
  * The results contain total vegetation level, total fish population 
  * and total fishing yield, as well as their standard deviations. See 
- * the Fishery_Results structure for details.
+ * the Fishery_Results structure for details. Once the fish population
+ * has died out without random spawning, repeating vegetation states are 
+ * skipped, see FastForwardFishery.
  *
  * fishery     - Initialized or progressed fishery.
  * settings    - Settings for fishery.
@@ -120,68 +507,431 @@ Fishery *CreateFishery(
  *               of fish present as well as total fishing yield.
  */
 Fishery_Results UpdateFishery(
-	Fishery *fishery, Fishery_Settings settings, int n) {
-	int i, j, tmp_yield, tmp_fish_n, tmp_vegetation_n;
-	LList_Node *node;
+	Fishery *fishery, Fishery_Settings settings, long long n) {
+	return UpdateFisheryCallback(fishery, settings, n, 0, NULL, NULL);
+}
+/* Function UpdateFisheryCallback().
+ * 
+ * Progresses the fishery n steps like UpdateFishery, and calls callback
+ * after every every'th step. The run stops early if callback returns 
+ * nonzero, the results then cover the steps run so far.
+ *
+ * fishery     - Initialized or progressed fishery.
+ * settings    - Settings for fishery.
+ * n           - Number of steps to progress the simulation.
+ * every       - Steps between calls of callback, callback is not 
+ *               called if every is less than one.
+ * callback    - Function to call, or NULL.
+ * data        - Passed to callback.
+ * 
+ * results     - Results of simulation run, see UpdateFishery.
+ */
+Fishery_Results UpdateFisheryCallback(
+	Fishery *fishery, Fishery_Settings settings, long long n, long long every,
+	Fishery_Step_Callback callback, void *data) {
+	long long i;
 	Fishery_Results results;
-	Fish_Pool *fish;
-	
-	results.vegetation_n = 0;
-	results.vegetation_n_std_dev = 0.0;
-	results.fish_n = 0;
-	results.fish_n_std_dev = 0.0;
-	results.yield = 0;
-	results.yield_std_dev = 0.0;
-	results.steps = n;
-
-	results.debug_stuff = 0;
+	Fishery_Step step;
 	
 	if (n < 0) {
-		printf("Steps to progress simulation less than zero: %d.\n", n);
+		printf("Steps to progress simulation less than zero: %lld.\n", n);
 		exit(EXIT_FAILURE);
 	}
+	InitFisheryResults(&results, fishery);
 	for (i = 0; i < n; i++) {
-		/* Update vegetation. */
-		UpdateFisheryVegetation(fishery, settings);
-		/* Update fish population. */
-		UpdateFisheryFishPopulation(fishery, settings);
-		/* Calculate fishing results and debugging info. */
-		tmp_fish_n = 0;
-		node = fishery->fish_list;
-		while (node != NULL && node->node_value != NULL) {
-			fish = node->node_value;
-			tmp_fish_n += fish->pop_level;
-			node = node->next;
-		}
-		if (tmp_fish_n == 0) {
-			results.debug_stuff++;
-		}
-		results.fish_n += tmp_fish_n;
-		results.fish_n_std_dev += tmp_fish_n*tmp_fish_n;
-		if (settings.fishing_chance > 0) {
-			tmp_yield = FishingEvent(fishery, settings);
-			results.yield += tmp_yield;
-			results.yield_std_dev += tmp_yield*tmp_yield;
-		}
-		tmp_vegetation_n = 0;
-		for (j = 0; j < settings.size_x*settings.size_y; j++) {
-			tmp_vegetation_n += fishery->vegetation_layer[j].vegetation_level;
-		}
-		results.vegetation_n += tmp_vegetation_n;
-		results.vegetation_n_std_dev += tmp_vegetation_n*tmp_vegetation_n;
-	}
-	results.vegetation_n_std_dev = 
-		sqrt(results.vegetation_n_std_dev / n - pow((double) results.vegetation_n / n, 2));
-	results.fish_n_std_dev = 
-		sqrt(results.fish_n_std_dev / n - pow((double) results.fish_n / n, 2));
-	results.yield_std_dev = 
-		sqrt(results.yield_std_dev / n - pow((double) results.yield / n, 2));
+		step = StepFishery(fishery, settings);
+		AddFisheryStep(&results, &step);
+		if (callback != NULL && every > 0 && (i + 1) % every == 0) {
+			step.step = i + 1;
+			if (callback(data, &step)) {
+				i++;
+				break;
+			}
+		}
+		else if (callback == NULL && step.fish_n == 0 && LListIsEmpty(fishery->fish_list) &&
+			settings.random_fishes_interval == 0) {
+			/* Without fish pools and spawning only the vegetation changes. */
+			i += FastForwardFishery(fishery, settings, &results, n - i - 1);
+		}
+	}
+	FinishFisheryResults(&results, fishery, i);
 
 	return results;
 }
+/* Function InitFisheryResults().
+ * 
+ * Clears results and the event counts of fishery before a run.
+ *
+ * results     - Results of the run.
+ * fishery     - Fishery of the run.
+ */
+void InitFisheryResults(Fishery_Results *results, Fishery *fishery) {
+	results->vegetation_n = 0;
+	results->vegetation_n_std_dev = 0.0;
+	results->fish_n = 0;
+	results->fish_n_std_dev = 0.0;
+	results->yield = 0;
+	results->yield_std_dev = 0.0;
+	results->steps = 0;
+
+	results->debug_stuff = 0;
+	memset(&fishery->events, 0, sizeof(Fishery_Events));
+}
+/* Function AddFisheryStep().
+ * 
+ * Adds totals of a step to results.
+ *
+ * results     - Results of the run.
+ * step        - Totals of the step.
+ */
+void AddFisheryStep(Fishery_Results *results, const Fishery_Step *step) {
+	if (step->fish_n == 0) {
+		results->debug_stuff++;
+	}
+	results->fish_n += step->fish_n;
+	results->fish_n_std_dev += (double)step->fish_n*step->fish_n;
+	results->yield += step->yield;
+	results->yield_std_dev += (double)step->yield*step->yield;
+	results->vegetation_n += step->vegetation_n;
+	results->vegetation_n_std_dev += (double)step->vegetation_n*step->vegetation_n;
+}
+/* Function FinishFisheryResults().
+ * 
+ * Calculates standard deviations of results after n steps and copies the
+ * event counts of fishery.
+ *
+ * results     - Results of the run.
+ * fishery     - Fishery of the run.
+ * n           - Number of steps run.
+ */
+void FinishFisheryResults(Fishery_Results *results, Fishery *fishery, long long n) {
+	results->steps = n;
+	results->events = fishery->events;
+	results->vegetation_n_std_dev = 
+		sqrt(results->vegetation_n_std_dev / n - pow((double) results->vegetation_n / n, 2));
+	results->fish_n_std_dev = 
+		sqrt(results->fish_n_std_dev / n - pow((double) results->fish_n / n, 2));
+	results->yield_std_dev = 
+		sqrt(results->yield_std_dev / n - pow((double) results->yield / n, 2));
+}
+/* Function StepFishery().
+ * 
+ * Progresses the fishery a single step and returns the totals of the 
+ * step. Events of the step are added to fishery->events.
+ *
+ * fishery     - Initialized or progressed fishery.
+ * settings    - Settings for fishery.
+ * 
+ * step        - Totals of fish population, fishing yield and 
+ *               vegetation level after the step.
+ */
+Fishery_Step StepFishery(Fishery *fishery, Fishery_Settings settings) {
+#ifdef FISHERY_PROFILE
+	double profile_start;
+#endif
+
+	/* Update vegetation. */
+	PROFILE_START(profile_start);
+	UpdateFisheryVegetation(fishery, settings);
+	PROFILE_STOP(profile_start, fishery->profile.vegetation_time);
+	return StepFisheryPopulation(fishery, settings);
+}
+/* Function StepFisheryPopulation().
+ * 
+ * Finishes a step after the vegetation update, i.e. updates the fish
+ * population, fishes and calculates the totals of the step. Used by 
+ * StepFishery and by ensembles, which update the vegetation of all 
+ * their fisheries at once.
+ *
+ * fishery     - Fishery with updated vegetation layer.
+ * settings    - Settings for fishery.
+ * 
+ * step        - Totals of the step, see StepFishery.
+ */
+Fishery_Step StepFisheryPopulation(Fishery *fishery, Fishery_Settings settings) {
+	long long j, n_tiles = fishery->layout.n_tiles;
+	LList_Node *node;
+	Fishery_Step step;
+	Fish_Pool *fish;
+#ifdef FISHERY_PROFILE
+	double profile_start;
+#endif
+
+	step.step = 1;
+	step.yield = 0;
+	/* Update fish population. */
+	PROFILE_START(profile_start);
+	UpdateFisheryFishPopulation(fishery, settings);
+	PROFILE_STOP(profile_start, fishery->profile.fish_time);
+	/* Calculate fishing results and debugging info. */
+	step.fish_n = 0;
+	node = fishery->fish_list;
+	while (node != NULL && node->node_value != NULL) {
+		fish = node->node_value;
+		step.fish_n += fish->pop_level;
+		node = node->next;
+	}
+	PROFILE_STOP(profile_start, fishery->profile.statistics_time);
+	if (settings.fishing_chance > 0)
+		step.yield = FishingEvent(fishery, settings);
+	PROFILE_STOP(profile_start, fishery->profile.fishing_time);
+	step.vegetation_n = 0;
+	/* Padding tiles of the layout have no vegetation. */
+	for (j = 0; j < n_tiles; j++) {
+		step.vegetation_n += fishery->vegetation_layer[j].vegetation_level;
+	}
+	PROFILE_STOP(profile_start, fishery->profile.statistics_time);
+	fishery->profile.steps++;
+
+	return step;
+}
+/* Function GrowVegetationTile().
+ *
+ * Consumes soil energy of a tile with vegetation for growth, or for 
+ * maintaining its vegetation level.
+ *
+ * tile        - Tile with vegetation.
+ * settings    - Settings for fishery.
+ *
+ * growth      - Change of vegetation level of tile: 1 if it grows, -1 if
+ *               the soil energy is insufficient, 0 otherwise.
+ */
+static FISHERY_INLINE int GrowVegetationTile(Tile *tile, const Fishery_Settings *settings) {
+	/* If enough soil energy for vegetation growth. */
+	if (tile->vegetation_level +
+		settings->vegetation_level_growth_req <= tile->soil_energy) {
+		tile->soil_energy = /* Consume energy for growth. */
+			tile->soil_energy - tile->vegetation_level
+			- settings->vegetation_level_growth_req;
+		return 1;
+	}
+	/* Consumption of soil energy to maintain vegetation level. Decrease in
+	   vegetation level takes place if there is insufficient soil energy. */
+	tile->soil_energy = tile->soil_energy -
+		settings->vegetation_consumption[tile->vegetation_level];
+	return tile->soil_energy < 0 ? -1 : 0;
+}
+/* Function ApplyVegetationGrowth().
+ *
+ * Adds growth to the vegetation level of a tile and soil energy for the
+ * next step.
+ *
+ * tile        - Tile of vegetation layer.
+ * growth      - Growth of vegetation level.
+ * settings    - Settings for fishery.
+ */
+static FISHERY_INLINE void ApplyVegetationGrowth(
+	Tile *tile, int growth, const Fishery_Settings *settings) {
+	/* Add growth layer to vegetation layer. */
+	tile->vegetation_level += growth;
+	if (tile->vegetation_level > settings->vegetation_level_max)
+		tile->vegetation_level = settings->vegetation_level_max;
+	/* Add soil energy. */
+	tile->soil_energy += settings->soil_energy_increase_turn;
+	if (tile->soil_energy > settings->soil_energy_max)
+		tile->soil_energy = settings->soil_energy_max;
+}
+/* Bitboards of the vegetation layer store one column in words of 
+   FISHERY_WORD_BITS tiles, tile pos_y is bit pos_y % FISHERY_WORD_BITS of 
+   word pos_y / FISHERY_WORD_BITS. */
+#define FISHERY_WORD_BITS 64
+typedef unsigned long long Fishery_Word;
+
+/* Function LowestBit().
+ *
+ * Position of the lowest set bit of a nonzero word.
+ */
+static FISHERY_INLINE int LowestBit(Fishery_Word word) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(word);
+#else
+	int bit = 0;
+
+	while (!(word & 1)) {
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+/* Function MarkVegetationColumn().
+ *
+ * Grows the tiles with vegetation of a column and sets the bitboards of
+ * the tiles which spread and of the empty tiles of the column. Vegetation
+ * levels of the column are not changed.
+ *
+ * tiles       - First tile of the column.
+ * size_y      - Height of the vegetation layer.
+ * n_words     - Words per column of the bitboards.
+ * plan        - Plan of fishery.
+ *
+ * growth      - Growth of the tiles of the column. If NULL, only the 
+ *               bitboards are set and the tiles are not grown.
+ * spreads     - Bitboard of the tiles which spread.
+ * empty       - Bitboard of the tiles without vegetation.
+ */
+static void MarkVegetationColumn(Tile *tiles, int size_y, int n_words, 
+	const Fishery_Plan *plan, int *growth, Fishery_Word *spreads, Fishery_Word *empty) {
+	const int *vegetation_spreads = plan->vegetation_spreads;
+	Fishery_Word bit;
+	int pos_y, word;
+
+	memset(spreads, 0, sizeof(Fishery_Word)*n_words);
+	memset(empty, 0, sizeof(Fishery_Word)*n_words);
+	for (pos_y = 0; pos_y < size_y; pos_y++) {
+		word = pos_y / FISHERY_WORD_BITS;
+		bit = (Fishery_Word)1 << (pos_y % FISHERY_WORD_BITS);
+		if (tiles[pos_y].vegetation_level > 0) {
+			if (growth != NULL)
+				growth[pos_y] = GrowVegetationTile(&tiles[pos_y], &plan->settings);
+		}
+		else {
+			if (growth != NULL)
+				growth[pos_y] = 0;
+			empty[word] |= bit;
+		}
+		if (vegetation_spreads[tiles[pos_y].vegetation_level])
+			spreads[word] |= bit;
+	}
+}
+/* Function SpreadWord().
+ *
+ * Word of the tiles which spread in a column or its neighboring columns.
+ */
+static FISHERY_INLINE Fishery_Word SpreadWord(const Fishery_Word *left, 
+	const Fishery_Word *center, const Fishery_Word *right, int word) {
+	return center[word] | (left != NULL ? left[word] : 0) | (right != NULL ? right[word] : 0);
+}
+/* Function SpreadVegetationColumn().
+ *
+ * Marks the growth of the empty tiles of a column next to tiles which 
+ * spread, i.e. the 3x3 dilation of the spreading tiles of the column and
+ * its neighboring columns restricted to the empty tiles of the column.
+ * Missing neighbors act as a border of tiles which do not spread.
+ *
+ * size_y      - Height of the vegetation layer.
+ * toroidal    - 1 if the first and the last tile of the column are 
+ *               neighbors, 0 otherwise.
+ * left        - Bitboard of the tiles which spread in the previous column,
+ *               NULL if the column has none.
+ * center      - Bitboard of the tiles which spread in the column.
+ * right       - Bitboard of the tiles which spread in the next column,
+ *               NULL if the column has none.
+ * empty       - Bitboard of the tiles without vegetation in the column.
+ *
+ * growth      - Growth of the tiles of the column.
+ */
+static void SpreadVegetationColumn(int size_y, int toroidal, const Fishery_Word *left, 
+	const Fishery_Word *center, const Fishery_Word *right, 
+	const Fishery_Word *empty, int *growth) {
+	const int n_words = (size_y + FISHERY_WORD_BITS - 1) / FISHERY_WORD_BITS,
+		last_bit = (size_y - 1) % FISHERY_WORD_BITS;
+	Fishery_Word row, previous = 0, next, spread;
+	int word;
+
+	next = SpreadWord(left, center, right, 0);
+	for (word = 0; word < n_words; word++) {
+		row = next;
+		next = word + 1 < n_words ? SpreadWord(left, center, right, word + 1) : 0;
+		/* Tiles spread to the tiles above and below them, bits shifted 
+		   out of the word continue in the neighboring words. */
+		spread = (row | row << 1 | row >> 1 | previous >> (FISHERY_WORD_BITS - 1) |
+			next << (FISHERY_WORD_BITS - 1)) & empty[word];
+		previous = row;
+		while (spread) {
+			growth[word*FISHERY_WORD_BITS + LowestBit(spread)] = 1;
+			spread &= spread - 1;
+		}
+	}
+	if (toroidal) {
+		/* Spread between the first and the last tile of the column. */
+		if ((SpreadWord(left, center, right, n_words - 1) >> last_bit & 1) && (empty[0] & 1))
+			growth[0] = 1;
+		if ((SpreadWord(left, center, right, 0) & 1) && (empty[n_words - 1] >> last_bit & 1))
+			growth[size_y - 1] = 1;
+	}
+}
+/* Function UpdateVegetationTiled().
+ *
+ * UpdateFisheryVegetation for the tiled layout. The vegetation layer is
+ * processed block by block, so the neighbors of a tile are mostly in the
+ * same block. The growth of the whole vegetation layer is kept in memory.
+ *
+ * fishery     - Fishery with tiled layout.
+ * settings    - Settings for fishery.
+ * plan        - Plan of fishery.
+ */
+static void UpdateVegetationTiled(
+	Fishery *fishery, Fishery_Settings settings, const Fishery_Plan *plan) {
+	const Fishery_Layout *layout = &fishery->layout;
+	const int *vegetation_spreads = plan->vegetation_spreads,
+		toroidal = fishery->options.toroidal;
+	long long i, block_i, neighbor_i;
+	int j, k, block_x, block_y, pos_x, pos_y, end_x, end_y, interior;
+	int *vegetation_layer_growth;
+	Tile *tile;
+
+	vegetation_layer_growth = calloc((size_t)layout->n_tiles, sizeof(int));
+	for (block_x = 0; block_x < settings.size_x; block_x += FISHERY_BLOCK_SIZE) {
+		end_x = block_x + FISHERY_BLOCK_SIZE < settings.size_x ? 
+			block_x + FISHERY_BLOCK_SIZE : settings.size_x;
+		for (block_y = 0; block_y < settings.size_y; block_y += FISHERY_BLOCK_SIZE) {
+			end_y = block_y + FISHERY_BLOCK_SIZE < settings.size_y ? 
+				block_y + FISHERY_BLOCK_SIZE : settings.size_y;
+			block_i = LayoutIndex(layout, block_x, block_y);
+			for (pos_x = block_x; pos_x < end_x; pos_x++) {
+				for (pos_y = block_y; pos_y < end_y; pos_y++) {
+					i = block_i + ((pos_x - block_x) << FISHERY_BLOCK_SHIFT) + (pos_y - block_y);
+					tile = &fishery->vegetation_layer[i];
+					if (tile->vegetation_level > 0)
+						vegetation_layer_growth[i] = GrowVegetationTile(tile, &settings);
+					if (!vegetation_spreads[tile->vegetation_level])
+						continue;
+					/* Spread to empty neighbors inside the vegetation layer. 
+					   Neighbors inside the block are at fixed offsets. */
+					interior = (pos_x & FISHERY_BLOCK_MASK) != 0 && 
+						(pos_x & FISHERY_BLOCK_MASK) != FISHERY_BLOCK_MASK &&
+						(pos_y & FISHERY_BLOCK_MASK) != 0 && 
+						(pos_y & FISHERY_BLOCK_MASK) != FISHERY_BLOCK_MASK &&
+						pos_x + 1 < settings.size_x && pos_y + 1 < settings.size_y;
+					for (j = -1; j <= 1; j++) {
+						for (k = -1; k <= 1; k++) {
+							if (interior)
+								neighbor_i = i + j*FISHERY_BLOCK_SIZE + k;
+							else if (toroidal)
+								neighbor_i = LayoutIndex(layout, 
+									(pos_x + j + settings.size_x) % settings.size_x,
+									(pos_y + k + settings.size_y) % settings.size_y);
+							else if (pos_x + j < 0 || pos_x + j >= settings.size_x ||
+								pos_y + k < 0 || pos_y + k >= settings.size_y)
+								continue;
+							else
+								neighbor_i = LayoutIndex(layout, pos_x + j, pos_y + k);
+							if (fishery->vegetation_layer[neighbor_i].vegetation_level == 0)
+								vegetation_layer_growth[neighbor_i] = 1;
+						}
+					}
+				}
+			}
+		}
+	}
+	/* Padding tiles only gain soil energy. */
+	for (i = 0; i < layout->n_tiles; i++)
+		ApplyVegetationGrowth(&fishery->vegetation_layer[i], vegetation_layer_growth[i], &settings);
+	free(vegetation_layer_growth);
+}
 /* Function UpdateFisheryVegetation().
  *
  * Increases soil energy and grows the vegetation layer as necessary.
+ * The columns of the vegetation layer are processed in order. The tiles
+ * which spread and the empty tiles of a column are kept as bitboards, so
+ * the spread to the neighbors is computed for a word of tiles at a time.
+ * A column is updated once the bitboards of the next column are known, 
+ * so only the growth of two columns is kept in memory. With the toroidal
+ * option, the bitboards of the last column are marked before the update
+ * and the bitboards of the first column are kept until the end, as the 
+ * neighbors of the first and the last column. Vegetation layers with the
+ * tiled layout are updated by UpdateVegetationTiled.
  *
  * fishery     - Initialized or progressed fishery.
  * settings    - Settings for fishery.
@@ -190,178 +940,516 @@ Fishery_Results UpdateFishery(
 void UpdateFisheryVegetation(
 	Fishery
 	*fishery, Fishery_Settings settings) {
-	int i, j, k, pos_x, pos_y;
-	int *vegetation_layer_growth;
+	const Fishery_Plan *plan = GetFisheryPlan(fishery, settings);
+	const int toroidal = fishery->options.toroidal;
+	Fishery_Word *bitboards, *spreads[5], *empty[5];
+	int pos_x, pos_y, n_words = (settings.size_y + FISHERY_WORD_BITS - 1) / FISHERY_WORD_BITS;
+	int *vegetation_layer_growth, *growth;
+	Tile *tiles;
 
-	vegetation_layer_growth = calloc(settings.size_x*settings.size_y, sizeof(int));
-	/* Grow vegetation layer in different array to avoid double growths. */
-	for (i = 0; i < settings.size_x*settings.size_y; i++) {
-		/* If tile contains vegetation. */
-		if (fishery->vegetation_layer[i].vegetation_level > 0) {
-			/* If enough soil energy for vegetation growth. */
-			if (fishery->vegetation_layer[i].vegetation_level +
-				settings.vegetation_level_growth_req <= fishery->vegetation_layer[i].soil_energy) {
-				vegetation_layer_growth[i] = 1;
-				fishery->vegetation_layer[i].soil_energy = /* Consume energy for growth. */
-					fishery->vegetation_layer[i].soil_energy -
-					fishery->vegetation_layer[i].vegetation_level
-					- settings.vegetation_level_growth_req;
-			}
-			else { /* Consumption of soil energy to maintain vegetation level. Decrease in
-				   vegetation level takes place if there is insufficient soil energy. */
-				fishery->vegetation_layer[i].soil_energy =
-					fishery->vegetation_layer[i].soil_energy -
-					settings.vegetation_consumption[fishery->vegetation_layer[i].vegetation_level];
-				if (fishery->vegetation_layer[i].soil_energy < 0)
-					vegetation_layer_growth[i] = -1;
+	if (fishery->layout.type != FISHERY_LAYOUT_COLUMNS) {
+		UpdateVegetationTiled(fishery, settings, plan);
+		return;
+	}
+
+	/* Grow vegetation layer in different array to avoid double growths. 
+	   Growth and bitboards of column pos_x are stored at pos_x % 2 and 
+	   pos_x % 3 respectively, bitboards 3 and 4 are the neighbors across
+	   the border of a toroidal vegetation layer. */
+	vegetation_layer_growth = malloc(sizeof(int)*2*settings.size_y);
+	bitboards = malloc(sizeof(Fishery_Word)*10*n_words);
+	for (pos_x = 0; pos_x < 5; pos_x++) {
+		spreads[pos_x] = bitboards + 2*pos_x*n_words;
+		empty[pos_x] = bitboards + (2*pos_x + 1)*n_words;
+	}
+	if (toroidal) {
+		MarkVegetationColumn(&fishery->vegetation_layer[(long long)(settings.size_x - 1)*
+			settings.size_y], settings.size_y, n_words, plan, NULL, spreads[3], empty[3]);
+	}
+	for (pos_x = 0; pos_x <= settings.size_x; pos_x++) {
+		if (pos_x < settings.size_x) {
+			MarkVegetationColumn(&fishery->vegetation_layer[(long long)pos_x*settings.size_y],
+				settings.size_y, n_words, plan, vegetation_layer_growth + 
+				(pos_x % 2)*settings.size_y, spreads[pos_x % 3], empty[pos_x % 3]);
+		}
+		if (pos_x == 0) {
+			if (toroidal)
+				memcpy(spreads[4], spreads[0], sizeof(Fishery_Word)*n_words);
+			continue;
+		}
+		/* All neighbors of column pos_x - 1 are marked. */
+		growth = vegetation_layer_growth + ((pos_x - 1) % 2)*settings.size_y;
+		SpreadVegetationColumn(settings.size_y, toroidal, 
+			pos_x > 1 ? spreads[(pos_x - 2) % 3] : (toroidal ? spreads[3] : NULL),
+			spreads[(pos_x - 1) % 3], 
+			pos_x < settings.size_x ? spreads[pos_x % 3] : (toroidal ? spreads[4] : NULL),
+			empty[(pos_x - 1) % 3], growth);
+		tiles = &fishery->vegetation_layer[(long long)(pos_x - 1)*settings.size_y];
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++)
+			ApplyVegetationGrowth(&tiles[pos_y], growth[pos_y], &settings);
+	}
+	free(vegetation_layer_growth);
+	free(bitboards);
+}
+/* Function BuildFlowField().
+ *
+ * Computes the flow field of the directed_moves option with a breadth 
+ * first search from all tiles with vegetation. The flow of a tile is the
+ * neighboring tile on a shortest path to the nearest vegetation, moving 
+ * one tile in any of the eight directions at a time (across the borders
+ * with the toroidal option).
+ *
+ * fishery     - Initialized or progressed fishery.
+ *
+ * flow        - Index of the next tile for each tile, the index of the
+ *               tile itself for tiles with vegetation and -1 for tiles
+ *               without path to vegetation. NULL if memory could not be
+ *               reserved. Freed by the caller.
+ */
+static long long *BuildFlowField(Fishery *fishery) {
+	const Fishery_Layout *layout = &fishery->layout;
+	long long *flow, *queue, i, neighbor_i, head = 0, tail = 0;
+	int j, k, pos_x, pos_y;
+
+	flow = malloc(sizeof(long long)*(size_t)layout->n_tiles);
+	queue = malloc(sizeof(long long)*(size_t)layout->n_tiles);
+	if (flow == NULL || queue == NULL) {
+		free(flow);
+		free(queue);
+		return NULL;
+	}
+	for (i = 0; i < layout->n_tiles; i++)
+		flow[i] = -1;
+	for (pos_x = 0; pos_x < layout->size_x; pos_x++) {
+		for (pos_y = 0; pos_y < layout->size_y; pos_y++) {
+			i = LayoutIndex(layout, pos_x, pos_y);
+			if (fishery->vegetation_layer[i].vegetation_level > 0) {
+				flow[i] = i;
+				queue[tail++] = i;
 			}
 		}
-		/* If vegetation level is large enough, spread to neighboring tiles. */
-		if (fishery->vegetation_layer[i].vegetation_level >= settings.vegetation_level_spread_at) {
-			pos_y = i % settings.size_y;
-			pos_x = i / settings.size_y;
-			/* Spread only to valid tiles, i.e. not outside array
-			and only to empty tiles. */
-			for (j = -1; j <= 1; j++) {
-				for (k = -1; k <= 1; k++) {
-					if (pos_x + j >= 0 && pos_x + j < settings.size_x &&
-						pos_y + k >= 0 && pos_y + k < settings.size_y &&
-						fishery->vegetation_layer[(pos_y + k) + (pos_x + j)*settings.size_y].vegetation_level == 0) {
-						vegetation_layer_growth[(pos_y + k) + (pos_x + j)*settings.size_y] = 1;
-					}
+	}
+	while (head < tail) {
+		i = queue[head++];
+		LayoutCoords(layout, i, &pos_x, &pos_y);
+		for (j = -1; j <= 1; j++) {
+			for (k = -1; k <= 1; k++) {
+				if (fishery->options.toroidal)
+					neighbor_i = LayoutIndex(layout, (pos_x + j + layout->size_x) % layout->size_x,
+						(pos_y + k + layout->size_y) % layout->size_y);
+				else if (pos_x + j < 0 || pos_x + j >= layout->size_x ||
+					pos_y + k < 0 || pos_y + k >= layout->size_y)
+					continue;
+				else
+					neighbor_i = LayoutIndex(layout, pos_x + j, pos_y + k);
+				if (flow[neighbor_i] == -1) {
+					flow[neighbor_i] = i;
+					queue[tail++] = neighbor_i;
 				}
 			}
 		}
 	}
-	/* Add growth layer to vegetation layer. */
-	for (i = 0; i < settings.size_x*settings.size_y; i++) {
-		fishery->vegetation_layer[i].vegetation_level += vegetation_layer_growth[i];
-		if (fishery->vegetation_layer[i].vegetation_level > settings.vegetation_level_max)
-			fishery->vegetation_layer[i].vegetation_level = settings.vegetation_level_max;
+	free(queue);
+	return flow;
+}
+/* Function DirectedMove().
+ *
+ * Follows the flow field from the position of a fish pool for at most 
+ * max_moves tiles, and selects the free tile closest to the vegetation.
+ * The flow field is computed once per step, so tiles on the path may 
+ * have been taken or eaten empty since.
+ *
+ * fishery     - Initialized or progressed fishery.
+ * flow        - Flow field of BuildFlowField.
+ * fish_pos    - Index of the tile of the fish pool.
+ * max_moves   - Number of moves available to the fish pool.
+ * *moves      - Set to the number of moves used.
+ *
+ * new_pos     - Index of the selected tile, -1 if no free tile is on
+ *               the path.
+ */
+static long long DirectedMove(Fishery *fishery, const long long *flow, 
+	long long fish_pos, int max_moves, int *moves) {
+	long long pos = fish_pos, new_pos = -1;
+	int n;
+
+	*moves = 0;
+	if (flow[pos] == -1)
+		return -1;
+	for (n = 1; n <= max_moves && flow[pos] != pos; n++) {
+		pos = flow[pos];
+		if (fishery->vegetation_layer[pos].local_fish == NULL) {
+			new_pos = pos;
+			*moves = n;
+		}
 	}
-	/* Add soil energy. */
-	for (i = 0; i < settings.size_x*settings.size_y; i++) {
-		fishery->vegetation_layer[i].soil_energy += settings.soil_energy_increase_turn;
-		if (fishery->vegetation_layer[i].soil_energy > settings.soil_energy_max)
-			fishery->vegetation_layer[i].soil_energy = settings.soil_energy_max;
+	return new_pos;
+}
+/* Function TouchMoveIndex().
+ *
+ * Updates the move index of the fishery, if in use, after the local fish
+ * of a tile has changed.
+ */
+static FISHERY_INLINE void TouchMoveIndex(Fishery *fishery, long long coords) {
+	if (fishery->move_index != NULL && fishery->move_index->valid)
+		UpdateMoveIndex(fishery->move_index, fishery, coords);
+}
+/* Function MoveAndFeedFish().
+ *
+ * Moves a fish pool in search of food and consumes vegetation, until the
+ * fish pool has eaten enough or has no moves left.
+ *
+ * fishery		- Initialized or progressed fishery.
+ * plan			- Plan of fishery.
+ * fish			- Fish pool to move and feed.
+ * flow			- Flow field of the directed_moves option, NULL for random
+ *				  hops.
+ * moves		- Incremented by the number of moves.
+ * failed_moves	- Incremented if the fish pool could not move.
+ *
+ * fish_pos		- Index of the tile of the fish pool after moving.
+ */
+static FISHERY_INLINE long long MoveAndFeedFish(Fishery *fishery, const Fishery_Plan *plan, 
+	Fish_Pool *fish, const long long *flow, long long *moves, long long *failed_moves) {
+	const Fishery_Settings *settings = &plan->settings;
+	const int *fish_appetite = plan->fish_appetite;
+	const Fishery_Layout *layout = &fishery->layout;
+	Tile *tile;
+	long long fish_pos, new_pos;
+	int avail_moves, appetite, consumed, directed_moves, radius;
+
+	fish_pos = LayoutIndex(layout, fish->pos_x, fish->pos_y);
+	avail_moves = settings->fish_moves_turn;
+	radius = fishery->options.move_radius > 1 ? fishery->options.move_radius : 1;
+	while (avail_moves > 0 && fish->food_level < fish_appetite[fish->pop_level]) {
+		tile = &fishery->vegetation_layer[fish_pos];
+		if (tile->vegetation_level == 0) {
+			/* If no food at current tile, attempt to move. Directed moves
+			   use up to all available moves, random hops use one. */
+			new_pos = -1;
+			directed_moves = 1;
+			if (flow != NULL)
+				new_pos = DirectedMove(fishery, flow, fish_pos, avail_moves, &directed_moves);
+			if (new_pos == -1) {
+				directed_moves = 1;
+				new_pos = GetNewCoords(fish_pos, radius, settings->size_x, settings->size_y, fishery);
+			}
+			if (new_pos == -1) {
+				/* No move possible. */
+				(*failed_moves)++;
+				break;
+			}
+			*moves += directed_moves;
+			avail_moves -= directed_moves - 1;
+			/* Move fish pool. It eats at the new tile on its next move. */
+			fishery->vegetation_layer[new_pos].local_fish = fish;
+			tile->local_fish = NULL;
+			TouchMoveIndex(fishery, new_pos);
+			TouchMoveIndex(fishery, fish_pos);
+			LayoutCoords(layout, new_pos, &fish->pos_x, &fish->pos_y);
+		}
+		if (tile->vegetation_level > 0) {
+			/* If food at current tile. */
+			/* Amount possible for fish to eat.*/
+			appetite = fish_appetite[fish->pop_level] - fish->food_level; 
+			/* Amount actually consumed based on available food. */
+			consumed = appetite > tile->vegetation_level ? 
+				tile->vegetation_level : appetite; 
+			fish->food_level += consumed;
+			tile->vegetation_level -= consumed;
+		}
+		fish_pos = LayoutIndex(layout, fish->pos_x, fish->pos_y);
+		avail_moves--;
 	}
-	free(vegetation_layer_growth);
+	return fish_pos;
 }
-/* Function UpdateFisheryFishPopulation().
+/* Function MetabolizeFish().
  *
- * Updates the fish population of the fishery simulation. This includes
- * growing fish pools, moving fish pools around in search of food and 
- * consuming vegetation. Also generates new fish pools.
+ * Metabolism of the fish population of the phased_metabolism option. 
+ * Runs over the population levels and food levels of the fish pools in
+ * arrays. Fish pools grow with enough food, or request a split at the 
+ * maximum level, otherwise they consume food and may starve. The passes
+ * over the arrays have no control flow depending on the fish pools,
+ * growth takes one pass per level grown, and the split and death lists
+ * are gathered in a last pass.
+ *
+ * plan			- Plan of fishery.
+ * n			- Number of fish pools.
+ * pop_levels	- Population levels of fish pools, updated.
+ * food_levels	- Food levels of fish pools, updated. Food of fish pools
+ *				  requesting a split is not consumed.
+ * states		- Array of n integers for the state of the fish pools.
+ * split_list	- Indices of fish pools requesting a split, in order.
+ * n_splits		- Set to the number of split requests.
+ * death_list	- Indices of starved fish pools, in order.
+ * n_deaths		- Set to the number of starved fish pools.
+ */
+static void MetabolizeFish(const Fishery_Plan *plan, long long n,
+	int *FISHERY_RESTRICT pop_levels, int *FISHERY_RESTRICT food_levels,
+	int *FISHERY_RESTRICT states, long long *split_list, long long *n_splits,
+	long long *death_list, long long *n_deaths) {
+	const int *FISHERY_RESTRICT fish_growth_threshold = plan->fish_growth_threshold;
+	const int *FISHERY_RESTRICT fish_consumption = plan->settings.fish_consumption;
+	const int fish_level_max = plan->settings.fish_level_max;
+	long long i, splits = 0, deaths = 0;
+	int pop_level, food_level, threshold, fed, starved, grow, level, growing = 1;
+
+	/* Fed fish pools grow below the maximum level and split at it, the
+	   others consume food and starve without food. */
+	for (i = 0; i < n; i++) {
+		pop_level = pop_levels[i];
+		food_level = food_levels[i];
+		fed = food_level >= fish_growth_threshold[pop_level];
+		food_level -= (1 - fed)*fish_consumption[pop_level];
+		starved = food_level < 0;
+		pop_levels[i] = pop_level - starved;
+		food_levels[i] = (1 - starved)*food_level;
+		states[i] = fed*(1 + (pop_level >= fish_level_max));
+	}
+	/* Growing fish pools grow a level per pass while they have enough
+	   food. */
+	for (level = 1; level < fish_level_max && growing; level++) {
+		growing = 0;
+		for (i = 0; i < n; i++) {
+			pop_level = pop_levels[i];
+			food_level = food_levels[i];
+			threshold = fish_growth_threshold[pop_level + (pop_level < fish_level_max)];
+			grow = (states[i] == 1) & (food_level >= fish_growth_threshold[pop_level]) &
+				(pop_level < fish_level_max);
+			pop_levels[i] = pop_level + grow;
+			food_levels[i] = food_level - grow*threshold;
+			growing |= grow;
+		}
+	}
+	/* Split and death lists in order. */
+	for (i = 0; i < n; i++) {
+		split_list[splits] = i;
+		splits += states[i] == 2;
+		death_list[deaths] = i;
+		deaths += pop_levels[i] <= 0;
+	}
+	*n_splits = splits;
+	*n_deaths = deaths;
+}
+/* Function UpdateFishPhased().
+ *
+ * Fish population update of the phased_metabolism option. All fish pools
+ * first move and feed in list order. The metabolism then runs over 
+ * contiguous arrays of the population and food levels, see 
+ * MetabolizeFish. Starved fish pools are removed before the split 
+ * requests are carried out in list order, so the tiles of starved fish 
+ * pools are free for splitting.
  *
  * fishery		- Initialized or progressed fishery.
- * settings		- Settings for fishery.
+ * plan			- Plan of fishery.
+ * split		- 1 if fish pools split at maximum level, 0 otherwise.
+ * flow			- Flow field of the directed_moves option, NULL for random
+ *				  hops.
+ */
+static void UpdateFishPhased(Fishery *fishery, const Fishery_Plan *plan, 
+	const int split, const long long *flow) {
+	const Fishery_Settings *settings = &plan->settings;
+	const Fishery_Layout *layout = &fishery->layout;
+	LList_Node *fish_node, *prev = NULL, *tail;
+	Fish_Pool **fishes, *fish, *new_fish;
+	int *pop_levels, *food_levels, *states;
+	long long *split_list, *death_list, n = 0, i, n_splits, n_deaths, fish_pos, new_pos;
+	size_t n_alloc;
+
+	/* Arrays of the fish pools are reserved once for the whole population. */
+	for (fish_node = fishery->fish_list; fish_node != NULL && fish_node->node_value != NULL;
+		fish_node = fish_node->next)
+		n++;
+	n_alloc = (size_t)(n > 0 ? n : 1);
+	fishes = malloc(sizeof(Fish_Pool *)*n_alloc);
+	pop_levels = malloc(sizeof(int)*n_alloc);
+	food_levels = malloc(sizeof(int)*n_alloc);
+	states = malloc(sizeof(int)*n_alloc);
+	split_list = malloc(sizeof(long long)*n_alloc);
+	death_list = malloc(sizeof(long long)*n_alloc);
+	if (fishes == NULL || pop_levels == NULL || food_levels == NULL || 
+		states == NULL || split_list == NULL || death_list == NULL) {
+		free(fishes);
+		free(pop_levels);
+		free(food_levels);
+		free(states);
+		free(split_list);
+		free(death_list);
+		printf("Failed to reserve memory for %lld fish pools.\n", n);
+		exit(EXIT_FAILURE);
+	}
+	/* Movement and feeding, fish pools are gathered into the arrays. */
+	i = 0;
+	for (fish_node = fishery->fish_list; fish_node != NULL && fish_node->node_value != NULL;
+		fish_node = fish_node->next) {
+		fish = fish_node->node_value;
+		MoveAndFeedFish(fishery, plan, fish, flow, 
+			&fishery->events.moves, &fishery->events.failed_moves);
+		fishes[i] = fish;
+		pop_levels[i] = fish->pop_level;
+		food_levels[i] = fish->food_level;
+		i++;
+	}
+	MetabolizeFish(plan, n, pop_levels, food_levels, states, split_list, &n_splits,
+		death_list, &n_deaths);
+	for (i = 0; i < n; i++) {
+		fishes[i]->pop_level = pop_levels[i];
+		fishes[i]->food_level = food_levels[i];
+	}
+	/* Remove starved fish pools. */
+	for (i = 0; i < n_deaths; i++) {
+		fish = fishes[death_list[i]];
+		fish_pos = LayoutIndex(layout, fish->pos_x, fish->pos_y);
+		fishery->vegetation_layer[fish_pos].local_fish = NULL;
+		TouchMoveIndex(fishery, fish_pos);
+	}
+	fishery->events.starvation_deaths += n_deaths;
+	fish_node = fishery->fish_list;
+	while (n_deaths > 0 && fish_node != NULL && fish_node->node_value != NULL) {
+		if (((Fish_Pool *)fish_node->node_value)->pop_level <= 0) {
+			free(LListRemove(fishery->fish_list, prev, fish_node));
+			fish_node = prev != NULL ? prev->next : fishery->fish_list;
+		}
+		else {
+			prev = fish_node;
+			fish_node = fish_node->next;
+		}
+	}
+	/* Split fish pools. New coordinates are generated even without 
+	   splitting to keep the random number sequence. */
+	for (tail = fishery->fish_list; tail->next != NULL; tail = tail->next);
+	for (i = 0; i < n_splits; i++) {
+		fish = fishes[split_list[i]];
+		fish_pos = LayoutIndex(layout, fish->pos_x, fish->pos_y);
+		new_pos = GetNewCoords(fish_pos, 1, settings->size_x, settings->size_y, fishery);
+		if (split && new_pos != -1) {
+			fish->food_level -= plan->fish_growth_threshold[fish->pop_level];
+			new_fish = malloc(sizeof(Fish_Pool));
+			new_fish->food_level = 0;
+			new_fish->pop_level = 1;
+			LayoutCoords(layout, new_pos, &new_fish->pos_x, &new_fish->pos_y);
+			fishery->vegetation_layer[new_pos].local_fish = new_fish;
+			TouchMoveIndex(fishery, new_pos);
+			tail = LListAppend(tail, new_fish);
+			fishery->events.splits++;
+		}
+		else {
+			if (split)
+				fishery->events.failed_splits++;
+			fish->food_level -= settings->fish_consumption[fish->pop_level];
+		}
+	}
+	free(fishes);
+	free(pop_levels);
+	free(food_levels);
+	free(states);
+	free(split_list);
+	free(death_list);
+}
+/* Function FishKernel().
+ *
+ * Body of the fish population update. Called with constant split and 
+ * spawn flags from the specialized kernels below, so the compiler removes
+ * the branches on these settings from the loop over the fish population.
+ *
+ * fishery		- Initialized or progressed fishery.
+ * plan			- Plan of fishery.
+ * split		- 1 if fish pools split at maximum level, 0 otherwise.
+ * spawn		- 1 if fish pools spawn randomly, 0 otherwise.
  *
  */
-void UpdateFisheryFishPopulation(
-	Fishery *fishery, Fishery_Settings settings) {
-	LList_Node *fish_node, *for_deletion = NULL;
+static FISHERY_INLINE void FishKernel(
+	Fishery *fishery, const Fishery_Plan *plan, const int split, const int spawn) {
+	const Fishery_Settings *settings = &plan->settings;
+	const int *fish_growth_threshold = plan->fish_growth_threshold,
+		*fish_consumption = settings->fish_consumption;
+	const int size_x = settings->size_x, size_y = settings->size_y, 
+		fish_level_max = settings->fish_level_max;
+	const Fishery_Layout *layout = &fishery->layout;
+	LList_Node *fish_node, *for_deletion = NULL, *tail = NULL;
 	Fish_Pool *fish, *new_fish, *first_added = NULL;
-	int fish_pos, avail_moves, appetite, consumed, new_pos, i, pos_avail_n, *pos_avail;
-	double random_fishes_counter = settings.random_fishes_interval / 100.0;
+	long long fish_pos, new_pos, i, pos_avail_n, *flow = NULL;
+	long long moves = 0, failed_moves = 0, splits = 0, failed_splits = 0,
+		starvation_deaths = 0;
+	int pos_x, pos_y;
 
-	/* Process fish population. */
-	fish_node = fishery->fish_list;
+	/* The directed_moves option falls back to random hops without memory. */
+	if (fishery->options.directed_moves)
+		flow = BuildFlowField(fishery);
+	/* Random moves over many tiles use the move index. */
+	if (fishery->options.move_radius >= MOVE_INDEX_MIN_RADIUS) {
+		if (fishery->move_index == NULL)
+			fishery->move_index = CreateMoveIndex(size_x, size_y);
+		if (fishery->move_index != NULL)
+			BuildMoveIndex(fishery->move_index, fishery);
+	}
+	/* Process fish population. The phased_metabolism option processes the
+	   whole population in UpdateFishPhased instead of fish by fish. */
+	if (fishery->options.phased_metabolism)
+		UpdateFishPhased(fishery, plan, split, flow);
+	fish_node = fishery->options.phased_metabolism ? NULL : fishery->fish_list;
 	/* Empty list will have an empty node at the beginning. */
 	while (fish_node && fish_node->node_value && fish_node->node_value != first_added) { 
 		fish = fish_node->node_value;
-		fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
-		/* fish_pos = fish->pos_x + fish->pos_y*settings.size_x; */
 		/* Consume food and move if needed. */
-		avail_moves = settings.fish_moves_turn;
-		while (avail_moves > 0 && fish->food_level < 
-			settings.fish_consumption[fish->pop_level]* 2 + settings.fish_growth_req) {
-			fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
-			/* fish_pos = fish->pos_x + fish->pos_y*settings.size_x; */
-			if (fishery->vegetation_layer[fish_pos].vegetation_level == 0) {
-				/* If no food at current tile, attempt to move. */
-				new_pos = GetNewCoords(fish_pos, 1, settings.size_x, settings.size_y, fishery);
-				if (new_pos == -1) {
-					/* No move possible. */
-					break;
-				}
-				else {
-					/* Move fish pool. */
-					fishery->vegetation_layer[new_pos].local_fish = fish;
-					fishery->vegetation_layer[fish_pos].local_fish = NULL;
-					/* fish->pos_x = new_pos % settings.size_x;
-					fish->pos_y = new_pos / settings.size_y; */
-					fish->pos_x = new_pos / settings.size_y;
-					fish->pos_y = new_pos % settings.size_y;
-				}
-			}
-			if (fishery->vegetation_layer[fish_pos].vegetation_level > 0) {
-				/* If food at current tile. */
-				/* Amount possible for fish to eat.*/
-				appetite = settings.fish_consumption[fish->pop_level] * 2 +
-					settings.fish_growth_req - fish->food_level; 
-				/* Amount actually consumed based on available food. */
-				consumed = appetite > fishery->vegetation_layer[fish_pos].
-					vegetation_level ? fishery->vegetation_layer[fish_pos].
-				    vegetation_level : appetite; 
-				fish->food_level += consumed;
-				fishery->vegetation_layer[fish_pos].vegetation_level 
-					-= consumed;
-			}
-			avail_moves--;
-		}
-		/* fish_pos = fish->pos_x + fish->pos_y*settings.size_x; */
-		fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
-		if (fish->food_level >= settings.fish_growth_req + settings.fish_consumption[fish->pop_level]) {	
+		fish_pos = MoveAndFeedFish(fishery, plan, fish, flow, &moves, &failed_moves);
+		if (fish->food_level >= fish_growth_threshold[fish->pop_level]) {	
 			/* If enough food for growth or split present. */ 
-			if (fish->pop_level < settings.fish_level_max) {
+			if (fish->pop_level < fish_level_max) {
 				/* Grow fish pool if not max size. */
-				while (fish->food_level >= settings.fish_growth_req + 
-					settings.fish_consumption[fish->pop_level] && 
-					fish->pop_level < settings.fish_level_max) {
+				while (fish->food_level >= fish_growth_threshold[fish->pop_level] && 
+					fish->pop_level < fish_level_max) {
 					fish->pop_level++;
-					fish->food_level -= (settings.fish_growth_req + 
-						settings.fish_consumption[fish->pop_level]);
+					fish->food_level -= fish_growth_threshold[fish->pop_level];
 				}
 			}
 			else {
-				/* Else split fish pool. */
-				new_pos = GetNewCoords(fish_pos, 1, settings.size_x, settings.size_y, fishery);
-				if (new_pos != -1 && settings.split_fishes_at_max) {
+				/* Else split fish pool. New coordinates are generated even
+				   without splitting to keep the random number sequence. */
+				new_pos = GetNewCoords(fish_pos, 1, size_x, size_y, fishery);
+				if (split && new_pos != -1) {
 					/* Position for splitting available. */
-					fish->food_level -= (settings.fish_growth_req +
-						settings.fish_consumption[fish->pop_level]);
+					fish->food_level -= fish_growth_threshold[fish->pop_level];
 					new_fish = malloc(sizeof(Fish_Pool));
 					new_fish->food_level = 0;
 					new_fish->pop_level = 1;
-					/* fish->pos_x = new_pos % settings.size_x;
-					fish->pos_y = new_pos / settings.size_y; */
-					new_fish->pos_x = new_pos / settings.size_y;
-					new_fish->pos_y = new_pos % settings.size_y;
+					LayoutCoords(layout, new_pos, &new_fish->pos_x, &new_fish->pos_y);
 					fishery->vegetation_layer[new_pos].local_fish = new_fish;
-					LListAdd(fishery->fish_list, new_fish);
+					TouchMoveIndex(fishery, new_pos);
+					if (tail == NULL)
+						for (tail = fishery->fish_list; tail->next != NULL; tail = tail->next);
+					tail = LListAppend(tail, new_fish);
 					if (first_added == NULL) first_added = new_fish;
+					splits++;
 				}
 				else {
 					/* No position available, consume food normally. */
-					fish->food_level -= settings.fish_consumption[fish->pop_level];
+					if (split)
+						failed_splits++;
+					fish->food_level -= fish_consumption[fish->pop_level];
 				}
 			}
 		}
 		else { 
 			/* Else consume food needed by fish pool population. */
-			fish->food_level -= settings.fish_consumption[fish->pop_level];
+			fish->food_level -= fish_consumption[fish->pop_level];
 			if (fish->food_level < 0) {
 				fish->pop_level--;
 				fish->food_level = 0;
 				if (fish->pop_level <= 0) {
 					for_deletion = fish_node;
+					starvation_deaths++;
 				}
 			}
 		}
 		if (for_deletion != NULL) {
-			/* fish_pos = fish->pos_x + fish->pos_y*settings.size_x; */
-			fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
 			fishery->vegetation_layer[fish_pos].local_fish = NULL;
+			TouchMoveIndex(fishery, fish_pos);
+			/* Popping frees the node of the fish, or the second node if the
+			   fish is first in the list. Forget the last node if it is freed. */
+			if (tail == for_deletion || 
+				(fishery->fish_list == for_deletion && tail == for_deletion->next))
+				tail = NULL;
 			if (fishery->fish_list != for_deletion) {
 				/* If the fish is not the first fish in the list, move pointer to next fish. */
 				fish_node = fish_node->next;
@@ -374,35 +1462,177 @@ void UpdateFisheryFishPopulation(
 			fish_node = fish_node->next;
 		}
 	}
-	if (settings.random_fishes_interval) {
-		if (random_fishes_counter >= rand() / ((double) RAND_MAX + 1L)) {
-			/* Spawn fish randomly. Start by finding 
+	if (spawn) {
+		if (plan->random_fishes_probability >= FISHERY_RAND() / ((double) RAND_MAX + 1L)) {
+			/* Spawn fish randomly. Start by counting 
 			   available positions for fishes. */
-			pos_avail = malloc(sizeof(int)*settings.size_x*settings.size_y);
 			pos_avail_n = 0;
-			for (i = 0; i < settings.size_x*settings.size_y; i++) {
-				if (fishery->vegetation_layer[i].local_fish == NULL)
-					pos_avail[pos_avail_n++] = i;
+			for (pos_x = 0; pos_x < size_x; pos_x++) {
+				for (pos_y = 0; pos_y < size_y; pos_y++) {
+					if (fishery->vegetation_layer[LayoutIndex(layout, pos_x, pos_y)]
+						.local_fish == NULL)
+						pos_avail_n++;
+				}
 			}
 			if (pos_avail_n > 0) {
 				/* If there's room for a new fish. */
-				//new_pos = (int)(rand() / (double)(RAND_MAX + 1L)*(pos_avail_n - 1));
-				new_pos = GENERATERANDINT(0, pos_avail_n - 1);
-				new_pos = pos_avail[new_pos];
+				i = GenerateRandLong(0, pos_avail_n - 1);
+				/* Find the chosen available position, counted column by 
+				   column in every layout. */
+				new_pos = -1;
+				for (pos_x = 0; pos_x < size_x && new_pos == -1; pos_x++) {
+					for (pos_y = 0; pos_y < size_y; pos_y++) {
+						fish_pos = LayoutIndex(layout, pos_x, pos_y);
+						if (fishery->vegetation_layer[fish_pos].local_fish == NULL && i-- == 0) {
+							new_pos = fish_pos;
+							break;
+						}
+					}
+				}
 				new_fish = malloc(sizeof(Fish_Pool));
 				new_fish->food_level = 0;
 				new_fish->pop_level = 1;
-				/* new_fish->pos_x = new_pos % settings.size_x;
-				new_fish->pos_y = new_pos / settings.size_y; */
-				new_fish->pos_x = new_pos / settings.size_y;
-				new_fish->pos_y = new_pos % settings.size_y;
-				LListAdd(fishery->fish_list, new_fish);
+				LayoutCoords(layout, new_pos, &new_fish->pos_x, &new_fish->pos_y);
+				if (tail == NULL)
+					for (tail = fishery->fish_list; tail->next != NULL; tail = tail->next);
+				LListAppend(tail, new_fish);
 				fishery->vegetation_layer[new_pos].local_fish = new_fish;
+				TouchMoveIndex(fishery, new_pos);
+				fishery->events.spawns++;
 			}
-			random_fishes_counter = 0;
-			free(pos_avail);
 		}
 	}
+	free(flow);
+	if (fishery->move_index != NULL)
+		fishery->move_index->valid = 0;
+	fishery->events.moves += moves;
+	fishery->events.failed_moves += failed_moves;
+	fishery->events.splits += splits;
+	fishery->events.failed_splits += failed_splits;
+	fishery->events.starvation_deaths += starvation_deaths;
+}
+/* Specialized fish update kernels, indexed by FISH_KERNEL_* flags. */
+static void FishKernelPlain(Fishery *fishery, const Fishery_Plan *plan) {
+	FishKernel(fishery, plan, 0, 0);
+}
+static void FishKernelSplit(Fishery *fishery, const Fishery_Plan *plan) {
+	FishKernel(fishery, plan, 1, 0);
+}
+static void FishKernelSpawn(Fishery *fishery, const Fishery_Plan *plan) {
+	FishKernel(fishery, plan, 0, 1);
+}
+static void FishKernelSplitSpawn(Fishery *fishery, const Fishery_Plan *plan) {
+	FishKernel(fishery, plan, 1, 1);
+}
+static void (*const FISH_KERNELS[FISH_KERNEL_N])(Fishery *, const Fishery_Plan *) = {
+	FishKernelPlain, FishKernelSplit, FishKernelSpawn, FishKernelSplitSpawn
+};
+/* Digits of the radix sort of SortFisheryFish. */
+#define FISHERY_SORT_BITS 11
+#define FISHERY_SORT_BUCKETS (1 << FISHERY_SORT_BITS)
+/* Function SortFisheryFish().
+ *
+ * Sorts the fish population of the fishery by position, column by column,
+ * so consecutive fish pools access nearby tiles. Uses a stable radix sort
+ * by position. The nodes and fish pools of the list stay in place and the
+ * fish pools are copied between them, so a pointer to a fish pool may 
+ * point to another fish pool after sorting. The order depends only on the
+ * positions, so it is the same in every layout.
+ *
+ * fishery		- Initialized or progressed fishery.
+ *
+ * Returns 1 if successful, 0 if memory could not be reserved.
+ */
+int SortFisheryFish(Fishery *fishery) {
+	LList_Node *fish_node;
+	Fish_Pool **fishes, **sorted, **swap, *fish, *pools;
+	unsigned long long *keys, *sorted_keys, *swap_keys, n_cells;
+	long long n = 0, i, counts[FISHERY_SORT_BUCKETS + 1];
+	int shift, digit;
+
+	for (fish_node = fishery->fish_list; fish_node != NULL && fish_node->node_value != NULL;
+		fish_node = fish_node->next)
+		n++;
+	if (n < 2)
+		return 1;
+	fishes = malloc(sizeof(Fish_Pool *)*(size_t)n*2);
+	keys = malloc(sizeof(unsigned long long)*(size_t)n*2);
+	if (fishes == NULL || keys == NULL) {
+		free(fishes);
+		free(keys);
+		return 0;
+	}
+	sorted = fishes + n;
+	sorted_keys = keys + n;
+	for (fish_node = fishery->fish_list, i = 0; i < n; fish_node = fish_node->next, i++) {
+		fish = fish_node->node_value;
+		fishes[i] = fish;
+		keys[i] = (unsigned long long)fish->pos_y + 
+			(unsigned long long)fish->pos_x*(unsigned long long)fishery->layout.size_y;
+	}
+	/* Sort digit by digit, up to the highest digit of the positions. */
+	n_cells = (unsigned long long)fishery->layout.size_x*(unsigned long long)fishery->layout.size_y;
+	for (shift = 0; shift < 64 && (n_cells - 1) >> shift > 0; shift += FISHERY_SORT_BITS) {
+		memset(counts, 0, sizeof(counts));
+		for (i = 0; i < n; i++)
+			counts[((keys[i] >> shift) & (FISHERY_SORT_BUCKETS - 1)) + 1]++;
+		for (digit = 0; digit < FISHERY_SORT_BUCKETS; digit++)
+			counts[digit + 1] += counts[digit];
+		for (i = 0; i < n; i++) {
+			digit = (int)((keys[i] >> shift) & (FISHERY_SORT_BUCKETS - 1));
+			sorted[counts[digit]] = fishes[i];
+			sorted_keys[counts[digit]++] = keys[i];
+		}
+		swap = fishes;
+		fishes = sorted;
+		sorted = swap;
+		swap_keys = keys;
+		keys = sorted_keys;
+		sorted_keys = swap_keys;
+	}
+	/* The fish pools are copied in order into the fish pools of the list,
+	   which keeps the nodes and fish pools in their order in memory. */
+	pools = malloc(sizeof(Fish_Pool)*(size_t)n);
+	if (pools == NULL) {
+		for (fish_node = fishery->fish_list, i = 0; i < n; fish_node = fish_node->next, i++)
+			fish_node->node_value = fishes[i];
+	}
+	else {
+		for (i = 0; i < n; i++)
+			pools[i] = *fishes[i];
+		for (fish_node = fishery->fish_list, i = 0; i < n; fish_node = fish_node->next, i++) {
+			fish = fish_node->node_value;
+			*fish = pools[i];
+			fishery->vegetation_layer[LayoutIndex(&fishery->layout, fish->pos_x, 
+				fish->pos_y)].local_fish = fish;
+		}
+		free(pools);
+	}
+	/* Free the arrays from their first halves. */
+	free(fishes < sorted ? fishes : sorted);
+	free(keys < sorted_keys ? keys : sorted_keys);
+	return 1;
+}
+/* Function UpdateFisheryFishPopulation().
+ *
+ * Updates the fish population of the fishery simulation. This includes
+ * growing fish pools, moving fish pools around in search of food and 
+ * consuming vegetation. Also generates new fish pools. The spatial_sort
+ * option sorts the fish pools by position first, see SortFisheryFish.
+ *
+ * fishery		- Initialized or progressed fishery.
+ * settings		- Settings for fishery.
+ *
+ */
+void UpdateFisheryFishPopulation(
+	Fishery *fishery, Fishery_Settings settings) {
+	const Fishery_Plan *plan = GetFisheryPlan(fishery, settings);
+	Fishery_RNG *previous_stream = SelectFisheryRNG(fishery);
+
+	if (fishery->options.spatial_sort)
+		SortFisheryFish(fishery);
+	FISH_KERNELS[plan->fish_kernel](fishery, plan);
+	fishery_rng_stream = previous_stream;
 }
 /* Function DestroyFishery().
 
@@ -414,8 +1644,14 @@ settings    - Settings for fishery.
 void DestroyFishery(void *fishery) {
 	Fishery *fishery_ptr = (Fishery *) fishery;
 	LListDestroy(fishery_ptr->fish_list, free);
-	free(fishery_ptr->vegetation_layer);
-	if (fishery_ptr->settings != NULL) {
+	DestroyPlan(fishery_ptr->plan);
+	DestroyMoveIndex(fishery_ptr->move_index);
+	if (fishery_ptr->storage != NULL)
+		StorageRelease(fishery_ptr->storage);
+	else
+		free(fishery_ptr->vegetation_layer);
+	/* Shared settings are freed by their owner. */
+	if (fishery_ptr->settings != NULL && fishery_ptr->settings_owner == NULL) {
 		if (fishery_ptr->settings->vegetation_consumption != NULL)
 			free(fishery_ptr->settings->vegetation_consumption);
 		if (fishery_ptr->settings->fish_consumption != NULL)
@@ -424,6 +1660,64 @@ void DestroyFishery(void *fishery) {
 	}
 	free(fishery_ptr);
 }
+/* Function: RandUnit
+ * -------------------
+ * Returns uniformly distributed random number in (0, 1].
+ */
+static double RandUnit(void) {
+	return (FISHERY_RAND() + 1.0) / ((double)RAND_MAX + 1.0);
+}
+/* Function: FishingEventSampled
+ * -----------------------------
+ * Fishing event of the fishing_sampling option. Draws only the fished fish 
+ * pools, with the same distribution as the trial per fish pool of 
+ * FishingEvent: the amount of fish pools skipped before the next fished
+ * pool is geometric, and a fished pool is fished again until a trial fails
+ * or the pool dies, so its yield is geometric limited by its population.
+ *
+ * fishery:		Initialized or progressed fishery.
+ * probability:	Probability of a fishing trial succeeding.
+ *
+ * Returns:		Fish population lost during event.
+ */
+static long long FishingEventSampled(
+	Fishery *fishery, double probability) {
+	LList_Node *fish_node, *prev = NULL;
+	Fish_Pool *fish;
+	long long fish_pos, tot_yield = 0;
+	double skip, repeats;
+	int yield;
+
+	fish_node = fishery->fish_list;
+	while (fish_node != NULL && fish_node->node_value != NULL) {
+		/* Skip fish pools whose trial fails. */
+		skip = probability >= 1.0 ? 0.0 : floor(log(RandUnit()) / log1p(-probability));
+		for (; skip >= 1.0 && fish_node != NULL; skip--) {
+			prev = fish_node;
+			fish_node = fish_node->next;
+		}
+		if (fish_node == NULL)
+			break;
+		/* Successful trials after the first one. */
+		fish = fish_node->node_value;
+		repeats = probability >= 1.0 ? fish->pop_level : floor(log(RandUnit()) / log(probability));
+		yield = repeats + 1 >= fish->pop_level ? fish->pop_level : (int)repeats + 1;
+		fish->pop_level -= yield;
+		tot_yield += yield;
+		if (fish->pop_level <= 0) {
+			fish_pos = LayoutIndex(&fishery->layout, fish->pos_x, fish->pos_y);
+			fishery->vegetation_layer[fish_pos].local_fish = NULL;
+			free(LListRemove(fishery->fish_list, prev, fish_node));
+			fishery->events.fishing_deaths++;
+			fish_node = prev != NULL ? prev->next : fishery->fish_list;
+		}
+		else {
+			prev = fish_node;
+			fish_node = fish_node->next;
+		}
+	}
+	return tot_yield;
+}
 /* Function FishingEvent().
  *
  * Releases the fishing boats! Based on the fishing_chance, each
@@ -431,22 +1725,35 @@ void DestroyFishery(void *fishery) {
  * of the fishing event, i.e. total amount of fish population
  * level lost.
  *
+ * With the fishing_sampling option only the fished fish pools are drawn,
+ * see FishingEventSampled.
+ *
  * fishery     - Initialized or progressed fishery.
  * settings    - Settings for fishery.
  *
  * yield       - Fish population lost during event. 
  *
  */
-int FishingEvent(
+long long FishingEvent(
 	Fishery *fishery, Fishery_Settings settings) {
-	int yield=0, fish_pos, tot_yield=0;
+	const Fishery_Plan *plan = GetFisheryPlan(fishery, settings);
+	const double fishing_probability = plan->fishing_probability;
+	long long fish_pos, tot_yield=0;
+	int yield=0;
 	LList_Node *fish_node, *for_deletion=NULL;
 	Fish_Pool *fish;
+	Fishery_RNG *previous_stream = SelectFisheryRNG(fishery);
+
+	if (fishery->options.fishing_sampling) {
+		tot_yield = FishingEventSampled(fishery, plan->fishing_probability_eff);
+		fishery_rng_stream = previous_stream;
+		return tot_yield;
+	}
 
 	fish_node = fishery->fish_list;
 	while (fish_node != NULL && fish_node->node_value != NULL) {
 		fish = fish_node->node_value;
-		if (rand() / (double)(RAND_MAX + 1L) <= (double) settings.fishing_chance/100) {
+		if (FISHERY_RAND() / (double)(RAND_MAX + 1L) <= fishing_probability) {
 			/*  yield = (int) round(rand() / (double)(RAND_MAX + 1) * (fish->pop_level/2+1));
 			yield = (int) ceil(fish->pop_level*settings.fishing_chance); */
 			/* yield = fish->pop_level; */
@@ -455,7 +1762,7 @@ int FishingEvent(
 			tot_yield += yield;
 			if (fish->pop_level <= 0) {		
 				/* fish_pos = fish->pos_x + fish->pos_y*settings.size_x; */
-				fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
+				fish_pos = LayoutIndex(&fishery->layout, fish->pos_x, fish->pos_y);
 				for_deletion = fish_node;
 				if (fishery->fish_list != fish_node) {
 					/* If the fish is not the first fish in the list. */
@@ -464,10 +1771,12 @@ int FishingEvent(
 				free(LListPop(fishery->fish_list, for_deletion->node_value, ComparePointers));
 				fishery->vegetation_layer[fish_pos].local_fish = NULL;
 				for_deletion = NULL;
+				fishery->events.fishing_deaths++;
 			}
 		}
 		else
 			fish_node = fish_node->next;
 	}
+	fishery_rng_stream = previous_stream;
 	return tot_yield;
 }
\ No newline at end of file
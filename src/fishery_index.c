@@ -0,0 +1,326 @@
+/*****************************************************************************
+ * Filename: fishery_index.c												 *
+ *																			 *
+ * Contains functions for the move index of a fishery, see fishery_index.h. *
+ * The Fenwick trees are indexed by position, column by column, so the		 *
+ * index is the same in every layout of the vegetation layer.				 *
+ *																			 *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "fishery_index.h"
+#include "fishery_layout.h"
+#include "help_functions.h"
+
+/* States of a tile in the move index. */
+#define MOVE_INDEX_FREE			1
+#define MOVE_INDEX_VEGETATION	2
+
+/* Function: TileState
+ * -------------------
+ * Returns state of tile in the move index. Like GetNewCoords, vegetation
+ * counts from vegetation level two.
+ */
+static int TileState(const Tile *tile) {
+	if (tile->local_fish != NULL)
+		return 0;
+	return MOVE_INDEX_FREE | (tile->vegetation_level > 1 ? MOVE_INDEX_VEGETATION : 0);
+}
+/* Function: CreateMoveIndex
+ * -------------------------
+ * Reserves move index for a vegetation layer. The index is empty until
+ * built with BuildMoveIndex.
+ *
+ * size_x:	Width of vegetation layer.
+ * size_y:	Height of vegetation layer.
+ *
+ * Returns:	Pointer to Fishery_Move_Index, NULL if the vegetation layer is
+ *			too large or memory could not be reserved.
+ */
+Fishery_Move_Index *CreateMoveIndex(int size_x, int size_y) {
+	Fishery_Move_Index *index;
+	long long n_cells = (long long)size_x*size_y;
+
+	if (n_cells > INT_MAX) {
+		printf("Vegetation layer too large for move index.\n");
+		return NULL;
+	}
+	index = calloc(1, sizeof(Fishery_Move_Index));
+	if (index == NULL)
+		return NULL;
+	index->size_x = size_x;
+	index->size_y = size_y;
+	index->free_counts = malloc(sizeof(int)*(size_t)n_cells);
+	index->vegetation_counts = malloc(sizeof(int)*(size_t)n_cells);
+	index->states = malloc((size_t)n_cells);
+	if (index->free_counts == NULL || index->vegetation_counts == NULL ||
+		index->states == NULL) {
+		DestroyMoveIndex(index);
+		return NULL;
+	}
+	return index;
+}
+/* Function: BuildMoveIndex
+ * ------------------------
+ * Builds move index from the vegetation layer of fishery in linear time,
+ * first along the columns and then along the rows.
+ *
+ * *index:		Move index of fishery.
+ * *fishery:	Initialized or progressed fishery.
+ */
+void BuildMoveIndex(Fishery_Move_Index *index, const Fishery *fishery) {
+	const int size_x = index->size_x, size_y = index->size_y;
+	int *free_counts = index->free_counts, *vegetation_counts = index->vegetation_counts;
+	long long cell, parent;
+	int pos_x, pos_y, i, state;
+
+	for (pos_x = 0, cell = 0; pos_x < size_x; pos_x++) {
+		for (pos_y = 0; pos_y < size_y; pos_y++, cell++) {
+			state = TileState(&fishery->vegetation_layer[
+				LayoutIndex(&fishery->layout, pos_x, pos_y)]);
+			index->states[cell] = (unsigned char)state;
+			free_counts[cell] = (state & MOVE_INDEX_FREE) != 0;
+			vegetation_counts[cell] = (state & MOVE_INDEX_VEGETATION) != 0;
+		}
+	}
+	/* Node i (from one) of a Fenwick tree adds its sum to node i + (i & -i). */
+	for (pos_x = 0; pos_x < size_x; pos_x++) {
+		for (i = 1; i <= size_y; i++) {
+			if (i + (i & -i) > size_y)
+				continue;
+			cell = (long long)pos_x*size_y + i - 1;
+			parent = cell + (i & -i);
+			free_counts[parent] += free_counts[cell];
+			vegetation_counts[parent] += vegetation_counts[cell];
+		}
+	}
+	for (i = 1; i <= size_x; i++) {
+		if (i + (i & -i) > size_x)
+			continue;
+		cell = (long long)(i - 1)*size_y;
+		parent = cell + (long long)(i & -i)*size_y;
+		for (pos_y = 0; pos_y < size_y; pos_y++) {
+			free_counts[parent + pos_y] += free_counts[cell + pos_y];
+			vegetation_counts[parent + pos_y] += vegetation_counts[cell + pos_y];
+		}
+	}
+	index->valid = 1;
+}
+/* Function: AddMoveIndex
+ * ----------------------
+ * Adds delta to the count of position in a Fenwick tree of the index.
+ */
+static void AddMoveIndex(const Fishery_Move_Index *index, int *counts,
+	int pos_x, int pos_y, int delta) {
+	int i, j;
+
+	for (i = pos_x + 1; i <= index->size_x; i += i & -i) {
+		for (j = pos_y + 1; j <= index->size_y; j += j & -j)
+			counts[(long long)(i - 1)*index->size_y + j - 1] += delta;
+	}
+}
+/* Function: UpdateMoveIndex
+ * -------------------------
+ * Updates move index after the local fish or the vegetation level of a
+ * tile has changed.
+ *
+ * *index:		Move index of fishery.
+ * *fishery:	Fishery of index.
+ * coords:		Index of the changed tile in the layout of the vegetation
+ *				layer.
+ */
+void UpdateMoveIndex(Fishery_Move_Index *index, const Fishery *fishery, long long coords) {
+	long long cell;
+	int pos_x, pos_y, state, previous;
+
+	LayoutCoords(&fishery->layout, coords, &pos_x, &pos_y);
+	cell = pos_y + (long long)pos_x*index->size_y;
+	state = TileState(&fishery->vegetation_layer[coords]);
+	previous = index->states[cell];
+	if (state == previous)
+		return;
+	index->states[cell] = (unsigned char)state;
+	if ((state ^ previous) & MOVE_INDEX_FREE)
+		AddMoveIndex(index, index->free_counts, pos_x, pos_y,
+			state & MOVE_INDEX_FREE ? 1 : -1);
+	if ((state ^ previous) & MOVE_INDEX_VEGETATION)
+		AddMoveIndex(index, index->vegetation_counts, pos_x, pos_y,
+			state & MOVE_INDEX_VEGETATION ? 1 : -1);
+}
+/* Function: ColumnCount
+ * ---------------------
+ * Returns the count of the rows of the row ranges in the columns of node
+ * (from one) of a Fenwick tree, i.e. in its range of columns.
+ *
+ * *counts:		Fenwick tree of index.
+ * size_y:		Height of vegetation layer.
+ * node:		Node of the columns, from one.
+ * rows:		Row ranges, first and last row of each range.
+ * n_rows:		Number of row ranges.
+ */
+static int ColumnCount(const int *counts, int size_y, int node, int rows[2][2], int n_rows) {
+	const int *column = counts + (long long)(node - 1)*size_y;
+	int i, j, count = 0;
+
+	for (i = 0; i < n_rows; i++) {
+		for (j = rows[i][1] + 1; j > 0; j -= j & -j)
+			count += column[j - 1];
+		for (j = rows[i][0]; j > 0; j -= j & -j)
+			count -= column[j - 1];
+	}
+	return count;
+}
+/* Function: PrefixCount
+ * ---------------------
+ * Returns the count of the row ranges in the columns up to pos_x.
+ */
+static int PrefixCount(const int *counts, int size_y, int pos_x, int rows[2][2], int n_rows) {
+	int i, count = 0;
+
+	for (i = pos_x + 1; i > 0; i -= i & -i)
+		count += ColumnCount(counts, size_y, i, rows, n_rows);
+	return count;
+}
+/* Function: WindowRanges
+ * ----------------------
+ * Splits range of positions of a window across a border of a toroidal
+ * vegetation layer into ranges inside the layer, in the order of the
+ * positions of the window.
+ *
+ * start:		First position of window, may be negative.
+ * end:			Last position of window, may be at least size.
+ * size:		Size of vegetation layer.
+ * ranges:		First and last position of each range.
+ *
+ * Returns:		Number of ranges.
+ */
+static int WindowRanges(int start, int end, int size, int ranges[2][2]) {
+	if (start < 0) {
+		ranges[0][0] = start + size;
+		ranges[0][1] = size - 1;
+		ranges[1][0] = 0;
+		ranges[1][1] = end;
+		return 2;
+	}
+	if (end > size - 1) {
+		ranges[0][0] = start;
+		ranges[0][1] = size - 1;
+		ranges[1][0] = 0;
+		ranges[1][1] = end - size;
+		return 2;
+	}
+	ranges[0][0] = start;
+	ranges[0][1] = end;
+	return 1;
+}
+/* Function: SelectInWindow
+ * ------------------------
+ * Finds the tile of rank rank among the counted tiles of a window, in the
+ * order in which GetNewCoords scans the window, i.e. column by column.
+ *
+ * Returns:		Position of the tile, column by column.
+ */
+static long long SelectInWindow(const Fishery_Move_Index *index, const int *counts, int state,
+	int columns[2][2], int n_columns, int rows[2][2], int n_rows, int rank) {
+	int i, j, k, count, node, step;
+
+	for (i = 0; i < n_columns; i++) {
+		count = PrefixCount(counts, index->size_y, columns[i][1], rows, n_rows) -
+			PrefixCount(counts, index->size_y, columns[i][0] - 1, rows, n_rows);
+		if (rank >= count) {
+			rank -= count;
+			continue;
+		}
+		/* Descend the Fenwick tree to the column of the tile. */
+		rank += PrefixCount(counts, index->size_y, columns[i][0] - 1, rows, n_rows);
+		for (step = 1; step*2 <= index->size_x; step *= 2);
+		for (node = 0; step > 0; step /= 2) {
+			if (node + step <= index->size_x) {
+				count = ColumnCount(counts, index->size_y, node + step, rows, n_rows);
+				if (count <= rank) {
+					node += step;
+					rank -= count;
+				}
+			}
+		}
+		/* Scan the rows of the column, the column is node from zero. */
+		for (k = 0; k < n_rows; k++) {
+			for (j = rows[k][0]; j <= rows[k][1]; j++) {
+				if ((index->states[j + (long long)node*index->size_y] & state) && rank-- == 0)
+					return j + (long long)node*index->size_y;
+			}
+		}
+		break;
+	}
+	return -1;
+}
+/* Function: SampleMoveIndex
+ * -------------------------
+ * Generates new coordinates for a fish pool like GetNewCoords, but counts
+ * and finds the free tiles of the window with the move index. Given the
+ * same random numbers, the new coordinates are the same as those of
+ * GetNewCoords. The tile at the current coordinates must have a fish pool.
+ *
+ * *index:		Built move index of fishery.
+ * *fishery:	Fishery of index.
+ * cur_coords:	Index of the tile of the fish pool in the layout of the
+ *				vegetation layer.
+ * radius:		Largest allowed distance from current coordinates to new
+ *				coordinates.
+ *
+ * Returns:		New coordinates in the layout of the vegetation layer, -1
+ *				if no possible coordinates are available.
+ */
+long long SampleMoveIndex(const Fishery_Move_Index *index, const Fishery *fishery,
+	long long cur_coords, int radius) {
+	int columns[2][2], rows[2][2], n_columns, n_rows, count, state, coords_x, coords_y,
+		toroidal_x, toroidal_y, start_x, start_y, end_x, end_y;
+	const int size_x = index->size_x, size_y = index->size_y;
+	const int *counts;
+	long long cell;
+
+	LayoutCoords(&fishery->layout, cur_coords, &coords_x, &coords_y);
+	toroidal_x = fishery->options.toroidal && 2*radius + 1 < size_x;
+	toroidal_y = fishery->options.toroidal && 2*radius + 1 < size_y;
+	start_x = coords_x - radius < 0 && !toroidal_x ? 0 : coords_x - radius;
+	start_y = coords_y - radius < 0 && !toroidal_y ? 0 : coords_y - radius;
+	end_x = coords_x + radius > size_x - 1 && !toroidal_x ? size_x - 1 : coords_x + radius;
+	end_y = coords_y + radius > size_y - 1 && !toroidal_y ? size_y - 1 : coords_y + radius;
+	n_columns = WindowRanges(start_x, end_x, size_x, columns);
+	n_rows = WindowRanges(start_y, end_y, size_y, rows);
+	/* Tiles with vegetation first, then any free tiles. */
+	counts = index->vegetation_counts;
+	state = MOVE_INDEX_VEGETATION;
+	count = PrefixCount(counts, size_y, columns[0][1], rows, n_rows) -
+		PrefixCount(counts, size_y, columns[0][0] - 1, rows, n_rows);
+	if (n_columns > 1)
+		count += PrefixCount(counts, size_y, columns[1][1], rows, n_rows);
+	if (count == 0) {
+		counts = index->free_counts;
+		state = MOVE_INDEX_FREE;
+		count = PrefixCount(counts, size_y, columns[0][1], rows, n_rows) -
+			PrefixCount(counts, size_y, columns[0][0] - 1, rows, n_rows);
+		if (n_columns > 1)
+			count += PrefixCount(counts, size_y, columns[1][1], rows, n_rows);
+		if (count == 0)
+			return -1;
+	}
+	cell = SelectInWindow(index, counts, state, columns, n_columns, rows, n_rows,
+		GENERATERANDINT(0, count - 1));
+	return LayoutIndex(&fishery->layout, (int)(cell / size_y), (int)(cell % size_y));
+}
+/* Function: DestroyMoveIndex
+ * --------------------------
+ * Frees memory used by move index.
+ *
+ * *index:	Move index to free.
+ */
+void DestroyMoveIndex(Fishery_Move_Index *index) {
+	if (index == NULL)
+		return;
+	free(index->free_counts);
+	free(index->vegetation_counts);
+	free(index->states);
+	free(index);
+}
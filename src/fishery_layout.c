@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * Filename: fishery_layout.c												 *
+ *																			 *
+ * Contains functions for selecting the layout of the vegetation layer of a	 *
+ * fishery, see fishery_layout.h.											 *
+ *																			 *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "fishery_layout.h"
+
+const char *FISHERY_LAYOUT_NAMES[FISHERY_LAYOUT_N] = { "columns", "tiled" };
+
+/* Function: InitLayout
+ * --------------------
+ * Initializes layout of a vegetation layer.
+ *
+ * *layout:	Layout to initialize.
+ * type:	FISHERY_LAYOUT_COLUMNS or FISHERY_LAYOUT_TILED.
+ * size_x:	Width of vegetation layer.
+ * size_y:	Height of vegetation layer.
+ */
+void InitLayout(Fishery_Layout *layout, int type, int size_x, int size_y) {
+	int blocks_x;
+
+	layout->type = type;
+	layout->size_x = size_x;
+	layout->size_y = size_y;
+	if (type == FISHERY_LAYOUT_TILED) {
+		/* Partial blocks at the edges are padded to full blocks. */
+		blocks_x = (size_x + FISHERY_BLOCK_MASK) >> FISHERY_BLOCK_SHIFT;
+		layout->blocks_y = (size_y + FISHERY_BLOCK_MASK) >> FISHERY_BLOCK_SHIFT;
+		layout->n_tiles = ((long long)blocks_x*layout->blocks_y) << (2*FISHERY_BLOCK_SHIFT);
+	}
+	else {
+		layout->blocks_y = 0;
+		layout->n_tiles = (long long)size_x*size_y;
+	}
+}
+/* Function: SetFisheryLayout
+ * --------------------------
+ * Changes layout of the vegetation layer of fishery. The tiles are moved
+ * to their positions in the new layout, the simulation is not affected.
+ * Padding tiles of the tiled layout are empty and never used.
+ *
+ * *fishery:	Initialized or progressed fishery.
+ * type:		FISHERY_LAYOUT_COLUMNS or FISHERY_LAYOUT_TILED.
+ *
+ * Returns:		1 if successful, 0 if the layout is unknown, the vegetation 
+ *				layer is memory-mapped or memory could not be reserved.
+ */
+int SetFisheryLayout(Fishery *fishery, int type) {
+	Fishery_Layout layout;
+	Tile *vegetation_layer;
+	int pos_x, pos_y;
+
+	if (type < 0 || type >= FISHERY_LAYOUT_N) {
+		printf("Unknown layout %d.\n", type);
+		return 0;
+	}
+	if (type == fishery->layout.type)
+		return 1;
+	if (fishery->storage != NULL) {
+		printf("Memory-mapped vegetation layer is stored in columns.\n");
+		return 0;
+	}
+	InitLayout(&layout, type, fishery->layout.size_x, fishery->layout.size_y);
+	vegetation_layer = calloc((size_t)layout.n_tiles, sizeof(Tile));
+	if (vegetation_layer == NULL)
+		return 0;
+	for (pos_x = 0; pos_x < layout.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < layout.size_y; pos_y++) {
+			vegetation_layer[LayoutIndex(&layout, pos_x, pos_y)] = 
+				fishery->vegetation_layer[LayoutIndex(&fishery->layout, pos_x, pos_y)];
+		}
+	}
+	free(fishery->vegetation_layer);
+	fishery->vegetation_layer = vegetation_layer;
+	fishery->layout = layout;
+	return 1;
+}
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * Filename: fishery_plan.c													 *
+ *																			 *
+ * Contains functions for building the compiled plan of a fishery, i.e.		 *
+ * lookup tables derived from the settings and the selection of the update	 *
+ * kernels specialized for the settings.									 *
+ *																			 *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fishery_plan.h"
+
+/* Function: CopyList
+ * ------------------
+ * Copies integer list of length n to newly reserved memory.
+ *
+ * *list:	List to copy.
+ * n:		Length of list.
+ *
+ * Returns:	Pointer to copy of list, NULL if memory could not be reserved.
+ */
+static int *CopyList(const int *list, int n) {
+	int *copy;
+
+	copy = malloc(sizeof(int)*n);
+	if (copy != NULL)
+		memcpy(copy, list, sizeof(int)*n);
+	return copy;
+}
+/* Function: CreatePlan
+ * --------------------
+ * Builds plan for settings. The plan keeps its own copy of the settings,
+ * so the settings can be freed or altered afterwards.
+ *
+ * settings:	Validated settings of fishery.
+ *
+ * Returns:		Pointer to Fishery_Plan, NULL if memory could not be reserved.
+ */
+Fishery_Plan *CreatePlan(Fishery_Settings settings) {
+	Fishery_Plan *plan;
+	int i;
+
+	plan = calloc(1, sizeof(Fishery_Plan));
+	if (plan == NULL)
+		return NULL;
+	plan->settings = settings;
+	plan->settings.vegetation_consumption = CopyList(
+		settings.vegetation_consumption, settings.vegetation_level_max + 1);
+	plan->settings.fish_consumption = CopyList(
+		settings.fish_consumption, settings.fish_level_max + 1);
+	plan->fish_appetite = malloc(sizeof(int)*(settings.fish_level_max + 1));
+	plan->fish_growth_threshold = malloc(sizeof(int)*(settings.fish_level_max + 1));
+	plan->vegetation_spreads = malloc(sizeof(int)*(settings.vegetation_level_max + 1));
+	if (plan->settings.vegetation_consumption == NULL || plan->settings.fish_consumption == NULL ||
+		plan->fish_appetite == NULL || plan->fish_growth_threshold == NULL ||
+		plan->vegetation_spreads == NULL) {
+		DestroyPlan(plan);
+		return NULL;
+	}
+	/* Fish pools eat until they have food for two turns and growth. */
+	for (i = 0; i <= settings.fish_level_max; i++) {
+		plan->fish_appetite[i] = settings.fish_consumption[i] * 2 + settings.fish_growth_req;
+		plan->fish_growth_threshold[i] = settings.fish_growth_req + settings.fish_consumption[i];
+	}
+	for (i = 0; i <= settings.vegetation_level_max; i++)
+		plan->vegetation_spreads[i] = i >= settings.vegetation_level_spread_at;
+	plan->fishing_probability = (double)settings.fishing_chance / 100;
+	/* A trial succeeds if rand() / (RAND_MAX + 1) <= fishing_probability, 
+	   i.e. for floor(fishing_probability*(RAND_MAX + 1)) + 1 values. */
+	plan->fishing_probability_eff = (floor(plan->fishing_probability * 
+		((double)RAND_MAX + 1)) + 1) / ((double)RAND_MAX + 1);
+	if (plan->fishing_probability_eff > 1.0)
+		plan->fishing_probability_eff = 1.0;
+	plan->random_fishes_probability = settings.random_fishes_interval / 100.0;
+	/* Select kernel without branches on these settings in the fish loop. */
+	plan->fish_kernel = (settings.split_fishes_at_max ? FISH_KERNEL_SPLIT : 0) |
+		(settings.random_fishes_interval ? FISH_KERNEL_SPAWN : 0);
+
+	return plan;
+}
+/* Function: PlanMatchesSettings
+ * -----------------------------
+ * Checks whether plan was built from settings equal to the given settings.
+ *
+ * *plan:		Plan of fishery.
+ * settings:	Settings to compare against.
+ *
+ * Returns:		1 if settings match, 0 otherwise.
+ */
+int PlanMatchesSettings(const Fishery_Plan *plan, Fishery_Settings settings) {
+	const Fishery_Settings *planned = &plan->settings;
+
+	if (planned->size_x != settings.size_x || planned->size_y != settings.size_y ||
+		planned->initial_vegetation_size != settings.initial_vegetation_size ||
+		planned->vegetation_level_max != settings.vegetation_level_max ||
+		planned->vegetation_level_spread_at != settings.vegetation_level_spread_at ||
+		planned->vegetation_level_growth_req != settings.vegetation_level_growth_req ||
+		planned->soil_energy_max != settings.soil_energy_max ||
+		planned->soil_energy_increase_turn != settings.soil_energy_increase_turn ||
+		planned->initial_fish_size != settings.initial_fish_size ||
+		planned->fish_level_max != settings.fish_level_max ||
+		planned->fish_growth_req != settings.fish_growth_req ||
+		planned->fish_moves_turn != settings.fish_moves_turn ||
+		planned->random_fishes_interval != settings.random_fishes_interval ||
+		planned->split_fishes_at_max != settings.split_fishes_at_max ||
+		planned->fishing_chance != settings.fishing_chance)
+		return 0;
+	if (memcmp(planned->vegetation_consumption, settings.vegetation_consumption,
+			sizeof(int)*(settings.vegetation_level_max + 1)) != 0 ||
+		memcmp(planned->fish_consumption, settings.fish_consumption,
+			sizeof(int)*(settings.fish_level_max + 1)) != 0)
+		return 0;
+	return 1;
+}
+/* Function: DestroyPlan
+ * ---------------------
+ * Frees memory used by plan.
+ *
+ * *plan:	Plan to free.
+ */
+void DestroyPlan(Fishery_Plan *plan) {
+	if (plan == NULL)
+		return;
+	free(plan->settings.vegetation_consumption);
+	free(plan->settings.fish_consumption);
+	free(plan->fish_appetite);
+	free(plan->fish_growth_threshold);
+	free(plan->vegetation_spreads);
+	free(plan);
+}
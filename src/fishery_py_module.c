@@ -3,99 +3,1484 @@
  *																			 *
  * Contains the interface functions for the Python extension of the fishery  *
  * simulation.																 *
- * Fishery simulations created by these functions are assigned unique IDs	 *
- * and stored in a global linked list. The interface functions uses these    *
- * IDs to manipulate simulations further.									 *
+ * Fishery simulations are Fishery objects, which are freed when they are	 *
+ * deallocated. Simulations created by the MPy* functions are assigned		 *
+ * unique IDs and stored in a global hash map. The interface functions use	 *
+ * these IDs, or Fishery objects, to manipulate simulations further.		 *
+ * Settings can be parsed once into an immutable Settings object, which is  *
+ * shared by the simulations created from it.								 *
  *****************************************************************************/
 #include <Python.h>
+#include <structmember.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 
 #include "fishery_functions.h"
 #include "fishery_settings.h"
 
 
+extern char *MASTER_SETTING_LIST[17][3];   /* List of setting names in the proper order.
+											  Accessed from fishery_settings.c. */
+extern int SETTINGS_SIZE;		/* Number of settings. Accessed from 
+								   fishery_settings.c. */
+
+/* Function: FreeSettings
+ * ----------------------
+ * Frees settings reserved by ParseSettings.
+ *
+ * *settings:	Settings to free.
+ */
+static void FreeSettings(Fishery_Settings *settings) {
+	free(settings->vegetation_consumption);
+	free(settings->fish_consumption);
+	free(settings);
+}
+/* Function: ParseSettings
+ * -----------------------
+ * Parses and validates settings given as a Python dictionary. Errors are
+ * raised as TypeError, KeyError and ValueError exceptions.
+ *
+ * *dict:	Dictionary of settings. See documentation for details.
+ *
+ * Returns:	Pointer to Fishery_Settings, NULL if the settings are invalid.
+ */
+static Fishery_Settings *ParseSettings(PyObject *dict) {
+	int i, j, list_len, *tmp_list, item;
+	PyObject *value;
+	Fishery_Settings *settings;
+
+	/* Check dictionary contains all settings. */
+	for (i = 0; i < SETTINGS_SIZE; i++) {
+		if (PyDict_GetItemString(dict, MASTER_SETTING_LIST[i][0]) == NULL) {
+			PyErr_Format(PyExc_KeyError, "%s", MASTER_SETTING_LIST[i][0]);
+			return NULL;
+		}
+	}
+	/* Parse given settings and store in Fishery_Settings data type. The 
+	   settings are in MASTER_SETTING_LIST order, so the size of a list is
+	   parsed before the list. */
+	settings = (Fishery_Settings*)calloc(1, sizeof(Fishery_Settings));
+	if (settings == NULL)
+		return (Fishery_Settings *)PyErr_NoMemory();
+	for (i = 0; i < SETTINGS_SIZE; i++) {
+		value = PyDict_GetItemString(dict, MASTER_SETTING_LIST[i][0]);
+		if (strcmp(MASTER_SETTING_LIST[i][1], "int") == 0) {
+			/* If setting is not a list. */
+			item = (int)PyLong_AsLong(value);
+			if (item == -1 && PyErr_Occurred())
+				goto error;
+			AddSetting(settings, MASTER_SETTING_LIST[i][0], &item);
+			continue;
+		}
+		/* If setting is a list. */
+		if (PyList_Check(value) == 0) {
+			PyErr_Format(PyExc_TypeError, "%s is not a list.", MASTER_SETTING_LIST[i][0]);
+			goto error;
+		}
+		/* Length of setting list. */
+		list_len = (int)PyLong_AsLong(
+			PyDict_GetItemString(dict, MASTER_SETTING_LIST[i][2])) + 1;
+		if (list_len <= 0 || PyList_Size(value) < list_len) {
+			PyErr_Format(PyExc_ValueError, "%s should have %s + 1 items.",
+				MASTER_SETTING_LIST[i][0], MASTER_SETTING_LIST[i][2]);
+			goto error;
+		}
+		/* Copy into temporary C array. */
+		tmp_list = (int *)malloc(sizeof(int)*list_len);
+		if (tmp_list == NULL) {
+			PyErr_NoMemory();
+			goto error;
+		}
+		for (j = 0; j < list_len; j++)
+			tmp_list[j] = (int)PyLong_AsLong(PyList_GET_ITEM(value, j));
+		/* Add to Fishery_Setting data structure. Remember to free temporary 
+		   array memory. */
+		if (PyErr_Occurred() || !AddSetting(settings, MASTER_SETTING_LIST[i][0], tmp_list)) {
+			free(tmp_list);
+			if (!PyErr_Occurred())
+				PyErr_Format(PyExc_ValueError, "Invalid %s.", MASTER_SETTING_LIST[i][0]);
+			goto error;
+		}
+		free(tmp_list);
+	}
+	/* Check settings before reserving memory for the simulation, the 
+	   vegetation layer size is limited by FISHERY_MAX_CELLS. */
+	if (!ValidateSettings(*settings, 0)) {
+		PyErr_Format(PyExc_ValueError, "Invalid fishery settings.");
+		goto error;
+	}
+	return settings;
+
+	error:
+	FreeSettings(settings);
+	return NULL;
+}
+/* Settings object, i.e. parsed and validated settings. The object is 
+   immutable, so fisheries created from it share its settings and hold a
+   reference to it. */
+typedef struct {
+	PyObject_HEAD
+	Fishery_Settings settings;
+} SettingsObject;
+
+#define SETTINGS_MEMBER(name) { #name, T_INT, \
+	offsetof(SettingsObject, settings) + offsetof(Fishery_Settings, name), READONLY, NULL }
+
+static PyMemberDef settings_members[] = {
+	SETTINGS_MEMBER(size_x),
+	SETTINGS_MEMBER(size_y),
+	SETTINGS_MEMBER(initial_vegetation_size),
+	SETTINGS_MEMBER(vegetation_level_max),
+	SETTINGS_MEMBER(vegetation_level_spread_at),
+	SETTINGS_MEMBER(vegetation_level_growth_req),
+	SETTINGS_MEMBER(soil_energy_max),
+	SETTINGS_MEMBER(soil_energy_increase_turn),
+	SETTINGS_MEMBER(initial_fish_size),
+	SETTINGS_MEMBER(fish_level_max),
+	SETTINGS_MEMBER(fish_growth_req),
+	SETTINGS_MEMBER(fish_moves_turn),
+	SETTINGS_MEMBER(random_fishes_interval),
+	SETTINGS_MEMBER(split_fishes_at_max),
+	SETTINGS_MEMBER(fishing_chance),
+	{ NULL }
+};
+/* Function: BuildIntList
+ * ----------------------
+ * Returns C array of length n as a new Python list.
+ */
+static PyObject *BuildIntList(const int *list, int n) {
+	PyObject *py_list;
+	int i;
+
+	py_list = PyList_New(n);
+	if (py_list == NULL)
+		return NULL;
+	for (i = 0; i < n; i++)
+		PyList_SET_ITEM(py_list, i, PyLong_FromLong(list[i]));
+	return py_list;
+}
+static PyObject *SettingsGetVegetationConsumption(SettingsObject *self, void *closure) {
+	return BuildIntList(self->settings.vegetation_consumption, 
+		self->settings.vegetation_level_max + 1);
+}
+static PyObject *SettingsGetFishConsumption(SettingsObject *self, void *closure) {
+	return BuildIntList(self->settings.fish_consumption, 
+		self->settings.fish_level_max + 1);
+}
+static PyGetSetDef settings_getset[] = {
+	{ "vegetation_consumption", (getter)SettingsGetVegetationConsumption, NULL, NULL, NULL },
+	{ "fish_consumption", (getter)SettingsGetFishConsumption, NULL, NULL, NULL },
+	{ NULL }
+};
+/* Function: SettingsNew
+ * ---------------------
+ * Creates Settings object from a dictionary of settings, i.e. 
+ * fishery.Settings(dict).
+ */
+static PyObject *SettingsNew(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+	PyObject *dict;
+	SettingsObject *self;
+	Fishery_Settings *settings;
+
+	if (!PyArg_ParseTuple(args, "O!", &PyDict_Type, &dict))
+		return NULL;
+	settings = ParseSettings(dict);
+	if (settings == NULL)
+		return NULL;
+	self = (SettingsObject *)type->tp_alloc(type, 0);
+	if (self == NULL) {
+		FreeSettings(settings);
+		return NULL;
+	}
+	/* Take over the lists of the parsed settings. */
+	self->settings = *settings;
+	free(settings);
+	return (PyObject *)self;
+}
+static void SettingsDealloc(SettingsObject *self) {
+	free(self->settings.vegetation_consumption);
+	free(self->settings.fish_consumption);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+/* Function: SettingsToDict
+ * ------------------------
+ * Returns settings as a dictionary accepted by fishery.Settings().
+ */
+static PyObject *SettingsToDict(SettingsObject *self, PyObject *unused) {
+	PyObject *dict, *value;
+	int i;
+
+	dict = PyDict_New();
+	if (dict == NULL)
+		return NULL;
+	for (i = 0; i < SETTINGS_SIZE; i++) {
+		value = PyObject_GetAttrString((PyObject *)self, MASTER_SETTING_LIST[i][0]);
+		if (value == NULL || PyDict_SetItemString(dict, MASTER_SETTING_LIST[i][0], value) == -1) {
+			Py_XDECREF(value);
+			Py_DECREF(dict);
+			return NULL;
+		}
+		Py_DECREF(value);
+	}
+	return dict;
+}
+static PyMethodDef settings_methods[] = {
+	{ "to_dict", (PyCFunction)SettingsToDict, METH_NOARGS, NULL },
+	{ NULL, NULL, 0, NULL }
+};
+static PyTypeObject SettingsType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "fishery.Settings",
+	.tp_basicsize = sizeof(SettingsObject),
+	.tp_dealloc = (destructor)SettingsDealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = "Validated, immutable fishery settings.",
+	.tp_methods = settings_methods,
+	.tp_members = settings_members,
+	.tp_getset = settings_getset,
+	.tp_new = SettingsNew,
+};
+/* Function: GetSettings
+ * ---------------------
+ * Returns the settings of a Settings object or parses a dictionary of 
+ * settings.
+ *
+ * *settings_py:	Settings object or dictionary of settings.
+ * **owner:			Set to the Settings object, NULL if the returned 
+ *					settings are parsed from a dictionary and must be freed 
+ *					by the caller.
+ *
+ * Returns:	Pointer to Fishery_Settings, NULL if the settings are invalid.
+ */
+static Fishery_Settings *GetSettings(PyObject *settings_py, PyObject **owner) {
+	*owner = NULL;
+	if (PyObject_TypeCheck(settings_py, &SettingsType)) {
+		*owner = settings_py;
+		return &((SettingsObject *)settings_py)->settings;
+	}
+	if (!PyDict_Check(settings_py)) {
+		PyErr_Format(PyExc_TypeError, "Settings should be a Settings object or a dictionary.");
+		return NULL;
+	}
+	return ParseSettings(settings_py);
+}
+/* Fishery object, i.e. a simulation. The simulation is freed when the 
+   object is deallocated or destroyed with MPyDestroyFishery. */
+typedef struct {
+	PyObject_HEAD
+	Fishery *fishery;		/* NULL after MPyDestroyFishery. */
+	int running;			/* Nonzero while updates call Python callbacks. */
+} FisheryObject;
+
+static PyTypeObject FisheryType;
+
+/* Slot of the hash map from IDs to the Fishery objects created through
+   the integer ID functions. Empty slots have a NULL object. */
+typedef struct {
+	unsigned int id;
+	FisheryObject *object;
+} Fishery_Slot;
+
+#define FISHERY_MAP_MIN_SIZE 64
+/* Home slot of ID. Consecutive IDs get consecutive slots. */
+#define FISHERY_MAP_SLOT(id) ((size_t)((id) * 2654435761u) & (fishery_map_size - 1))
+
 /*
-The simulation(s) are stored, with a unique ID, in a global variable to 
-avoid constant transfer of simulation data between python and c extension. 
+The simulation(s) created by MPyCreateFishery are stored, with a unique ID, 
+in a global hash map to avoid constant transfer of simulation data between 
+python and c extension. The map holds a reference to each Fishery object.
 */
+static Fishery_Slot *fishery_map = NULL;	/* Open addressing, linear probing. */
+static size_t fishery_map_size = 0;			/* Power of two. */
+static size_t fishery_map_n = 0;
+unsigned int fishery_id_n = 0;	/* Fishery unique ID generated from this. 
+							       The Python module should be reset from 
+								   Python before any possible overflow.   */
+
+/* Function: MapFind
+ * -----------------
+ * Returns Fishery object with ID from the hash map, NULL if not found.
+ */
+static FisheryObject *MapFind(unsigned int id) {
+	size_t i;
+
+	if (fishery_map_n == 0)
+		return NULL;
+	for (i = FISHERY_MAP_SLOT(id); fishery_map[i].object != NULL; 
+		i = (i + 1) & (fishery_map_size - 1)) {
+		if (fishery_map[i].id == id)
+			return fishery_map[i].object;
+	}
+	return NULL;
+}
+/* Function: MapInsert
+ * -------------------
+ * Adds Fishery object to the hash map, which takes a new reference to it.
+ * The map is kept at most half full.
+ *
+ * Returns:	1 if successful, 0 if memory could not be reserved.
+ */
+static int MapInsert(FisheryObject *object) {
+	Fishery_Slot *old_map = fishery_map;
+	size_t i, old_size = fishery_map_size;
+
+	if ((fishery_map_n + 1) * 2 > fishery_map_size) {
+		fishery_map_size = old_size ? old_size * 2 : FISHERY_MAP_MIN_SIZE;
+		fishery_map = calloc(fishery_map_size, sizeof(Fishery_Slot));
+		if (fishery_map == NULL) {
+			fishery_map = old_map;
+			fishery_map_size = old_size;
+			return 0;
+		}
+		fishery_map_n = 0;
+		for (i = 0; i < old_size; i++) {
+			if (old_map[i].object != NULL) {
+				MapInsert(old_map[i].object);
+				Py_DECREF(old_map[i].object);
+			}
+		}
+		free(old_map);
+	}
+	for (i = FISHERY_MAP_SLOT(object->fishery->fishery_id); fishery_map[i].object != NULL;
+		i = (i + 1) & (fishery_map_size - 1));
+	fishery_map[i].id = object->fishery->fishery_id;
+	fishery_map[i].object = object;
+	fishery_map_n++;
+	Py_INCREF(object);
+	return 1;
+}
+/* Function: MapRemove
+ * -------------------
+ * Removes Fishery object with ID from the hash map. The reference of the 
+ * map is passed to the caller.
+ *
+ * Returns:	Removed Fishery object, NULL if not found.
+ */
+static FisheryObject *MapRemove(unsigned int id) {
+	FisheryObject *object;
+	size_t i, j, home, mask = fishery_map_size - 1;
+
+	if (fishery_map_n == 0)
+		return NULL;
+	for (i = FISHERY_MAP_SLOT(id); fishery_map[i].object != NULL && 
+		fishery_map[i].id != id; i = (i + 1) & mask);
+	object = fishery_map[i].object;
+	if (object == NULL)
+		return NULL;
+	fishery_map[i].object = NULL;
+	fishery_map_n--;
+	/* Shift following entries back into the hole, unless that would move 
+	   them before their home slot, so no probe sequence is broken. */
+	for (j = (i + 1) & mask; fishery_map[j].object != NULL; j = (j + 1) & mask) {
+		home = FISHERY_MAP_SLOT(fishery_map[j].id);
+		if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+		fishery_map[i] = fishery_map[j];
+		fishery_map[j].object = NULL;
+		i = j;
+	}
+	return object;
+}
+/* Function: ReleaseFishery
+ * ------------------------
+ * Frees fishery and releases the reference to its Settings object.
+ *
+ * *fishery:	Fishery to free.
+ */
+static void ReleaseFishery(Fishery *fishery) {
+	PyObject *owner = fishery->settings_owner;
+
+	DestroyFishery(fishery);
+	Py_XDECREF(owner);
+}
+/* Function: WrapFishery
+ * ---------------------
+ * Assigns a unique ID to a new simulation and creates a Fishery object 
+ * for it.
+ *
+ * *fishery:	New simulation.
+ * *settings:	Settings of simulation, see GetSettings.
+ * *owner:		Settings object of settings, NULL if the settings are freed
+ *				with the simulation.
+ *
+ * Returns:	New reference to Fishery object, NULL if creation failed. The
+ *			simulation is freed on failure.
+ */
+static FisheryObject *WrapFishery(Fishery *fishery, Fishery_Settings *settings, 
+	PyObject *owner) {
+	FisheryObject *object;
+
+	fishery->fishery_id = fishery_id_n++;
+	fishery->settings = settings;
+	/* Settings object lives as long as the fisheries using it. */
+	Py_XINCREF(owner);
+	fishery->settings_owner = owner;
+
+	object = PyObject_New(FisheryObject, &FisheryType);
+	if (object == NULL) {
+		ReleaseFishery(fishery);
+		return NULL;
+	}
+	object->fishery = fishery;
+	object->running = 0;
+	return object;
+}
+/* Function: GetIntBuffer
+ * ----------------------
+ * Gets a contiguous buffer of C ints from a Python object supporting the
+ * buffer protocol, e.g. array.array('i') or a numpy array of int32.
+ *
+ * *object:	Python object.
+ * *view:	Set to the buffer, released by the caller.
+ * *name:	Name of the argument in error messages.
+ *
+ * Returns:	1 if successful, 0 otherwise with TypeError raised.
+ */
+static int GetIntBuffer(PyObject *object, Py_buffer *view, const char *name) {
+	const char *format;
+
+	if (PyObject_GetBuffer(object, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1)
+		return 0;
+	format = view->format != NULL ? view->format : "B";
+	/* Native byte order only. */
+	if (*format == '@' || *format == '=' || (PY_LITTLE_ENDIAN ? *format == '<' : 
+		(*format == '>' || *format == '!')))
+		format++;
+	if (view->itemsize != sizeof(int) || format[1] != '\0' || 
+		(format[0] != 'i' && (format[0] != 'l' || sizeof(long) != sizeof(int)))) {
+		PyBuffer_Release(view);
+		PyErr_Format(PyExc_TypeError, "%s should be a buffer of C ints.", name);
+		return 0;
+	}
+	return 1;
+}
+/* Function: NewFisheryObjectFromState
+ * -----------------------------------
+ * Creates simulation from an initial state and a Fishery object for it, 
+ * see MPyCreateFisheryFromState for the arguments. The state is read from
+ * the buffers in C, the coordinates are rotated as in 
+ * MPyGetFisheryVegetation and MPyGetFisheryFishPopulation.
+ *
+ * Returns:	New reference to Fishery object, NULL if creation failed.
+ */
+static FisheryObject *NewFisheryObjectFromState(PyObject *settings_py, 
+	PyObject *vegetation_py, PyObject *soil_py, PyObject *fish_py) {
+	PyObject *owner;
+	Py_buffer vegetation_view, soil_view, fish_view;
+	Fishery_Settings *settings;
+	Fishery *fishery = NULL;
+	Fish_Pool *fish_pools = NULL;
+	const int *vegetation_buffer, *soil_buffer, *fish_buffer;
+	int *vegetation_levels = NULL, *soil_energies = NULL, pos_x, pos_y;
+	long long i, n_fish = 0, n_cells, position;
+	int has_soil = soil_py != NULL && soil_py != Py_None,
+		has_fish = fish_py != NULL && fish_py != Py_None;
+
+	settings = GetSettings(settings_py, &owner);
+	if (settings == NULL)
+		return NULL;
+	n_cells = (long long)settings->size_x*settings->size_y;
+	if (!GetIntBuffer(vegetation_py, &vegetation_view, "Vegetation")) {
+		if (owner == NULL)
+			FreeSettings(settings);
+		return NULL;
+	}
+	if (has_soil && !GetIntBuffer(soil_py, &soil_view, "Soil energy")) {
+		PyBuffer_Release(&vegetation_view);
+		if (owner == NULL)
+			FreeSettings(settings);
+		return NULL;
+	}
+	if (has_fish && !GetIntBuffer(fish_py, &fish_view, "Fish population")) {
+		PyBuffer_Release(&vegetation_view);
+		if (has_soil)
+			PyBuffer_Release(&soil_view);
+		if (owner == NULL)
+			FreeSettings(settings);
+		return NULL;
+	}
+	vegetation_buffer = vegetation_view.buf;
+	soil_buffer = has_soil ? soil_view.buf : NULL;
+	fish_buffer = has_fish ? fish_view.buf : NULL;
+	if (vegetation_view.len / (Py_ssize_t)sizeof(int) != n_cells ||
+		(has_soil && soil_view.len / (Py_ssize_t)sizeof(int) != n_cells)) {
+		PyErr_Format(PyExc_ValueError, "Vegetation and soil energy should have %lld tiles.", 
+			n_cells);
+		goto error;
+	}
+	if (has_fish) {
+		if (fish_view.len / (Py_ssize_t)sizeof(int) % 2 != 0) {
+			PyErr_Format(PyExc_ValueError, 
+				"Fish population should consist of position and population level pairs.");
+			goto error;
+		}
+		n_fish = fish_view.len / (Py_ssize_t)sizeof(int) / 2;
+	}
+	vegetation_levels = malloc(sizeof(int)*(size_t)(n_cells > 0 ? n_cells : 1));
+	soil_energies = has_soil ? malloc(sizeof(int)*(size_t)(n_cells > 0 ? n_cells : 1)) : NULL;
+	fish_pools = malloc(sizeof(Fish_Pool)*(size_t)(n_fish > 0 ? n_fish : 1));
+	if (vegetation_levels == NULL || (has_soil && soil_energies == NULL) || fish_pools == NULL) {
+		PyErr_NoMemory();
+		goto error;
+	}
+	/* Rotate coordinates. */
+	for (pos_x = 0, i = 0; pos_x < settings->size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings->size_y; pos_y++, i++) {
+			vegetation_levels[i] = vegetation_buffer[pos_x + (long long)pos_y*settings->size_x];
+			if (has_soil)
+				soil_energies[i] = soil_buffer[pos_x + (long long)pos_y*settings->size_x];
+		}
+	}
+	for (i = 0; i < n_fish; i++) {
+		position = fish_buffer[2*i];
+		if (position < 0 || position >= n_cells) {
+			PyErr_Format(PyExc_ValueError, "Position of fish pool %lld is invalid (%lld).", 
+				i, position);
+			goto error;
+		}
+		fish_pools[i].pos_x = (int)(position % settings->size_x);
+		fish_pools[i].pos_y = (int)(position / settings->size_x);
+		fish_pools[i].pop_level = fish_buffer[2*i + 1];
+		fish_pools[i].food_level = 0;
+	}
+	fishery = CreateFisheryFromState(*settings, vegetation_levels, soil_energies, 
+		fish_pools, n_fish);
+	if (fishery == NULL)
+		PyErr_Format(PyExc_ValueError, "Initial state does not match settings.");
+
+	error:
+	free(vegetation_levels);
+	free(soil_energies);
+	free(fish_pools);
+	PyBuffer_Release(&vegetation_view);
+	if (has_soil)
+		PyBuffer_Release(&soil_view);
+	if (has_fish)
+		PyBuffer_Release(&fish_view);
+	if (fishery == NULL) {
+		if (owner == NULL)
+			FreeSettings(settings);
+		return NULL;
+	}
+	return WrapFishery(fishery, settings, owner);
+}
+/* Function: NewFisheryObject
+ * --------------------------
+ * Creates simulation and a Fishery object for it. The simulation is 
+ * assigned a unique ID.
+ *
+ * *settings_py:	Settings object or dictionary of settings.
+ * *path:			Path of storage file of vegetation layer, NULL if the 
+ *					vegetation layer is kept in memory.
+ * open:			If nonzero, the simulation is opened from the storage
+ *					file instead.
+ *
+ * Returns:	New reference to Fishery object, NULL if creation failed.
+ */
+static FisheryObject *NewFisheryObject(PyObject *settings_py, const char *path, int open) {
+	PyObject *owner;
+	Fishery_Settings *settings;
+	Fishery *fishery;
+
+	settings = GetSettings(settings_py, &owner);
+	if (settings == NULL)
+		return NULL;
+	/* Create fishery simulation. */
+	if (open)
+		fishery = OpenFisheryMapped(*settings, path);
+	else if (path == NULL)
+		fishery = CreateFishery(*settings);
+	else
+		fishery = CreateFisheryMapped(*settings, path);
+	if (fishery == NULL) {
+		if (owner == NULL)
+			FreeSettings(settings);
+		PyErr_Format(PyExc_OSError, "Failed to %s vegetation layer storage %s.", 
+			open ? "open" : "create", path);
+		return NULL;
+	}
+	return WrapFishery(fishery, settings, owner);
+}
+/* Function: FindFisheryObject
+ * ---------------------------
+ * Returns a Fishery object, or the Fishery object of an ID of the hash 
+ * map, if its simulation exists. Errors are raised as TypeError, KeyError 
+ * and ValueError exceptions.
+ *
+ * *fishery_py:	Fishery object or Python integer representing simulation ID.
+ *
+ * Returns:	Borrowed reference to Fishery object, NULL if not found.
+ */
+static FisheryObject *FindFisheryObject(PyObject *fishery_py) {
+	FisheryObject *object;
+	long fishery_id;
+
+	if (PyObject_TypeCheck(fishery_py, &FisheryType))
+		object = (FisheryObject *)fishery_py;
+	else if (PyLong_Check(fishery_py)) {
+		fishery_id = PyLong_AsLong(fishery_py);
+		if (fishery_id == -1 && PyErr_Occurred())
+			return NULL;
+		object = fishery_id >= 0 && fishery_id <= UINT_MAX ? 
+			MapFind((unsigned int)fishery_id) : NULL;
+		if (object == NULL) {
+			PyErr_Format(PyExc_KeyError, "Fishery with ID %ld not found.\n", fishery_id);
+			return NULL;
+		}
+	}
+	else {
+		PyErr_Format(PyExc_TypeError, "Fishery should be a Fishery object or an ID.");
+		return NULL;
+	}
+	if (object->fishery == NULL) {
+		PyErr_Format(PyExc_ValueError, "Fishery has been destroyed.");
+		return NULL;
+	}
+	return object;
+}
+/* Function: FindFishery
+ * ---------------------
+ * Returns simulation of a Fishery object or of an ID of the hash map, 
+ * see FindFisheryObject.
+ *
+ * Returns:	Pointer to Fishery, NULL if not found.
+ */
+static Fishery *FindFishery(PyObject *fishery_py) {
+	FisheryObject *object = FindFisheryObject(fishery_py);
+
+	return object != NULL ? object->fishery : NULL;
+}
+/* Function: BuildVegetation
+ * -------------------------
+ * Returns vegetation layer of fishery as a Python list, see 
+ * MPyGetFisheryVegetation.
+ */
+static PyObject *BuildVegetation(Fishery *fishery) {
+	PyObject *py_vegetation_list, *item;
+	const Fishery_Layout *layout = &fishery->layout;
+	int pos_x, pos_y;
+
+	py_vegetation_list = PyList_New((Py_ssize_t)layout->size_x*layout->size_y);
+	if (!py_vegetation_list)
+		return NULL;
+	for (pos_x = 0; pos_x < layout->size_x; pos_x++) {
+		for (pos_y = 0; pos_y < layout->size_y; pos_y++) {
+			item = PyLong_FromLong(fishery->vegetation_layer[
+				LayoutIndex(layout, pos_x, pos_y)].vegetation_level);
+			/* Rotate coordinates. */
+			if (PyList_SetItem(py_vegetation_list, 
+				(Py_ssize_t)(pos_x + (long long)pos_y*layout->size_x), item) == -1) {
+				Py_DECREF(py_vegetation_list);
+				return NULL;
+			}
+		}
+	}
+	return py_vegetation_list;
+}
+/* Function: BuildFishPopulation
+ * -----------------------------
+ * Returns fish population of fishery as a Python list, see 
+ * MPyGetFisheryFishPopulation.
+ */
+static PyObject *BuildFishPopulation(Fishery *fishery) {
+	PyObject *py_fish_list = NULL, *py_fish = NULL;
+	Fish_Pool *fish_ptr;
+	LList_Node *node;
+	long long i, fish_pos, fish_population_size = 0;
+
+	/* Find fish population size. */
+	node = fishery->fish_list;
+	while (node != NULL && node->node_value != NULL) {
+		node = node->next;
+		fish_population_size++;
+	}
+	/* Create python list of fish population. */
+	if (fish_population_size > 0) {
+		py_fish_list = PyList_New((Py_ssize_t)fish_population_size);
+		if (!py_fish_list)
+			goto error;
+		node = fishery->fish_list;
+		for (i = 0; i < fish_population_size; i++) {
+			/* Fish in python will contain position and population level. */
+			fish_ptr = node->node_value;
+			py_fish = PyList_New(2);
+			if (!py_fish)
+				goto error;
+			/* fish position returned here is for the rotated coordinate system,
+			not the array structure of the c program. */
+			fish_pos = fish_ptr->pos_x + (long long)fish_ptr->pos_y*fishery->settings->size_x;
+			if(PyList_SetItem(py_fish, 0, PyLong_FromLongLong(fish_pos)) == -1 ||
+				PyList_SetItem(py_fish, 1, PyLong_FromLong(fish_ptr->pop_level)) == -1)
+				goto error;
+			if (PyList_SetItem(py_fish_list, (Py_ssize_t)i, py_fish) == -1) {
+				/* Steals reference even on failure. */
+				py_fish = NULL;
+				goto error;
+			}
+			py_fish = NULL;
+			node = node->next;
+		}
+	}
+	else {
+		py_fish_list = PyList_New(1);
+		if (!py_fish_list)
+			goto error;
+		if (PyList_SetItem(py_fish_list, 0, PyLong_FromLong(-1)) == -1)
+			goto error;
+	}
+	return py_fish_list;
+
+	error:
+	Py_XDECREF(py_fish);
+	Py_XDECREF(py_fish_list);
+	return NULL;
+}
+/* Data of CallStepCallback. */
+typedef struct {
+	PyObject *callback;
+	int failed;				/* Nonzero if callback raised an exception. */
+} Step_Callback_Data;
+
+/* Function: BuildStep
+ * -------------------
+ * Returns step as a Python tuple (step, fish_n, yield, vegetation_n).
+ */
+static PyObject *BuildStep(const Fishery_Step *step) {
+	return Py_BuildValue("(LLLL)", step->step, step->fish_n, step->yield, 
+		step->vegetation_n);
+}
+/* Function: CallStepCallback
+ * --------------------------
+ * Fishery_Step_Callback calling a Python callable with the step tuple of
+ * BuildStep. The update stops if the callable returns a true value or 
+ * raises an exception.
+ */
+static int CallStepCallback(void *data, const Fishery_Step *step) {
+	Step_Callback_Data *callback_data = data;
+	PyObject *step_py, *result;
+	int stop;
+
+	step_py = BuildStep(step);
+	if (step_py == NULL) {
+		callback_data->failed = 1;
+		return 1;
+	}
+	result = PyObject_CallFunctionObjArgs(callback_data->callback, step_py, NULL);
+	Py_DECREF(step_py);
+	if (result == NULL) {
+		callback_data->failed = 1;
+		return 1;
+	}
+	stop = PyObject_IsTrue(result);
+	Py_DECREF(result);
+	if (stop < 0) {
+		callback_data->failed = 1;
+		return 1;
+	}
+	return stop;
+}
+/* Function: BuildResultsList
+ * --------------------------
+ * Returns results of an update with the fishing chance of the fishery as
+ * a Python list, see MPyUpdateFishery.
+ */
+static PyObject *BuildResultsList(const Fishery_Results *results, int fishing_chance) {
+	return Py_BuildValue("[LLLdddLLi{s:L,s:L,s:L,s:L,s:L,s:L,s:L}]", 
+		results->fish_n, results->yield, results->vegetation_n, 
+		results->fish_n_std_dev, results->yield_std_dev, results->vegetation_n_std_dev, 
+		results->steps, results->debug_stuff, fishing_chance,
+		"moves", results->events.moves, "failed_moves", results->events.failed_moves,
+		"splits", results->events.splits, "failed_splits", results->events.failed_splits,
+		"starvation_deaths", results->events.starvation_deaths,
+		"fishing_deaths", results->events.fishing_deaths, "spawns", results->events.spawns);
+}
+/* Function: BuildResults
+ * ----------------------
+ * Returns results of an update as a Python list, see MPyUpdateFishery.
+ */
+static PyObject *BuildResults(Fishery *fishery, const Fishery_Results *results) {
+	return BuildResultsList(results, fishery->settings->fishing_chance);
+}
+/* Function: BuildUpdate
+ * ---------------------
+ * Progresses fishery n steps and returns the results as a Python list, see 
+ * MPyUpdateFishery.
+ *
+ * *object:		Fishery object of simulation.
+ * n:			Number of steps.
+ * *callback:	Python callable called every every'th step, or NULL.
+ * every:		Steps between calls of callback.
+ */
+static PyObject *BuildUpdate(FisheryObject *object, long long n, PyObject *callback, 
+	long long every) {
+	Fishery *fishery = object->fishery;
+	Fishery_Results results;
+	Step_Callback_Data callback_data;
+
+	/* Check number of steps to progress simulation is 
+	   reasonable. */
+	if (n < 0) {
+		PyErr_Format(PyExc_ValueError, "Amount of steps invalid (%lld). \
+			Should not be negative.\n", n);
+		return NULL;
+	}
+	if (callback == NULL || callback == Py_None) {
+		/* Update fishery and save results in Python data types. */
+		results = UpdateFishery(fishery, (*(fishery->settings)), n);
+	}
+	else {
+		if (!PyCallable_Check(callback)) {
+			PyErr_Format(PyExc_TypeError, "Callback should be callable.");
+			return NULL;
+		}
+		if (every < 1) {
+			PyErr_Format(PyExc_ValueError, "Steps between callbacks should be positive.");
+			return NULL;
+		}
+		callback_data.callback = callback;
+		callback_data.failed = 0;
+		/* The callback must not free the simulation during the update. */
+		Py_INCREF(object);
+		object->running++;
+		results = UpdateFisheryCallback(fishery, (*(fishery->settings)), n, every,
+			CallStepCallback, &callback_data);
+		object->running--;
+		Py_DECREF(object);
+		if (callback_data.failed)
+			return NULL;
+	}
+	return BuildResults(fishery, &results);
+}
+/* Function: BuildProfile
+ * ----------------------
+ * Returns profile of fishery as a Python dictionary, see 
+ * MPyGetFisheryProfile.
+ */
+static PyObject *BuildProfile(Fishery *fishery, int reset) {
+	PyObject *profile_py;
+	int enabled = 0;
+
+#ifdef FISHERY_PROFILE
+	enabled = 1;
+#endif
+	profile_py = Py_BuildValue("{s:i,s:L,s:d,s:d,s:d,s:d}",
+		"enabled", enabled, "steps", fishery->profile.steps,
+		"vegetation", fishery->profile.vegetation_time,
+		"fish", fishery->profile.fish_time,
+		"fishing", fishery->profile.fishing_time,
+		"statistics", fishery->profile.statistics_time);
+	if (profile_py != NULL && reset)
+		ResetFisheryProfile(fishery);
+	return profile_py;
+}
+/* Iterator progressing a simulation a step at a time, i.e. 
+   Fishery.steps([n]) or MPyStepFishery. */
+typedef struct {
+	PyObject_HEAD
+	FisheryObject *object;
+	long long remaining;	/* Negative if unlimited. */
+	long long step;
+} StepsObject;
+
+static void StepsDealloc(StepsObject *self) {
+	Py_DECREF(self->object);
+	PyObject_Del(self);
+}
+/* Function: StepsNext
+ * -------------------
+ * Progresses simulation a step and returns the step tuple of BuildStep.
+ * Stops the iteration after the requested number of steps.
+ */
+static PyObject *StepsNext(StepsObject *self) {
+	Fishery *fishery = self->object->fishery;
+	Fishery_Step step;
+
+	if (self->remaining == 0)
+		return NULL;
+	if (fishery == NULL) {
+		PyErr_Format(PyExc_ValueError, "Fishery has been destroyed.");
+		return NULL;
+	}
+	step = StepFishery(fishery, *(fishery->settings));
+	step.step = ++self->step;
+	if (self->remaining > 0)
+		self->remaining--;
+	return BuildStep(&step);
+}
+static PyTypeObject StepsType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "fishery.FisherySteps",
+	.tp_basicsize = sizeof(StepsObject),
+	.tp_dealloc = (destructor)StepsDealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = "Iterator of the steps of a fishery simulation.",
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)StepsNext,
+};
+/* Function: NewStepsObject
+ * ------------------------
+ * Returns new iterator progressing the simulation of object n steps, 
+ * unlimited steps if n is negative.
+ */
+static PyObject *NewStepsObject(FisheryObject *object, long long n) {
+	StepsObject *steps;
+
+	steps = PyObject_New(StepsObject, &StepsType);
+	if (steps == NULL)
+		return NULL;
+	Py_INCREF(object);
+	steps->object = object;
+	steps->remaining = n;
+	steps->step = 0;
+	return (PyObject *)steps;
+}
+/* Results of the jobs of MPyRunFisheryJobs in shared memory. Exports the
+   table of Fishery_Job_Result as a read-only buffer, or the steps of the
+   jobs for its series view. */
+typedef struct {
+	PyObject_HEAD
+	Fishery_Job_Table *table;
+	int *fishing_chances;		/* Fishing chance of each job. */
+	PyObject *owner;			/* Table of a series view, NULL otherwise. */
+	Py_ssize_t shape[3];
+	Py_ssize_t strides[3];
+} JobTableObject;
+
+/* Buffer format of Fishery_Job_Result, all fields are eight bytes. */
+#define JOB_RESULT_FORMAT	"6q3d8q"
+
+static PyTypeObject JobTableType;
+
+static void JobTableDealloc(JobTableObject *self) {
+	if (self->owner != NULL)
+		Py_DECREF(self->owner);
+	else {
+		DestroyJobTable(self->table);
+		free(self->fishing_chances);
+	}
+	PyObject_Del(self);
+}
+/* Function: JobTableGetBuffer
+ * ---------------------------
+ * Exports the results of the jobs, or the steps of the jobs as an array
+ * of shape (jobs, steps, 4) for a series view, see BuildStep.
+ */
+static int JobTableGetBuffer(JobTableObject *self, Py_buffer *view, int flags) {
+	Fishery_Job_Table *table = self->table;
+	const int series = self->owner != NULL;
+
+	if (flags & PyBUF_WRITABLE) {
+		PyErr_Format(PyExc_BufferError, "Job table is read-only.");
+		view->obj = NULL;
+		return -1;
+	}
+	view->buf = series ? (void *)table->series : (void *)table->results;
+	view->len = series ? (Py_ssize_t)(sizeof(Fishery_Step)*table->n_jobs*table->n) :
+		(Py_ssize_t)(sizeof(Fishery_Job_Result)*table->n_jobs);
+	view->itemsize = series ? sizeof(long long) : sizeof(Fishery_Job_Result);
+	view->readonly = 1;
+	view->format = (flags & PyBUF_FORMAT) ? (char *)(series ? "q" : JOB_RESULT_FORMAT) : NULL;
+	view->ndim = series ? 3 : 1;
+	view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+	view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : NULL;
+	view->suboffsets = NULL;
+	view->internal = NULL;
+	Py_INCREF(self);
+	view->obj = (PyObject *)self;
+	return 0;
+}
+static Py_ssize_t JobTableLength(JobTableObject *self) {
+	return (Py_ssize_t)self->table->n_jobs;
+}
+/* Function: JobTableItem
+ * ----------------------
+ * Returns results of job i as a Python list, see MPyUpdateFishery, or the
+ * list of its step tuples for a series view. None if the job failed.
+ */
+static PyObject *JobTableItem(JobTableObject *self, Py_ssize_t i) {
+	Fishery_Job_Table *table = self->table;
+	JobTableObject *owner = (JobTableObject *)self->owner;
+	PyObject *steps_py, *step_py;
+	long long j;
+
+	if (i < 0 || i >= table->n_jobs) {
+		PyErr_Format(PyExc_IndexError, "Job index out of range.");
+		return NULL;
+	}
+	if (table->results[i].status != FISHERY_JOB_DONE)
+		Py_RETURN_NONE;
+	if (owner == NULL)
+		return BuildResultsList(&table->results[i].results, self->fishing_chances[i]);
+	steps_py = PyList_New((Py_ssize_t)table->n);
+	if (steps_py == NULL)
+		return NULL;
+	for (j = 0; j < table->n; j++) {
+		step_py = BuildStep(&table->series[i*table->n + j]);
+		if (step_py == NULL) {
+			Py_DECREF(steps_py);
+			return NULL;
+		}
+		PyList_SET_ITEM(steps_py, (Py_ssize_t)j, step_py);
+	}
+	return steps_py;
+}
+/* Function: JobTableGetSeries
+ * ---------------------------
+ * Returns series view of table, None if the steps were not recorded.
+ */
+static PyObject *JobTableGetSeries(JobTableObject *self, void *closure) {
+	Fishery_Job_Table *table = self->table;
+	JobTableObject *view;
+
+	if (self->owner != NULL || table->series == NULL)
+		Py_RETURN_NONE;
+	view = PyObject_New(JobTableObject, &JobTableType);
+	if (view == NULL)
+		return NULL;
+	view->table = table;
+	view->fishing_chances = NULL;
+	Py_INCREF(self);
+	view->owner = (PyObject *)self;
+	view->shape[0] = (Py_ssize_t)table->n_jobs;
+	view->shape[1] = (Py_ssize_t)table->n;
+	view->shape[2] = sizeof(Fishery_Step) / sizeof(long long);
+	view->strides[2] = sizeof(long long);
+	view->strides[1] = sizeof(Fishery_Step);
+	view->strides[0] = (Py_ssize_t)(sizeof(Fishery_Step)*table->n);
+	return (PyObject *)view;
+}
+static PyObject *JobTableGetStatus(JobTableObject *self, void *closure) {
+	Fishery_Job_Table *table = self->table;
+	PyObject *status_py, *item;
+	long long i;
+
+	status_py = PyList_New((Py_ssize_t)table->n_jobs);
+	if (status_py == NULL)
+		return NULL;
+	for (i = 0; i < table->n_jobs; i++) {
+		item = PyUnicode_FromString(table->results[i].status == FISHERY_JOB_DONE ? "done" : "failed");
+		if (item == NULL) {
+			Py_DECREF(status_py);
+			return NULL;
+		}
+		PyList_SET_ITEM(status_py, (Py_ssize_t)i, item);
+	}
+	return status_py;
+}
+static PyBufferProcs job_table_buffer = {
+	.bf_getbuffer = (getbufferproc)JobTableGetBuffer,
+};
+static PySequenceMethods job_table_sequence = {
+	.sq_length = (lenfunc)JobTableLength,
+	.sq_item = (ssizeargfunc)JobTableItem,
+};
+static PyGetSetDef job_table_getset[] = {
+	{ "series", (getter)JobTableGetSeries, NULL, 
+	"View of the steps of the jobs, None if not recorded.", NULL },
+	{ "status", (getter)JobTableGetStatus, NULL, 
+	"Status of each job, done or failed.", NULL },
+	{ NULL }
+};
+static PyTypeObject JobTableType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "fishery.JobTable",
+	.tp_basicsize = sizeof(JobTableObject),
+	.tp_dealloc = (destructor)JobTableDealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = "Results of fishery jobs run in worker processes.",
+	.tp_as_buffer = &job_table_buffer,
+	.tp_as_sequence = &job_table_sequence,
+	.tp_getset = job_table_getset,
+};
+/* Names and offsets of the integer fields of Fishery_Options. */
+static const struct fishery_option {
+	const char *name;
+	size_t offset;
+} FISHERY_OPTIONS[] = {
+	{ "fishing_sampling", offsetof(Fishery_Options, fishing_sampling) },
+	{ "private_rng", offsetof(Fishery_Options, private_rng) },
+	{ "directed_moves", offsetof(Fishery_Options, directed_moves) },
+	{ "toroidal", offsetof(Fishery_Options, toroidal) },
+	{ "phased_metabolism", offsetof(Fishery_Options, phased_metabolism) },
+	{ "spatial_sort", offsetof(Fishery_Options, spatial_sort) },
+	{ "move_radius", offsetof(Fishery_Options, move_radius) },
+};
+#define FISHERY_OPTIONS_N (sizeof(FISHERY_OPTIONS) / sizeof(FISHERY_OPTIONS[0]))
+
+/* Function: BuildOptions
+ * ----------------------
+ * Returns options of fishery as a Python dictionary, see 
+ * MPyGetFisheryOptions.
+ */
+static PyObject *BuildOptions(Fishery *fishery) {
+	PyObject *options_py, *value;
+	size_t i;
+
+	options_py = PyDict_New();
+	if (options_py == NULL)
+		return NULL;
+	for (i = 0; i < FISHERY_OPTIONS_N; i++) {
+		value = PyLong_FromLong(*(int *)((char *)&fishery->options + 
+			FISHERY_OPTIONS[i].offset));
+		if (value == NULL || PyDict_SetItemString(options_py, 
+			FISHERY_OPTIONS[i].name, value) < 0) {
+			Py_XDECREF(value);
+			Py_DECREF(options_py);
+			return NULL;
+		}
+		Py_DECREF(value);
+	}
+	return options_py;
+}
+/* Function: SetOptions
+ * --------------------
+ * Sets options of fishery from a Python dictionary, see 
+ * MPySetFisheryOptions. Options are only changed if all of them are valid.
+ *
+ * Returns:	1 if successful, 0 with a Python exception set otherwise.
+ */
+static int SetOptions(Fishery *fishery, PyObject *options_py) {
+	Fishery_Options options = fishery->options;
+	PyObject *key, *value;
+	Py_ssize_t position = 0;
+	const char *name;
+	long option;
+	size_t i;
+
+	if (!PyDict_Check(options_py)) {
+		PyErr_Format(PyExc_TypeError, "Options must be a dictionary.");
+		return 0;
+	}
+	while (PyDict_Next(options_py, &position, &key, &value)) {
+		name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : NULL;
+		if (name == NULL) {
+			if (!PyErr_Occurred())
+				PyErr_Format(PyExc_TypeError, "Option names must be strings.");
+			return 0;
+		}
+		for (i = 0; i < FISHERY_OPTIONS_N; i++)
+			if (strcmp(name, FISHERY_OPTIONS[i].name) == 0)
+				break;
+		if (i == FISHERY_OPTIONS_N) {
+			PyErr_Format(PyExc_KeyError, "Unknown option %s.", name);
+			return 0;
+		}
+		option = PyLong_AsLong(value);
+		if (option == -1 && PyErr_Occurred())
+			return 0;
+		if (option < INT_MIN || option > INT_MAX) {
+			PyErr_Format(PyExc_ValueError, "Option %s out of range.", name);
+			return 0;
+		}
+		*(int *)((char *)&options + FISHERY_OPTIONS[i].offset) = (int)option;
+	}
+	fishery->options = options;
+	return 1;
+}
+/* Function: SetLayout
+ * -------------------
+ * Sets layout of the vegetation layer of fishery by name, see 
+ * MPySetFisheryLayout.
+ *
+ * Returns:	1 if successful, 0 with a Python exception set otherwise.
+ */
+static int SetLayout(Fishery *fishery, const char *name) {
+	int type;
+
+	for (type = 0; type < FISHERY_LAYOUT_N; type++)
+		if (strcmp(name, FISHERY_LAYOUT_NAMES[type]) == 0)
+			break;
+	if (type == FISHERY_LAYOUT_N) {
+		PyErr_Format(PyExc_ValueError, "Unknown layout %s.", name);
+		return 0;
+	}
+	if (!SetFisheryLayout(fishery, type)) {
+		PyErr_Format(PyExc_ValueError, "Failed to set layout %s.", name);
+		return 0;
+	}
+	return 1;
+}
+/* Function: FisheryNew
+ * --------------------
+ * Creates Fishery object, i.e. fishery.Fishery(settings[, path]). See
+ * MPyCreateFishery for the arguments.
+ */
+static PyObject *FisheryNew(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+	PyObject *settings_py;
+	const char *path = NULL;
+
+	if (!PyArg_ParseTuple(args, "O|z", &settings_py, &path))
+		return NULL;
+	return (PyObject *)NewFisheryObject(settings_py, path, 0);
+}
+/* Function: FisheryOpen
+ * ---------------------
+ * Opens Fishery object from a storage file, i.e. 
+ * fishery.Fishery.open(settings, path). See MPyOpenFishery.
+ */
+static PyObject *FisheryOpen(PyObject *cls, PyObject *args) {
+	PyObject *settings_py;
+	const char *path;
+
+	if (!PyArg_ParseTuple(args, "Os", &settings_py, &path))
+		return NULL;
+	return (PyObject *)NewFisheryObject(settings_py, path, 1);
+}
+/* Function: FisheryFromState
+ * --------------------------
+ * Creates Fishery object from an initial state, i.e. 
+ * fishery.Fishery.from_state(settings, vegetation[, soil_energy[, fish]]).
+ * See MPyCreateFisheryFromState.
+ */
+static PyObject *FisheryFromState(PyObject *cls, PyObject *args) {
+	PyObject *settings_py, *vegetation_py, *soil_py = NULL, *fish_py = NULL;
+
+	if (!PyArg_ParseTuple(args, "OO|OO", &settings_py, &vegetation_py, &soil_py, &fish_py))
+		return NULL;
+	return (PyObject *)NewFisheryObjectFromState(settings_py, vegetation_py, soil_py, fish_py);
+}
+static void FisheryDealloc(FisheryObject *self) {
+	if (self->fishery != NULL)
+		ReleaseFishery(self->fishery);
+	PyObject_Del(self);
+}
+static PyObject *FisheryUpdate(FisheryObject *self, PyObject *args) {
+	PyObject *callback = NULL;
+	long long n, every = 1;
+
+	if (!PyArg_ParseTuple(args, "L|OL", &n, &callback, &every) || 
+		FindFisheryObject((PyObject *)self) == NULL)
+		return NULL;
+	return BuildUpdate(self, n, callback, every);
+}
+static PyObject *FisherySteps(FisheryObject *self, PyObject *args) {
+	long long n = -1;
+
+	if (!PyArg_ParseTuple(args, "|L", &n) || FindFisheryObject((PyObject *)self) == NULL)
+		return NULL;
+	return NewStepsObject(self, n);
+}
+static PyObject *FisheryVegetation(FisheryObject *self, PyObject *unused) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+
+	return fishery != NULL ? BuildVegetation(fishery) : NULL;
+}
+static PyObject *FisheryFishPopulation(FisheryObject *self, PyObject *unused) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+
+	return fishery != NULL ? BuildFishPopulation(fishery) : NULL;
+}
+static PyObject *FisherySync(FisheryObject *self, PyObject *unused) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+
+	return fishery != NULL ? Py_BuildValue("i", SyncFishery(fishery)) : NULL;
+}
+static PyObject *FisheryProfile(FisheryObject *self, PyObject *args) {
+	Fishery *fishery;
+	int reset = 0;
+
+	if (!PyArg_ParseTuple(args, "|i", &reset) || (fishery = FindFishery((PyObject *)self)) == NULL)
+		return NULL;
+	return BuildProfile(fishery, reset);
+}
+static PyObject *FisheryOptions(FisheryObject *self, PyObject *unused) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+
+	return fishery != NULL ? BuildOptions(fishery) : NULL;
+}
+static PyObject *FisherySetOptions(FisheryObject *self, PyObject *args) {
+	PyObject *options_py;
+	Fishery *fishery;
+
+	if (!PyArg_ParseTuple(args, "O", &options_py) || 
+		(fishery = FindFishery((PyObject *)self)) == NULL || !SetOptions(fishery, options_py))
+		return NULL;
+	Py_RETURN_NONE;
+}
+static PyObject *FisherySeed(FisheryObject *self, PyObject *args) {
+	unsigned long long seed;
+	Fishery *fishery;
 
-LList_Node *fishery_llist;		/* Fishery storage.*/
-unsigned int fishery_id_n = 0;	/* Fishery unique ID generated from this. 
-							       The Python module should be reset from 
-								   Python before any possible overflow.   */
+	if (!PyArg_ParseTuple(args, "K", &seed) || (fishery = FindFishery((PyObject *)self)) == NULL)
+		return NULL;
+	SeedFisheryRNG(fishery, seed);
+	Py_RETURN_NONE;
+}
+static PyObject *FisherySetLayout(FisheryObject *self, PyObject *args) {
+	const char *name;
+	Fishery *fishery;
 
-extern char *MASTER_SETTING_LIST[17][3];   /* List of setting names in the proper order.
-											  Accessed from fishery_settings.c. */
-extern int SETTINGS_SIZE;		/* Number of settings. Accessed from 
-								   fishery_settings.c. */
+	if (!PyArg_ParseTuple(args, "s", &name) || (fishery = FindFishery((PyObject *)self)) == NULL ||
+		!SetLayout(fishery, name))
+		return NULL;
+	Py_RETURN_NONE;
+}
+static PyObject *FisheryGetLayout(FisheryObject *self, void *closure) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+
+	return fishery != NULL ? 
+		PyUnicode_FromString(FISHERY_LAYOUT_NAMES[fishery->layout.type]) : NULL;
+}
+static PyObject *FisheryGetId(FisheryObject *self, void *closure) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+
+	return fishery != NULL ? PyLong_FromUnsignedLong(fishery->fishery_id) : NULL;
+}
+static PyObject *FisheryGetSettings(FisheryObject *self, void *closure) {
+	Fishery *fishery = FindFishery((PyObject *)self);
+	PyObject *owner;
 
+	if (fishery == NULL)
+		return NULL;
+	owner = fishery->settings_owner != NULL ? fishery->settings_owner : Py_None;
+	Py_INCREF(owner);
+	return owner;
+}
+static PyMethodDef fishery_object_methods[] = {
+	{ "open", (PyCFunction)FisheryOpen, METH_VARARGS | METH_CLASS, NULL },
+	{ "from_state", (PyCFunction)FisheryFromState, METH_VARARGS | METH_CLASS, NULL },
+	{ "update", (PyCFunction)FisheryUpdate, METH_VARARGS, NULL },
+	{ "steps", (PyCFunction)FisherySteps, METH_VARARGS, NULL },
+	{ "vegetation", (PyCFunction)FisheryVegetation, METH_NOARGS, NULL },
+	{ "fish_population", (PyCFunction)FisheryFishPopulation, METH_NOARGS, NULL },
+	{ "sync", (PyCFunction)FisherySync, METH_NOARGS, NULL },
+	{ "profile", (PyCFunction)FisheryProfile, METH_VARARGS, NULL },
+	{ "options", (PyCFunction)FisheryOptions, METH_NOARGS, NULL },
+	{ "set_options", (PyCFunction)FisherySetOptions, METH_VARARGS, NULL },
+	{ "seed", (PyCFunction)FisherySeed, METH_VARARGS, NULL },
+	{ "set_layout", (PyCFunction)FisherySetLayout, METH_VARARGS, NULL },
+	{ NULL, NULL, 0, NULL }
+};
+static PyGetSetDef fishery_object_getset[] = {
+	{ "id", (getter)FisheryGetId, NULL, NULL, NULL },
+	{ "layout", (getter)FisheryGetLayout, NULL, 
+	"Layout of the vegetation layer, columns or tiled.", NULL },
+	{ "settings", (getter)FisheryGetSettings, NULL, 
+	"Settings object of fishery, None if created from a dictionary.", NULL },
+	{ NULL }
+};
+static PyTypeObject FisheryType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "fishery.Fishery",
+	.tp_basicsize = sizeof(FisheryObject),
+	.tp_dealloc = (destructor)FisheryDealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = "Fishery simulation, freed when the object is deallocated.",
+	.tp_methods = fishery_object_methods,
+	.tp_getset = fishery_object_getset,
+	.tp_new = FisheryNew,
+};
+/* Function: StoreFishery
+ * ----------------------
+ * Stores Fishery object in the hash map of simulations.
+ *
+ * *object:	New reference to Fishery object, passed to the hash map.
+ *
+ * Returns:	Python integer representing fishery id.
+ */
+static PyObject *StoreFishery(FisheryObject *object) {
+	unsigned int fishery_id = object->fishery->fishery_id;
+	int success = MapInsert(object);
+
+	Py_DECREF(object);
+	if (!success)
+		return PyErr_NoMemory();
+	return PyLong_FromUnsignedLong(fishery_id);
+}
 /* Function: MPyCreateFishery
  * --------------------------
  * Initializes setting and simulation variables for the provided settings. These are 
  * assigned a unique ID which is used to keep track of the simulation.
  *
- * *args:	Dictionary of settings. See documentation for details.
+ * *args:	Settings object or dictionary of settings. See documentation for
+ *			details. Optionally a path of a file in which the vegetation 
+ *			layer is stored as a memory-mapped file instead of memory.
  *
  * Returns:	Python integer representing fishery id.
  */
 static PyObject *MPyCreateFishery(PyObject *self, PyObject *args) {
-	int i, j, list_len, *tmp_list, item;
-	PyObject *dict, *list_item;
-	Fishery_Settings *settings;
+	PyObject *settings_py;
+	FisheryObject *object;
+	const char *path = NULL;
+
+	if (!PyArg_ParseTuple(args, "O|z", &settings_py, &path))
+		return NULL;
+	object = NewFisheryObject(settings_py, path, 0);
+	if (object == NULL)
+		return NULL;
+	return StoreFishery(object);
+}
+/* Function: MPyCreateFisheryFromState
+ * -----------------------------------
+ * Initializes simulation from an initial state instead of random 
+ * placement, e.g. from survey data. The initial sizes of the settings are
+ * not used. The state is given as buffers of C ints, e.g. array.array('i')
+ * or numpy arrays of int32, and is read without Python calls per tile.
+ *
+ * *args:	Settings object or dictionary of settings.
+ *			Vegetation level of each tile, ordered like the list of
+ *			MPyGetFisheryVegetation.
+ *			Optionally soil energy of each tile in the same order, or None
+ *			for soil_energy_increase_turn.
+ *			Optionally fish pools as pairs of position and population level,
+ *			like MPyGetFisheryFishPopulation, or None.
+ *
+ * Returns:	Python integer representing fishery id. Raises TypeError for 
+ *			buffers which are not C ints and ValueError for a state which
+ *			does not match the settings.
+ */
+static PyObject *MPyCreateFisheryFromState(PyObject *self, PyObject *args) {
+	PyObject *settings_py, *vegetation_py, *soil_py = NULL, *fish_py = NULL;
+	FisheryObject *object;
+
+	if (!PyArg_ParseTuple(args, "OO|OO", &settings_py, &vegetation_py, &soil_py, &fish_py))
+		return NULL;
+	object = NewFisheryObjectFromState(settings_py, vegetation_py, soil_py, fish_py);
+	if (object == NULL)
+		return NULL;
+	return StoreFishery(object);
+}
+/* Function: MPyOpenFishery
+ * ------------------------
+ * Opens simulation from a storage file created with MPyCreateFishery and
+ * synced with MPySyncFishery. The simulation is assigned a new unique ID.
+ *
+ * *args:	Settings object or dictionary of settings the simulation was 
+ *			created with and path of the storage file.
+ *
+ * Returns:	Python integer representing fishery id.
+ */
+static PyObject *MPyOpenFishery(PyObject *self, PyObject *args) {
+	PyObject *settings_py;
+	FisheryObject *object;
+	const char *path;
+
+	if (!PyArg_ParseTuple(args, "Os", &settings_py, &path))
+		return NULL;
+	object = NewFisheryObject(settings_py, path, 1);
+	if (object == NULL)
+		return NULL;
+	return StoreFishery(object);
+}
+/* Function: MPySyncFishery
+ * ------------------------
+ * Writes a simulation created with a storage file to the file, after which
+ * the file can be opened with MPyOpenFishery.
+ *
+ * *args:	Python integer representing simulation ID, or Fishery object.
+ *
+ * Returns:	Python integer representing success. 1 if successful, 0 otherwise.
+ */
+static PyObject *MPySyncFishery(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
 	Fishery *fishery;
 
-	/* Check provided parameter is a dictionary and that it contains all 
-	   settings. Errors are raised as TypeError and KeyError exceptions. */
-	if (!PyArg_ParseTuple(args, "O!", &PyDict_Type, &dict))
+	if (!PyArg_ParseTuple(args, "O", &fishery_py) || (fishery = FindFishery(fishery_py)) == NULL)
 		return NULL;
-	for (i = 0; i < SETTINGS_SIZE; i++) {
-		if (PyDict_Contains(dict, PyUnicode_FromString(MASTER_SETTING_LIST[i][0])) != 1) {
-			PyErr_Format(PyExc_KeyError, MASTER_SETTING_LIST[i][0]);
-			return NULL;
-		}
-	}
-	/* Parse given settings and store in Fishery_Settings data type. */
-	settings = (Fishery_Settings*)malloc(sizeof(Fishery_Settings));
-	for (i = 0; i < SETTINGS_SIZE; i++) {
-		if (strcmp(MASTER_SETTING_LIST[i][1], "int") == 0) {
-			/* If setting is not a list. */
-			item = (int)PyLong_AsLong(
-				PyDict_GetItemString(dict, MASTER_SETTING_LIST[i][0]));
-			AddSetting(settings, MASTER_SETTING_LIST[i][0], &item);
-		}
-		else {
-			/* If setting is a list. */
-			list_item = PyDict_GetItemString(dict, MASTER_SETTING_LIST[i][0]);
-			if (PyList_Check(list_item) == 0)
-				return PyErr_Format(PyExc_TypeError, "Not a list.");
-			/* Length of setting list. */
-			list_len = (int)PyLong_AsLong(
-				PyDict_GetItemString(dict, MASTER_SETTING_LIST[i][2])) + 1;
-			/* Copy into temporary C array. */
-			tmp_list = (int *)malloc(sizeof(int)*list_len);
-			for (j = 0; j < list_len; j++)
-				tmp_list[j] = (int)
-					PyLong_AsLong(PyList_GetItem(list_item, (Py_ssize_t)j));
-			/* Add to Fishery_Setting data structure. */
-			AddSetting(settings, MASTER_SETTING_LIST[i][0], tmp_list);
-			/* Remember to free temporary array memory. */ 
-			free(tmp_list);
-		}
-	}
-	/* Create fishery simulation. */
-	fishery = CreateFishery(*settings);
-	fishery->fishery_id = fishery_id_n;
-	fishery->settings = settings;
-		
-	/* Store simulation in the linked list of simulations. */
-	if (fishery_llist == NULL)
-		fishery_llist = LListCreate();
-	LListAdd(fishery_llist, fishery);
-	
-	return Py_BuildValue("i", fishery_id_n++);
+	return Py_BuildValue("i", SyncFishery(fishery));
 }
 /* Function: MPyGetFisherySettingOrder
  * -----------------------------------
@@ -152,38 +1537,19 @@ PyObject *MPySetRNGSeed(PyObject *self, PyObject *args) {
  * ---------------------------------
  * Returns vegetation layer as a Python list.
  *
- * *args:	Python integer representing simulation ID.
+ * *args:	Python integer representing simulation ID, or Fishery object.
  *
  * Returns:	Python list of integers. Each element is a vegetation tile: element index
  *          is the position of the tile, element value is the tile vegetation level.
 */
 PyObject *MPyGetFisheryVegetation(PyObject *self, PyObject *args) {
-	PyObject *py_vegetation_list, *item;
-	Fishery *fishery=NULL;
-	int i, fishery_id;
+	PyObject *fishery_py;
+	Fishery *fishery;
 	
 	/* Find fishery with provided ID. */
-	if (!PyArg_ParseTuple(args, "i", &fishery_id))
-		return NULL;
-	fishery = LListSearch(fishery_llist, &fishery_id, CompareFisheries);
-	if (fishery == NULL) {
-		PyErr_Format(PyExc_KeyError, "Fishery with ID %d not found.\n", fishery_id);
-		return NULL;
-	}
-
-	py_vegetation_list = PyList_New(fishery->settings->size_x*fishery->settings->size_y);
-	if (!py_vegetation_list)
+	if (!PyArg_ParseTuple(args, "O", &fishery_py) || (fishery = FindFishery(fishery_py)) == NULL)
 		return NULL;
-	for (i = 0; i < fishery->settings->size_x*fishery->settings->size_y; i++) {
-		item = PyLong_FromLong(fishery->vegetation_layer[i].vegetation_level);
-		/* Rotate coordinates. */
-		if (PyList_SetItem(py_vegetation_list, (i / fishery->settings->size_y) +
-			(i % fishery->settings->size_y)*fishery->settings->size_x, item) == -1) {
-			Py_DECREF(py_vegetation_list);
-			return NULL;
-		}
-	}
-	return py_vegetation_list;
+	return BuildVegetation(fishery);
 }
 /* Function: MPyGetFisheryFishPopulation
  * -------------------------------------
@@ -191,72 +1557,18 @@ PyObject *MPyGetFisheryVegetation(PyObject *self, PyObject *args) {
  * Each fish is represented by its position in the vegetation layer and
  * its population level.
  * 
- * *args:	Python integer representing simulation ID.
+ * *args:	Python integer representing simulation ID, or Fishery object.
  *
  * Returns: Python list of lists of integers, i.e. [[pos, pop],...]. 
 */
 PyObject *MPyGetFisheryFishPopulation(PyObject *self, PyObject *args) {
-	PyObject *py_fish_list, *py_fish;
-	Fish_Pool *fish_ptr;
-	LList_Node *node;
-	Fishery *fishery = NULL;
-	int i, fish_pos, fish_population_size = 0, fishery_id, no_error=1;
+	PyObject *fishery_py;
+	Fishery *fishery;
 
 	/* Find fishery with provided ID. */
-	if (!PyArg_ParseTuple(args, "i", &fishery_id))
-		return NULL;
-	fishery = LListSearch(fishery_llist, &fishery_id, CompareFisheries);
-	if (fishery == NULL) {
-		PyErr_Format(PyExc_KeyError, "Fishery with ID %d not found.\n", fishery_id);
-		return NULL;
-	}
-
-	/* Find fish population size. */
-	node = fishery->fish_list;
-	while (node != NULL && node->node_value != NULL) {
-		node = node->next;
-		fish_population_size++;
-	}
-	/* Create python list of fish population. */
-	if (fish_population_size > 0) {
-		py_fish_list = PyList_New(fish_population_size);
-		if (!py_fish_list)
-			goto error;
-		node = fishery->fish_list;
-		for (i = 0; i < fish_population_size; i++) {
-			/* Fish in python will contain position and population level. */
-			fish_ptr = node->node_value;
-			py_fish = PyList_New(2);
-			if (!py_fish)
-				goto error;
-			/* fish position returned here is for the rotated coordinate system,
-			not the array structure of the c program. */
-			fish_pos = fish_ptr->pos_x + fish_ptr->pos_y*fishery->settings->size_x;
-			if(PyList_SetItem(py_fish, 0, PyLong_FromLong(fish_pos)) == -1 ||
-				PyList_SetItem(py_fish, 1, PyLong_FromLong(fish_ptr->pop_level)) == -1)
-				goto error;
-			if (PyList_SetItem(py_fish_list, i, py_fish) == -1) 
-				goto error;
-			node = node->next;
-		}
-	}
-	else {
-		py_fish_list = PyList_New(1);
-		if (!py_fish_list)
-			goto error;
-		if (PyList_SetItem(py_fish_list, 0, PyLong_FromLong(-1)) == -1)
-			goto error;
-	}
-	no_error = 1;
-
-	error:
-	if (!no_error) {
-		Py_XDECREF(py_fish);
-		Py_XDECREF(py_fish_list);
+	if (!PyArg_ParseTuple(args, "O", &fishery_py) || (fishery = FindFishery(fishery_py)) == NULL)
 		return NULL;
-	}
-
-	return py_fish_list;
+	return BuildFishPopulation(fishery);
 }
 /* Function: MPyUpdateFishery
  * --------------------------
@@ -266,80 +1578,458 @@ PyObject *MPyGetFisheryFishPopulation(PyObject *self, PyObject *args) {
  * number of fish encountered, fishing yield, vegetation level encountered,
  * std dev of fish encountered, std dev of fishing yield, 
  * std dev of vegetation level encountered, steps progressed, 
- * debugging variable, fishing chance of simulation
+ * debugging variable, fishing chance of simulation, event counts
+ *
+ * The debugging variable and fishing chance are included simply to make 
+ * debugging easier. To be removed later on. The event counts are a 
+ * dictionary with the keys moves, failed_moves, splits, failed_splits,
+ * starvation_deaths, fishing_deaths and spawns.
  *
- * The last three are numbers are included simply to make debugging easier. 
- * To be removed later on.
+ * If a callback is given, it is called from the update loop every 
+ * every'th step (default 1) with the tuple (step, fish_n, yield, 
+ * vegetation_n) of the step. The update stops early if the callback 
+ * returns a true value, the results then cover the steps progressed.
+ * Exceptions of the callback are propagated. The simulation cannot be
+ * destroyed from the callback.
  *
- * *args:	Two Python integers. The first is the simulation ID and
- * 			second the amount of steps to progress the simulation.
+ * *args:	Simulation ID (Python integer) or Fishery object, and the 
+ *			amount of steps to progress the simulation. Optionally a 
+ *			Python callable and the steps between its calls.
  *
  * Returns:	Results of the simulation update as a Python list of numerics.
 */
 PyObject *MPyUpdateFishery(PyObject *self, PyObject *args) {
-	int n, fishery_id;
-	Fishery_Results results;
+	PyObject *fishery_py, *callback = NULL;
+	FisheryObject *object;
+	long long n, every = 1;
+
+	if (!PyArg_ParseTuple(args, "OL|OL", &fishery_py, &n, &callback, &every))
+		return NULL;
+	/* Find correct fishery. */
+	object = FindFisheryObject(fishery_py);
+	if (object == NULL)
+		return NULL;
+	return BuildUpdate(object, n, callback, every);
+}
+/* Function: MPyStepFishery
+ * ------------------------
+ * Returns an iterator progressing the simulation a step at a time. Each 
+ * step yields the tuple (step, fish_n, yield, vegetation_n), where step 
+ * counts the steps of the iterator from 1. Event counts of the steps are
+ * not reported, they are reset by the next MPyUpdateFishery.
+ *
+ * *args:	Simulation ID (Python integer) or Fishery object. Optionally 
+ *			the amount of steps, unlimited if negative or not given.
+ *
+ * Returns:	Iterator of step tuples.
+*/
+PyObject *MPyStepFishery(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
+	FisheryObject *object;
+	long long n = -1;
+
+	if (!PyArg_ParseTuple(args, "O|L", &fishery_py, &n) || 
+		(object = FindFisheryObject(fishery_py)) == NULL)
+		return NULL;
+	return NewStepsObject(object, n);
+}
+/* Function: MPyGetFisheryProfile
+ * ------------------------------
+ * Returns the time spent in each phase of the simulation updates since the
+ * creation of the simulation or the previous reset. The times are only 
+ * measured if the module is compiled with FISHERY_PROFILE defined, 
+ * otherwise they are zero.
+ *
+ * *args:	Python integer representing simulation ID, or Fishery object. 
+ *			Optionally a Python integer, if nonzero the profile is reset 
+ *			after reading.
+ *
+ * Returns:	Python dictionary with the keys enabled, steps, vegetation, 
+ *			fish, fishing and statistics. Times are in seconds.
+*/
+PyObject *MPyGetFisheryProfile(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
 	Fishery *fishery;
-	PyObject *results_py;
+	int reset = 0;
 
-	if (!PyArg_ParseTuple(args, "ii", &fishery_id, &n))
+	if (!PyArg_ParseTuple(args, "O|i", &fishery_py, &reset) || 
+		(fishery = FindFishery(fishery_py)) == NULL)
 		return NULL;
-	/* Check number of steps to progress simulation is 
-	   reasonable. */
-	if (n < 0 || n > 100000) {
-		PyErr_Format(PyExc_ValueError, "Amount of steps invalid (%d). \
-			Should be larger than 0 and smaller than 100000.\n", n);
+	return BuildProfile(fishery, reset);
+}
+/* Function: MPyGetFisheryOptions
+ * ------------------------------
+ * Returns the options of the simulation, i.e. the opt-in modes of the 
+ * simulation engine.
+ *
+ * *args:	Python integer representing simulation ID, or Fishery object.
+ *
+ * Returns:	Python dictionary of option names and integer values. 
+ *			fishing_sampling: if nonzero, FishingEvent draws only the fished
+ *			fish pools instead of a trial for each fish pool.
+ *			private_rng: if nonzero, the simulation draws random numbers 
+ *			from its own stream instead of rand(), see MPySeedFishery.
+ *			directed_moves: if nonzero, hungry fish pools on empty tiles
+ *			move along the shortest path to the nearest vegetation, up to 
+ *			fish_moves_turn tiles at once, instead of random hops.
+ *			toroidal: if nonzero, the opposite borders of the vegetation 
+ *			layer are neighbors for vegetation spread and fish moves.
+ *			phased_metabolism: if nonzero, all fish pools move and feed
+ *			before the growth, splits and starvation of the population.
+ *			spatial_sort: if nonzero, fish pools are updated in the order 
+ *			of their positions, column by column, instead of the order in
+ *			which they were added.
+ *			move_radius: if over one, random moves of fish pools go to 
+ *			any free tile within this distance instead of a neighboring 
+ *			tile.
+*/
+PyObject *MPyGetFisheryOptions(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
+	Fishery *fishery;
+
+	if (!PyArg_ParseTuple(args, "O", &fishery_py) || 
+		(fishery = FindFishery(fishery_py)) == NULL)
 		return NULL;
-	}
-	/* Find correct fishery. */
-	fishery = LListSearch(fishery_llist, &fishery_id, CompareFisheries);
-	if (fishery == NULL) {
-		PyErr_Format(PyExc_KeyError, "Fishery with ID %d not found.\n", fishery_id);
+	return BuildOptions(fishery);
+}
+/* Function: MPySetFisheryOptions
+ * ------------------------------
+ * Sets options of the simulation, see MPyGetFisheryOptions. Options not 
+ * in the dictionary keep their values.
+ *
+ * *args:	Python integer representing simulation ID, or Fishery object, 
+ *			and Python dictionary of option names and integer values.
+ *
+ * Returns:	Python integer 1 if options were set. Raises KeyError for 
+ *			unknown options.
+*/
+PyObject *MPySetFisheryOptions(PyObject *self, PyObject *args) {
+	PyObject *fishery_py, *options_py;
+	Fishery *fishery;
+
+	if (!PyArg_ParseTuple(args, "OO", &fishery_py, &options_py) || 
+		(fishery = FindFishery(fishery_py)) == NULL || !SetOptions(fishery, options_py))
+		return NULL;
+	return Py_BuildValue("i", 1);
+}
+/* Function: MPySeedFishery
+ * ------------------------
+ * Seeds the random number stream of the simulation and sets its 
+ * private_rng option. Simulations with their own streams are not affected
+ * by MPySetRNGSeed or by updates of other simulations.
+ *
+ * *args:	Simulation ID (Python integer) or Fishery object, and the seed
+ *			(Python integer).
+ *
+ * Returns:	Python integer 1 if the stream was seeded.
+*/
+PyObject *MPySeedFishery(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
+	Fishery *fishery;
+	unsigned long long seed;
+
+	if (!PyArg_ParseTuple(args, "OK", &fishery_py, &seed) || 
+		(fishery = FindFishery(fishery_py)) == NULL)
+		return NULL;
+	SeedFisheryRNG(fishery, seed);
+	return Py_BuildValue("i", 1);
+}
+/* Function: MPySetFisheryLayout
+ * -----------------------------
+ * Sets layout of the vegetation layer of the simulation. The default 
+ * layout stores the tiles column by column, the tiled layout stores blocks
+ * of 8x8 tiles, which keeps neighboring tiles close in memory on large 
+ * vegetation layers. The layout does not change the simulation, and the 
+ * exported vegetation layer is the same for all layouts. Memory-mapped 
+ * vegetation layers are always stored in columns.
+ *
+ * *args:	Simulation ID (Python integer) or Fishery object, and the name 
+ *			of the layout, columns or tiled.
+ *
+ * Returns:	Python integer 1 if the layout was set.
+*/
+PyObject *MPySetFisheryLayout(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
+	Fishery *fishery;
+	const char *name;
+
+	if (!PyArg_ParseTuple(args, "Os", &fishery_py, &name) || 
+		(fishery = FindFishery(fishery_py)) == NULL || !SetLayout(fishery, name))
+		return NULL;
+	return Py_BuildValue("i", 1);
+}
+/* Function: MPyUpdateEnsemble
+ * ---------------------------
+ * Progresses simulations with equal settings n steps in lockstep. The 
+ * vegetation layers of all simulations are updated at once, which is 
+ * faster than updating the simulations one at a time for small vegetation
+ * layers. The results equal those of MPyUpdateFishery if each simulation
+ * has its own random number stream, see MPySeedFishery.
+ *
+ * *args:	Python list of simulation IDs or Fishery objects, and the amount
+ *			of steps to progress the simulations.
+ *
+ * Returns:	Python list of the results of each simulation, see 
+ *			MPyUpdateFishery.
+*/
+PyObject *MPyUpdateEnsemble(PyObject *self, PyObject *args) {
+	PyObject *fisheries_py, *results_py = NULL, *item;
+	Fishery **lanes = NULL;
+	Fishery_Ensemble *ensemble = NULL;
+	Fishery_Results *results = NULL;
+	const Fishery_Plan *plan;
+	Py_ssize_t i, n_lanes;
+	long long n;
+
+	if (!PyArg_ParseTuple(args, "O!L", &PyList_Type, &fisheries_py, &n))
+		return NULL;
+	if (n < 0) {
+		PyErr_Format(PyExc_ValueError, "Amount of steps invalid (%lld). \
+			Should not be negative.\n", n);
 		return NULL;
 	}
-	/* Update fishery and save results in Python data types. */
-	results = UpdateFishery(fishery, (*(fishery->settings)), n);
-	results_py = Py_BuildValue("[iiidddiii]", 
-		results.fish_n, results.yield, results.vegetation_n, 
-		results.fish_n_std_dev, results.yield_std_dev, results.vegetation_n_std_dev, 
-		results.steps, results.debug_stuff, fishery->settings->fishing_chance);
-	if (!results_py)
+	n_lanes = PyList_Size(fisheries_py);
+	if (n_lanes < 1 || n_lanes > INT_MAX) {
+		PyErr_Format(PyExc_ValueError, "Ensemble should have at least one fishery.");
 		return NULL;
-	
+	}
+	lanes = malloc(sizeof(Fishery *)*n_lanes);
+	results = malloc(sizeof(Fishery_Results)*n_lanes);
+	if (lanes == NULL || results == NULL) {
+		PyErr_NoMemory();
+		goto error;
+	}
+	for (i = 0; i < n_lanes; i++) {
+		lanes[i] = FindFishery(PyList_GET_ITEM(fisheries_py, i));
+		if (lanes[i] == NULL)
+			goto error;
+	}
+	plan = GetFisheryPlan(lanes[0], *(lanes[0]->settings));
+	for (i = 1; i < n_lanes; i++) {
+		if (!PlanMatchesSettings(plan, *(lanes[i]->settings))) {
+			PyErr_Format(PyExc_ValueError, "Fisheries of ensemble should have equal settings.");
+			goto error;
+		}
+	}
+	ensemble = CreateEnsemble(lanes, (int)n_lanes, *(lanes[0]->settings));
+	if (ensemble == NULL) {
+		PyErr_Format(PyExc_ValueError, "Failed to create ensemble, fisheries should "
+			"be distinct.");
+		goto error;
+	}
+	UpdateEnsemble(ensemble, *(lanes[0]->settings), n, results);
+	results_py = PyList_New(n_lanes);
+	if (results_py == NULL)
+		goto error;
+	for (i = 0; i < n_lanes; i++) {
+		item = BuildResults(lanes[i], &results[i]);
+		if (item == NULL) {
+			Py_CLEAR(results_py);
+			goto error;
+		}
+		PyList_SET_ITEM(results_py, i, item);
+	}
+
+	error:
+	DestroyEnsemble(ensemble);
+	free(lanes);
+	free(results);
 	return results_py;
 }
+/* Function: MPyUpdateFisheryDomains
+ * ---------------------------------
+ * Progresses simulation n steps decomposed into domains, i.e. strips of 
+ * columns which exchange their border columns and migrating fish pools
+ * every step. The results depend on the number of domains and the seed,
+ * but not on the transport, and differ from those of MPyUpdateFishery.
+ * The toroidal option and move radius over one are not supported.
+ *
+ * *args:	Simulation ID (Python integer) or Fishery object, the amount of
+ *			steps and the number of domains. Optionally the transport, 
+ *			local (default) to run all domains in this process or sockets
+ *			to run each domain in its own process, and the seed (Python
+ *			integer, default 0).
+ *
+ * Returns:	Results of the simulation update, see MPyUpdateFishery.
+*/
+PyObject *MPyUpdateFisheryDomains(PyObject *self, PyObject *args) {
+	PyObject *fishery_py;
+	Fishery *fishery;
+	Fishery_Results results;
+	const char *transport = "local";
+	unsigned long long seed = 0;
+	long long n;
+	int n_domains, transport_type;
+
+	if (!PyArg_ParseTuple(args, "OLi|sK", &fishery_py, &n, &n_domains, &transport, &seed) ||
+		(fishery = FindFishery(fishery_py)) == NULL)
+		return NULL;
+	if (strcmp(transport, "local") == 0)
+		transport_type = FISHERY_TRANSPORT_LOCAL;
+	else if (strcmp(transport, "sockets") == 0)
+		transport_type = FISHERY_TRANSPORT_SOCKETS;
+	else {
+		PyErr_Format(PyExc_ValueError, "Unknown transport %s.", transport);
+		return NULL;
+	}
+	if (!UpdateFisheryDomains(fishery, *(fishery->settings), n, n_domains, transport_type, 
+		seed, &results)) {
+		PyErr_Format(PyExc_ValueError, "Failed to update simulation in %d domains.", n_domains);
+		return NULL;
+	}
+	return BuildResults(fishery, &results);
+}
+/* Function: MPyRunFisheryJobs
+ * ---------------------------
+ * Runs a job for each simulation of a list in worker processes. The 
+ * workers are forked from this process, so the simulations are not 
+ * serialized, and write the results to a table in shared memory. Each 
+ * job progresses a copy of its simulation n steps, the simulations of this
+ * process are not changed. A simulation can be listed several times, e.g.
+ * with different seeds. The jobs of crashed workers fail, the other jobs
+ * are run by replacement workers.
+ *
+ * *args:	Python list of simulation IDs or Fishery objects, the amount of
+ *			steps and the number of workers. Optionally a list of seeds of
+ *			the random number streams of the jobs (see MPySeedFishery), and
+ *			True to record the steps of the jobs.
+ *
+ * Returns:	JobTable object. Item i is the result of job i as returned by
+ *			MPyUpdateFishery, or None if it failed. The table exports the
+ *			Fishery_Job_Result structures as a read-only buffer of format
+ *			"6q3d8q" (status, worker, yield, fish_n, vegetation_n, debug,
+ *			the standard deviations, steps and the event counts). If the
+ *			steps were recorded, its series attribute exports the step
+ *			tuples of the jobs as an array of shape (jobs, steps, 4), and
+ *			item i of the series is the list of step tuples of job i.
+*/
+PyObject *MPyRunFisheryJobs(PyObject *self, PyObject *args) {
+	PyObject *fisheries_py, *seeds_py = Py_None;
+	JobTableObject *object = NULL;
+	Fishery **fisheries = NULL;
+	Fishery_Settings *settings = NULL;
+	Fishery_Job_Table *table = NULL;
+	unsigned long long *seeds = NULL;
+	int *fishing_chances = NULL, n_workers, record_series = 0;
+	Py_ssize_t i, n_jobs;
+	long long n, done;
+
+	if (!PyArg_ParseTuple(args, "O!Li|Op", &PyList_Type, &fisheries_py, &n, &n_workers,
+		&seeds_py, &record_series))
+		return NULL;
+	n_jobs = PyList_Size(fisheries_py);
+	if (n < 0 || n_jobs < 1 || n_workers < 1) {
+		PyErr_Format(PyExc_ValueError, "Jobs need at least one simulation and worker, and "
+			"a non-negative amount of steps.");
+		return NULL;
+	}
+	if (seeds_py != Py_None && (!PyList_Check(seeds_py) || PyList_Size(seeds_py) != n_jobs)) {
+		PyErr_Format(PyExc_ValueError, "Seeds should be a list with a seed for each job.");
+		return NULL;
+	}
+	fisheries = malloc(sizeof(Fishery *)*n_jobs);
+	settings = malloc(sizeof(Fishery_Settings)*n_jobs);
+	fishing_chances = malloc(sizeof(int)*n_jobs);
+	seeds = seeds_py != Py_None ? malloc(sizeof(unsigned long long)*n_jobs) : NULL;
+	if (fisheries == NULL || settings == NULL || fishing_chances == NULL ||
+		(seeds_py != Py_None && seeds == NULL)) {
+		PyErr_NoMemory();
+		goto error;
+	}
+	for (i = 0; i < n_jobs; i++) {
+		fisheries[i] = FindFishery(PyList_GET_ITEM(fisheries_py, i));
+		if (fisheries[i] == NULL)
+			goto error;
+		settings[i] = *(fisheries[i]->settings);
+		fishing_chances[i] = settings[i].fishing_chance;
+		if (seeds != NULL) {
+			seeds[i] = PyLong_AsUnsignedLongLong(PyList_GET_ITEM(seeds_py, i));
+			if (PyErr_Occurred())
+				goto error;
+		}
+	}
+	table = CreateJobTable(n_jobs, n, record_series);
+	if (table == NULL) {
+		PyErr_Format(PyExc_MemoryError, "Failed to create table of %zd jobs.", n_jobs);
+		goto error;
+	}
+	fflush(stdout);
+	done = RunJobTable(table, fisheries, settings, seeds, n_workers);
+	if (done < 0) {
+		PyErr_Format(PyExc_OSError, "Failed to run jobs in worker processes.");
+		goto error;
+	}
+	object = PyObject_New(JobTableObject, &JobTableType);
+	if (object == NULL)
+		goto error;
+	object->table = table;
+	object->fishing_chances = fishing_chances;
+	object->owner = NULL;
+	object->shape[0] = n_jobs;
+	object->strides[0] = sizeof(Fishery_Job_Result);
+	table = NULL;
+	fishing_chances = NULL;
+
+	error:
+	DestroyJobTable(table);
+	free(fishing_chances);
+	free(fisheries);
+	free(settings);
+	free(seeds);
+	return (PyObject *)object;
+}
 /* Function: MPyDestroyFishery
  * ---------------------------
- * Frees memory used by simulation(s).
+ * Frees memory used by simulation(s). A destroyed Fishery object can no 
+ * longer be used.
  *
- * *args:	Python integer representing simulation ID. If the ID
- *			is -1, all simulations are removed.
+ * *args:	Python integer representing simulation ID, or Fishery object. 
+ *			If the ID is -1, all simulations with IDs are removed.
  *
  * Returns:	Python integer representing success of simulation removal.
  *			1 if simulation(s) were successfully removed, 0 otherwise.
 */
 PyObject *MPyDestroyFishery(PyObject *self, PyObject *args) {
-	int fishery_id;
+	PyObject *fishery_py;
+	FisheryObject *object;
 	Fishery *fishery;
+	size_t i;
 
-	
-	if (!PyArg_ParseTuple(args, "i", &fishery_id))
+	if (!PyArg_ParseTuple(args, "O", &fishery_py))
 		return NULL;
 
-	if (fishery_id == -1) {
+	if (PyLong_Check(fishery_py) && PyLong_AsLong(fishery_py) == -1) {
 		/* Destroy all simulation(s). */
-		LListDestroy(fishery_llist, DestroyFishery);
+		for (i = 0; i < fishery_map_size; i++)
+			Py_XDECREF(fishery_map[i].object);
+		free(fishery_map);
+		fishery_map = NULL;
+		fishery_map_size = 0;
+		fishery_map_n = 0;
+		return Py_BuildValue("i", 1);
 	}
-	else {
-		/* Find fishery with provided ID. */
-		fishery = LListSearch(fishery_llist, &fishery_id, CompareFisheries);
-		if (fishery == NULL) {
-			PyErr_Format(PyExc_KeyError, "Fishery with ID %d not found.\n", fishery_id);
-			return NULL;
-		}
-		LListPop(fishery_llist, fishery, ComparePointers);
-		DestroyFishery(fishery);
+	/* Find fishery with provided ID. */
+	object = FindFisheryObject(fishery_py);
+	if (object == NULL)
+		return NULL;
+	if (object->running) {
+		PyErr_Format(PyExc_RuntimeError, "Fishery cannot be destroyed during its update.");
+		return NULL;
+	}
+	fishery = object->fishery;
+	object = MapFind(fishery->fishery_id);
+	if (object != NULL && object->fishery == fishery)
+		MapRemove(fishery->fishery_id);
+	else
+		object = NULL;
+	/* Free simulation even if a Fishery object still refers to it. */
+	if (PyObject_TypeCheck(fishery_py, &FisheryType))
+		((FisheryObject *)fishery_py)->fishery = NULL;
+	if (object != NULL) {
+		object->fishery = NULL;
+		Py_DECREF(object);
 	}
+	ReleaseFishery(fishery);
 	return Py_BuildValue("i", 1);
 }
 
@@ -348,27 +2038,33 @@ PyObject *MPyDestroyFishery(PyObject *self, PyObject *args) {
  * Checks if fishery with fishery_id exists. Returns 1 if it exists, 
  * 0 otherwise.
  * 
- * *args:	Python integer representing simulation ID.
+ * *args:	Python integer representing simulation ID, or Fishery object.
  *
  * Returns: Python integer as boolean for simulation existence. 1 if 
  *			simulation exists, 0 otherwise.
 */
 PyObject *MPyDoesFisheryExist(PyObject *self, PyObject *args) {
-	int fishery_id, success=0;
-	Fishery *fishery;
+	PyObject *fishery_py;
+	int success = 0;
 
-	if (!PyArg_ParseTuple(args, "i", &fishery_id))
+	if (!PyArg_ParseTuple(args, "O", &fishery_py))
 		return NULL;
 	/* Find fishery with provided ID. */
-	fishery = LListSearch(fishery_llist, &fishery_id, CompareFisheries);
-	if (fishery != NULL)
+	if (FindFishery(fishery_py) != NULL)
 		success = 1;
+	else if (PyErr_ExceptionMatches(PyExc_KeyError) || 
+		PyErr_ExceptionMatches(PyExc_ValueError))
+		PyErr_Clear();
+	else
+		return NULL;
 	
 	return Py_BuildValue("i", success);
 }
 
 static PyMethodDef fishery_methods[] = {
 	{ "MPyCreateFishery", (PyCFunction) MPyCreateFishery, METH_VARARGS, NULL },
+	{ "MPyCreateFisheryFromState", (PyCFunction)MPyCreateFisheryFromState, 
+	METH_VARARGS, NULL },
 	{ "MPyGetFisheryVegetation", (PyCFunction)MPyGetFisheryVegetation, 
 	METH_VARARGS, NULL },
 	{ "MPyUpdateFishery", (PyCFunction) MPyUpdateFishery, 
@@ -380,6 +2076,21 @@ static PyMethodDef fishery_methods[] = {
 	{ "MPyDestroyFishery", (PyCFunction)MPyDestroyFishery, METH_VARARGS, NULL },
 	{ "MPyDoesFisheryExist", (PyCFunction)MPyDoesFisheryExist, METH_VARARGS, NULL },
 	{ "MPySetRNGSeed", (PyCFunction)MPySetRNGSeed, METH_VARARGS, NULL },
+	{ "MPyOpenFishery", (PyCFunction)MPyOpenFishery, METH_VARARGS, NULL },
+	{ "MPySyncFishery", (PyCFunction)MPySyncFishery, METH_VARARGS, NULL },
+	{ "MPyGetFisheryProfile", (PyCFunction)MPyGetFisheryProfile, 
+	METH_VARARGS, NULL },
+	{ "MPyStepFishery", (PyCFunction)MPyStepFishery, METH_VARARGS, NULL },
+	{ "MPySeedFishery", (PyCFunction)MPySeedFishery, METH_VARARGS, NULL },
+	{ "MPyUpdateEnsemble", (PyCFunction)MPyUpdateEnsemble, METH_VARARGS, NULL },
+	{ "MPyUpdateFisheryDomains", (PyCFunction)MPyUpdateFisheryDomains, 
+	METH_VARARGS, NULL },
+	{ "MPyRunFisheryJobs", (PyCFunction)MPyRunFisheryJobs, METH_VARARGS, NULL },
+	{ "MPySetFisheryLayout", (PyCFunction)MPySetFisheryLayout, METH_VARARGS, NULL },
+	{ "MPyGetFisheryOptions", (PyCFunction)MPyGetFisheryOptions, 
+	METH_VARARGS, NULL },
+	{ "MPySetFisheryOptions", (PyCFunction)MPySetFisheryOptions, 
+	METH_VARARGS, NULL },
 	{ NULL, NULL, 0, NULL }
 };
 
@@ -394,5 +2105,25 @@ static struct PyModuleDef fisherymodule = {
 
 PyMODINIT_FUNC PyInit_fishery(void)
 {
-	return PyModule_Create(&fisherymodule);
+	PyObject *module;
+
+	if (PyType_Ready(&SettingsType) < 0 || PyType_Ready(&FisheryType) < 0 ||
+		PyType_Ready(&StepsType) < 0 || PyType_Ready(&JobTableType) < 0)
+		return NULL;
+	module = PyModule_Create(&fisherymodule);
+	if (module == NULL)
+		return NULL;
+	Py_INCREF(&SettingsType);
+	if (PyModule_AddObject(module, "Settings", (PyObject *)&SettingsType) < 0) {
+		Py_DECREF(&SettingsType);
+		Py_DECREF(module);
+		return NULL;
+	}
+	Py_INCREF(&FisheryType);
+	if (PyModule_AddObject(module, "Fishery", (PyObject *)&FisheryType) < 0) {
+		Py_DECREF(&FisheryType);
+		Py_DECREF(module);
+		return NULL;
+	}
+	return module;
 }
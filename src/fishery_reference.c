@@ -0,0 +1,451 @@
+/*****************************************************************************
+ * Filename: fishery_reference.c											 *
+ *																			 *
+ * Contains the reference engine of the fishery simulation. The updates	 *
+ * are the original implementation of UpdateFisheryVegetation,				 *
+ * UpdateFisheryFishPopulation and FishingEvent, kept unchanged apart from	 *
+ * drawing random numbers with FISHERY_RAND, so that any optimization of	 *
+ * the engine can be checked to reproduce their results exactly. Do not	 *
+ * optimize these functions.												 *
+ *																			 *
+ * The reference engine supports the default options and the default		 *
+ * layout of columns only. Options changing the semantics of the			 *
+ * simulation, e.g. toroidal or directed_moves, are ignored.				 *
+ *																			 *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "fishery_reference.h"
+#include "fishery_functions.h"
+
+/* Function: RequireColumns
+ * ------------------------
+ * Exits if the vegetation layer of fishery does not have the layout of
+ * columns, which the reference engine indexes directly.
+ */
+static void RequireColumns(const Fishery *fishery) {
+	if (fishery->layout.type != FISHERY_LAYOUT_COLUMNS) {
+		printf("Reference engine requires the columns layout, fishery has %s.\n",
+			FISHERY_LAYOUT_NAMES[fishery->layout.type]);
+		exit(EXIT_FAILURE);
+	}
+}
+/* Function: ReferenceGetNewCoords
+ * -------------------------------
+ * Original GetNewCoords, see GetNewCoords.
+ */
+static int ReferenceGetNewCoords(
+	int cur_coords, int radius, int size_x, int size_y, Fishery *fishery) {
+	int i, j, new_pos = -1, coords_x, coords_y, *poss_coords, *poss_veg_coords,
+		candidate_coords, start_x, start_y, end_x, end_y, valid_coords = 0,
+		valid_veg_coords = 0, rand_number=0;
+
+	if (cur_coords < 0 || cur_coords > size_x*size_y - 1)
+		/* Invalid current coordinates. */
+		return -1;
+	/* Find possible coordinates. */
+	coords_x = cur_coords / size_y;
+	coords_y = cur_coords % size_y;
+	start_x = coords_x - radius < 0 ? 0 : coords_x - radius;
+	start_y = coords_y - radius < 0 ? 0 : coords_y - radius;
+	end_x = coords_x + radius > size_x - 1 ? size_x - 1 : coords_x + radius;
+	end_y = coords_y + radius > size_y - 1 ? size_y - 1 : coords_y + radius;
+	poss_coords = malloc(sizeof(int)* // for all coords
+		(end_x - start_x + 1)*(end_y - start_y + 1));
+	poss_veg_coords = malloc(sizeof(int)* // for coords with vegetation
+		(end_x - start_x + 1)*(end_y - start_y + 1));
+	/* Determine if vegetation tile is empty of fish and if it contains
+	vegetation. */
+	for (i = start_x; i <= end_x; i++) {
+		for (j = start_y; j <= end_y;j++ ) {
+			candidate_coords = j + i*size_y;
+			if (fishery->vegetation_layer[candidate_coords].local_fish == NULL
+				&& candidate_coords != cur_coords &&
+				fishery->vegetation_layer[candidate_coords]
+					.vegetation_level > 1) {
+				poss_veg_coords[valid_veg_coords] = candidate_coords;
+				valid_veg_coords++;
+			}
+			else if (fishery->vegetation_layer[candidate_coords].local_fish == NULL &&
+				candidate_coords != cur_coords) {
+				poss_coords[valid_coords] = candidate_coords;
+				valid_coords++;
+			}
+		}
+	}
+	/* Choose random coordinates if possible.*/
+	if (valid_veg_coords) {
+		rand_number = GENERATERANDINT(0, valid_veg_coords - 1);
+		new_pos = poss_veg_coords[rand_number];
+	}
+	else if (valid_coords > 0) {
+		rand_number = GENERATERANDINT(0, valid_coords - 1);
+		new_pos = poss_coords[rand_number];
+	}
+
+	free(poss_coords);
+	free(poss_veg_coords);
+	return new_pos;
+}
+/* Function ReferenceUpdateVegetation().
+ *
+ * Original UpdateFisheryVegetation, see UpdateFisheryVegetation.
+ *
+ * fishery     - Initialized or progressed fishery.
+ * settings    - Settings for fishery.
+ *
+ */
+void ReferenceUpdateVegetation(
+	Fishery *fishery, Fishery_Settings settings) {
+	int i, j, k, pos_x, pos_y;
+	int *vegetation_layer_growth;
+
+	RequireColumns(fishery);
+	vegetation_layer_growth = calloc(settings.size_x*settings.size_y, sizeof(int));
+	/* Grow vegetation layer in different array to avoid double growths. */
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		/* If tile contains vegetation. */
+		if (fishery->vegetation_layer[i].vegetation_level > 0) {
+			/* If enough soil energy for vegetation growth. */
+			if (fishery->vegetation_layer[i].vegetation_level +
+				settings.vegetation_level_growth_req <= fishery->vegetation_layer[i].soil_energy) {
+				vegetation_layer_growth[i] = 1;
+				fishery->vegetation_layer[i].soil_energy = /* Consume energy for growth. */
+					fishery->vegetation_layer[i].soil_energy -
+					fishery->vegetation_layer[i].vegetation_level
+					- settings.vegetation_level_growth_req;
+			}
+			else { /* Consumption of soil energy to maintain vegetation level. Decrease in
+				   vegetation level takes place if there is insufficient soil energy. */
+				fishery->vegetation_layer[i].soil_energy =
+					fishery->vegetation_layer[i].soil_energy -
+					settings.vegetation_consumption[fishery->vegetation_layer[i].vegetation_level];
+				if (fishery->vegetation_layer[i].soil_energy < 0)
+					vegetation_layer_growth[i] = -1;
+			}
+		}
+		/* If vegetation level is large enough, spread to neighboring tiles. */
+		if (fishery->vegetation_layer[i].vegetation_level >= settings.vegetation_level_spread_at) {
+			pos_y = i % settings.size_y;
+			pos_x = i / settings.size_y;
+			/* Spread only to valid tiles, i.e. not outside array
+			and only to empty tiles. */
+			for (j = -1; j <= 1; j++) {
+				for (k = -1; k <= 1; k++) {
+					if (pos_x + j >= 0 && pos_x + j < settings.size_x &&
+						pos_y + k >= 0 && pos_y + k < settings.size_y &&
+						fishery->vegetation_layer[(pos_y + k) + (pos_x + j)*settings.size_y].vegetation_level == 0) {
+						vegetation_layer_growth[(pos_y + k) + (pos_x + j)*settings.size_y] = 1;
+					}
+				}
+			}
+		}
+	}
+	/* Add growth layer to vegetation layer. */
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		fishery->vegetation_layer[i].vegetation_level += vegetation_layer_growth[i];
+		if (fishery->vegetation_layer[i].vegetation_level > settings.vegetation_level_max)
+			fishery->vegetation_layer[i].vegetation_level = settings.vegetation_level_max;
+	}
+	/* Add soil energy. */
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		fishery->vegetation_layer[i].soil_energy += settings.soil_energy_increase_turn;
+		if (fishery->vegetation_layer[i].soil_energy > settings.soil_energy_max)
+			fishery->vegetation_layer[i].soil_energy = settings.soil_energy_max;
+	}
+	free(vegetation_layer_growth);
+}
+/* Function ReferenceUpdateFishPopulation().
+ *
+ * Original UpdateFisheryFishPopulation, see UpdateFisheryFishPopulation.
+ * Random numbers are drawn from the stream of the fishery with the
+ * private_rng option.
+ *
+ * fishery		- Initialized or progressed fishery.
+ * settings		- Settings for fishery.
+ *
+ */
+void ReferenceUpdateFishPopulation(
+	Fishery *fishery, Fishery_Settings settings) {
+	LList_Node *fish_node, *for_deletion = NULL;
+	Fish_Pool *fish, *new_fish, *first_added = NULL;
+	int fish_pos, avail_moves, appetite, consumed, new_pos, i, pos_avail_n, *pos_avail;
+	double random_fishes_counter = settings.random_fishes_interval / 100.0;
+	Fishery_RNG *previous_stream = fishery_rng_stream;
+
+	RequireColumns(fishery);
+	fishery_rng_stream = fishery->options.private_rng ? &fishery->rng : NULL;
+	/* Process fish population. */
+	fish_node = fishery->fish_list;
+	/* Empty list will have an empty node at the beginning. */
+	while (fish_node && fish_node->node_value && fish_node->node_value != first_added) {
+		fish = fish_node->node_value;
+		fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
+		/* Consume food and move if needed. */
+		avail_moves = settings.fish_moves_turn;
+		while (avail_moves > 0 && fish->food_level <
+			settings.fish_consumption[fish->pop_level]* 2 + settings.fish_growth_req) {
+			fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
+			if (fishery->vegetation_layer[fish_pos].vegetation_level == 0) {
+				/* If no food at current tile, attempt to move. */
+				new_pos = ReferenceGetNewCoords(fish_pos, 1, settings.size_x, settings.size_y, fishery);
+				if (new_pos == -1) {
+					/* No move possible. */
+					break;
+				}
+				else {
+					/* Move fish pool. */
+					fishery->vegetation_layer[new_pos].local_fish = fish;
+					fishery->vegetation_layer[fish_pos].local_fish = NULL;
+					fish->pos_x = new_pos / settings.size_y;
+					fish->pos_y = new_pos % settings.size_y;
+				}
+			}
+			if (fishery->vegetation_layer[fish_pos].vegetation_level > 0) {
+				/* If food at current tile. */
+				/* Amount possible for fish to eat.*/
+				appetite = settings.fish_consumption[fish->pop_level] * 2 +
+					settings.fish_growth_req - fish->food_level;
+				/* Amount actually consumed based on available food. */
+				consumed = appetite > fishery->vegetation_layer[fish_pos].
+					vegetation_level ? fishery->vegetation_layer[fish_pos].
+				    vegetation_level : appetite;
+				fish->food_level += consumed;
+				fishery->vegetation_layer[fish_pos].vegetation_level
+					-= consumed;
+			}
+			avail_moves--;
+		}
+		fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
+		if (fish->food_level >= settings.fish_growth_req + settings.fish_consumption[fish->pop_level]) {
+			/* If enough food for growth or split present. */
+			if (fish->pop_level < settings.fish_level_max) {
+				/* Grow fish pool if not max size. */
+				while (fish->food_level >= settings.fish_growth_req +
+					settings.fish_consumption[fish->pop_level] &&
+					fish->pop_level < settings.fish_level_max) {
+					fish->pop_level++;
+					fish->food_level -= (settings.fish_growth_req +
+						settings.fish_consumption[fish->pop_level]);
+				}
+			}
+			else {
+				/* Else split fish pool. */
+				new_pos = ReferenceGetNewCoords(fish_pos, 1, settings.size_x, settings.size_y, fishery);
+				if (new_pos != -1 && settings.split_fishes_at_max) {
+					/* Position for splitting available. */
+					fish->food_level -= (settings.fish_growth_req +
+						settings.fish_consumption[fish->pop_level]);
+					new_fish = malloc(sizeof(Fish_Pool));
+					new_fish->food_level = 0;
+					new_fish->pop_level = 1;
+					new_fish->pos_x = new_pos / settings.size_y;
+					new_fish->pos_y = new_pos % settings.size_y;
+					fishery->vegetation_layer[new_pos].local_fish = new_fish;
+					LListAdd(fishery->fish_list, new_fish);
+					if (first_added == NULL) first_added = new_fish;
+				}
+				else {
+					/* No position available, consume food normally. */
+					fish->food_level -= settings.fish_consumption[fish->pop_level];
+				}
+			}
+		}
+		else {
+			/* Else consume food needed by fish pool population. */
+			fish->food_level -= settings.fish_consumption[fish->pop_level];
+			if (fish->food_level < 0) {
+				fish->pop_level--;
+				fish->food_level = 0;
+				if (fish->pop_level <= 0) {
+					for_deletion = fish_node;
+				}
+			}
+		}
+		if (for_deletion != NULL) {
+			fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
+			fishery->vegetation_layer[fish_pos].local_fish = NULL;
+			if (fishery->fish_list != for_deletion) {
+				/* If the fish is not the first fish in the list, move pointer to next fish. */
+				fish_node = fish_node->next;
+			}
+			fish = LListPop(fishery->fish_list, for_deletion->node_value, ComparePointers);
+			free(fish);
+			for_deletion = NULL;
+		}
+		else {
+			fish_node = fish_node->next;
+		}
+	}
+	if (settings.random_fishes_interval) {
+		if (random_fishes_counter >= FISHERY_RAND() / ((double) RAND_MAX + 1L)) {
+			/* Spawn fish randomly. Start by finding
+			   available positions for fishes. */
+			pos_avail = malloc(sizeof(int)*settings.size_x*settings.size_y);
+			pos_avail_n = 0;
+			for (i = 0; i < settings.size_x*settings.size_y; i++) {
+				if (fishery->vegetation_layer[i].local_fish == NULL)
+					pos_avail[pos_avail_n++] = i;
+			}
+			if (pos_avail_n > 0) {
+				/* If there's room for a new fish. */
+				new_pos = GENERATERANDINT(0, pos_avail_n - 1);
+				new_pos = pos_avail[new_pos];
+				new_fish = malloc(sizeof(Fish_Pool));
+				new_fish->food_level = 0;
+				new_fish->pop_level = 1;
+				new_fish->pos_x = new_pos / settings.size_y;
+				new_fish->pos_y = new_pos % settings.size_y;
+				LListAdd(fishery->fish_list, new_fish);
+				fishery->vegetation_layer[new_pos].local_fish = new_fish;
+			}
+			random_fishes_counter = 0;
+			free(pos_avail);
+		}
+	}
+	fishery_rng_stream = previous_stream;
+}
+/* Function ReferenceFishingEvent().
+ *
+ * Original FishingEvent, see FishingEvent. Random numbers are drawn from
+ * the stream of the fishery with the private_rng option.
+ *
+ * fishery     - Initialized or progressed fishery.
+ * settings    - Settings for fishery.
+ *
+ * yield       - Fish population lost during event.
+ *
+ */
+long long ReferenceFishingEvent(
+	Fishery *fishery, Fishery_Settings settings) {
+	int yield=0, fish_pos;
+	long long tot_yield=0;
+	LList_Node *fish_node, *for_deletion=NULL;
+	Fish_Pool *fish;
+	Fishery_RNG *previous_stream = fishery_rng_stream;
+
+	RequireColumns(fishery);
+	fishery_rng_stream = fishery->options.private_rng ? &fishery->rng : NULL;
+	fish_node = fishery->fish_list;
+	while (fish_node != NULL && fish_node->node_value != NULL) {
+		fish = fish_node->node_value;
+		if (FISHERY_RAND() / (double)(RAND_MAX + 1L) <= (double) settings.fishing_chance/100) {
+			yield = 1;
+			fish->pop_level -= yield;
+			tot_yield += yield;
+			if (fish->pop_level <= 0) {
+				fish_pos = fish->pos_y + fish->pos_x*settings.size_y;
+				for_deletion = fish_node;
+				if (fishery->fish_list != fish_node) {
+					/* If the fish is not the first fish in the list. */
+					fish_node = fish_node->next;
+				}
+				free(LListPop(fishery->fish_list, for_deletion->node_value, ComparePointers));
+				fishery->vegetation_layer[fish_pos].local_fish = NULL;
+				for_deletion = NULL;
+			}
+		}
+		else
+			fish_node = fish_node->next;
+	}
+	fishery_rng_stream = previous_stream;
+	return tot_yield;
+}
+/* Function ReferenceStepFishery().
+ *
+ * Progresses the fishery a single step with the reference engine, like
+ * the original UpdateFishery, and returns the totals of the step like
+ * StepFishery.
+ *
+ * fishery     - Fishery with the layout of columns.
+ * settings    - Settings for fishery.
+ *
+ * step        - Totals of the step.
+ */
+Fishery_Step ReferenceStepFishery(Fishery *fishery, Fishery_Settings settings) {
+	LList_Node *node;
+	Fishery_Step step;
+	Fish_Pool *fish;
+	long long j;
+
+	step.step = 1;
+	step.yield = 0;
+	ReferenceUpdateVegetation(fishery, settings);
+	ReferenceUpdateFishPopulation(fishery, settings);
+	step.fish_n = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next) {
+		fish = node->node_value;
+		step.fish_n += fish->pop_level;
+	}
+	if (settings.fishing_chance > 0)
+		step.yield = ReferenceFishingEvent(fishery, settings);
+	step.vegetation_n = 0;
+	for (j = 0; j < (long long)settings.size_x*settings.size_y; j++)
+		step.vegetation_n += fishery->vegetation_layer[j].vegetation_level;
+	return step;
+}
+/* Function: CompareFisheryState
+ * -----------------------------
+ * Compares the full state of two fisheries with the same settings, i.e.
+ * the vegetation level, soil energy and fish pool of every tile, and the
+ * fish pools in the order of their lists. The layouts of the fisheries
+ * can differ.
+ *
+ * *fishery1:		Pointer to first fishery.
+ * *fishery2:		Pointer to second fishery.
+ * settings:		Settings of both fisheries.
+ * output_print:	If 1, prints the first difference.
+ *					If 0, no output is printed.
+ *
+ * Returns:			1 if the states are equal, 0 otherwise.
+ */
+int CompareFisheryState(const Fishery *fishery1, const Fishery *fishery2,
+	Fishery_Settings settings, int output_print) {
+	const LList_Node *node1, *node2;
+	const Fish_Pool *fish1, *fish2;
+	const Tile *tile1, *tile2;
+	long long i = 0;
+	int pos_x, pos_y;
+
+	for (pos_x = 0; pos_x < settings.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+			tile1 = &fishery1->vegetation_layer[LayoutIndex(&fishery1->layout, pos_x, pos_y)];
+			tile2 = &fishery2->vegetation_layer[LayoutIndex(&fishery2->layout, pos_x, pos_y)];
+			if (tile1->vegetation_level != tile2->vegetation_level ||
+				tile1->soil_energy != tile2->soil_energy ||
+				(tile1->local_fish == NULL) != (tile2->local_fish == NULL)) {
+				if (output_print == 1)
+					printf("Tile (%d, %d) differs: vegetation %d/%d, soil %d/%d, fish %d/%d.\n",
+						pos_x, pos_y, tile1->vegetation_level, tile2->vegetation_level,
+						tile1->soil_energy, tile2->soil_energy,
+						tile1->local_fish != NULL, tile2->local_fish != NULL);
+				return 0;
+			}
+		}
+	}
+	node1 = fishery1->fish_list;
+	node2 = fishery2->fish_list;
+	for (;;) {
+		fish1 = node1 != NULL ? node1->node_value : NULL;
+		fish2 = node2 != NULL ? node2->node_value : NULL;
+		if (fish1 == NULL || fish2 == NULL)
+			break;
+		if (fish1->pos_x != fish2->pos_x || fish1->pos_y != fish2->pos_y ||
+			fish1->pop_level != fish2->pop_level || fish1->food_level != fish2->food_level) {
+			if (output_print == 1)
+				printf("Fish pool %lld differs: position (%d, %d)/(%d, %d), population %d/%d, "
+					"food %d/%d.\n", i, fish1->pos_x, fish1->pos_y, fish2->pos_x, fish2->pos_y,
+					fish1->pop_level, fish2->pop_level, fish1->food_level, fish2->food_level);
+			return 0;
+		}
+		node1 = node1->next;
+		node2 = node2->next;
+		i++;
+	}
+	if (fish1 != NULL || fish2 != NULL) {
+		if (output_print == 1)
+			printf("Fish pool lists differ in length after %lld fish pools.\n", i);
+		return 0;
+	}
+	return 1;
+}
@@ -78,7 +78,7 @@ Fishery_Settings CreateSettings(
 		vegetation_consumption, (settings.vegetation_level_max + 1)*sizeof(int));
 
 	settings.fish_level_max = fish_level_max;
-	settings.fish_consumption = malloc(settings.fish_level_max*sizeof(int));
+	settings.fish_consumption = malloc((settings.fish_level_max + 1)*sizeof(int));
 	memcpy(settings.fish_consumption, fish_consumption,
 		(settings.fish_level_max + 1)*sizeof(int));
 	settings.fish_growth_req = fish_growth_req;
@@ -109,20 +109,27 @@ Fishery_Settings CreateSettings(
 int ValidateSettings(
 	Fishery_Settings settings, int output_print) {
 	int settings_valid = 1, i;
+	long long n_cells = (long long)settings.size_x*settings.size_y;
 
-	if (settings.size_x <= 0 || settings.size_x > 1000) {
+	if (settings.size_x <= 0 || settings.size_x > FISHERY_MAX_SIZE_DIM) {
 		settings_valid = 0;
 		if (output_print == 1) 
 			printf("size_x is invalid (%d).\n", settings.size_x);
 	}
-	if (settings.size_y <= 0 || settings.size_y > 1000) {
+	if (settings.size_y <= 0 || settings.size_y > FISHERY_MAX_SIZE_DIM) {
 		settings_valid = 0;
 		if (output_print == 1) 
 			printf("size_y is invalid (%d).\n", settings.size_y);
 	}
+	if (n_cells > FISHERY_MAX_CELLS) {
+		settings_valid = 0;
+		if (output_print == 1)
+			printf("size_x*size_y is invalid (%lld), maximum is %lld.\n",
+				n_cells, FISHERY_MAX_CELLS);
+	}
 
 	if (settings.initial_vegetation_size < 0 ||
-		settings.initial_vegetation_size > settings.size_x*settings.size_y) {
+		settings.initial_vegetation_size > n_cells) {
 		settings_valid = 0;
 		if (output_print == 1)
 			printf("initial_vegetation_size is invalid (%d).\n",
@@ -171,7 +178,7 @@ int ValidateSettings(
 	}
 
 	if (settings.initial_fish_size < 0 ||
-		settings.initial_fish_size > settings.size_x*settings.size_y) {
+		settings.initial_fish_size > n_cells) {
 		settings_valid = 0;
 		if (output_print == 1)
 			printf("initial_fish_size is invalid (%d).\n", 
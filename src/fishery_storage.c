@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * Filename: fishery_storage.c												 *
+ *																			 *
+ * Contains functions for storing the vegetation layer of a fishery in a	 *
+ * memory-mapped file. The tiles are stored after a fixed size header and	 *
+ * the fish pools are appended after the tiles when the storage is synced,  *
+ * so the same file can be reopened as a checkpoint of the simulation.	 *
+ *																			 *
+ *****************************************************************************/
+#define _FILE_OFFSET_BITS 64
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "fishery_storage.h"
+
+#define STORAGE_MAGIC		"FISHGRID"
+#define STORAGE_VERSION		1
+/* Tiles start at a page aligned offset after the header. */
+#define STORAGE_TILE_OFFSET	4096
+/* Amount of fish pools written or read at a time. */
+#define STORAGE_FISH_BUFFER	4096
+
+/* Stores the header of the storage file. */
+typedef struct storage_header
+{
+	char magic[8];
+	int version;
+	int tile_size;
+	int size_x;
+	int size_y;
+	long long n_fish;
+} Storage_Header;
+
+#ifndef _WIN32
+/* Function: StorageMap
+ * --------------------
+ * Maps header and tiles of an opened storage file into memory.
+ *
+ * file_descriptor:	Descriptor of opened storage file.
+ * size_x:			Width of vegetation layer.
+ * size_y:			Height of vegetation layer.
+ *
+ * Returns:			Pointer to Grid_Storage, or NULL if mapping failed.
+ */
+static Grid_Storage *StorageMap(int file_descriptor, int size_x, int size_y) {
+	Grid_Storage *storage;
+	void *mapping;
+	long long n_tiles = (long long)size_x*size_y;
+	size_t mapping_size = STORAGE_TILE_OFFSET + (size_t)n_tiles*sizeof(Tile);
+
+	mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		file_descriptor, 0);
+	if (mapping == MAP_FAILED) {
+		printf("Failed to map vegetation layer storage.\n");
+		return NULL;
+	}
+	storage = malloc(sizeof(Grid_Storage));
+	if (storage == NULL) {
+		munmap(mapping, mapping_size);
+		return NULL;
+	}
+	storage->mapping = mapping;
+	storage->mapping_size = mapping_size;
+	storage->tiles = (Tile *)((char *)mapping + STORAGE_TILE_OFFSET);
+	storage->n_tiles = n_tiles;
+	storage->file_descriptor = file_descriptor;
+	storage->size_x = size_x;
+	storage->size_y = size_y;
+	return storage;
+}
+#endif
+/* Function: StorageCreate
+ * -----------------------
+ * Creates (or truncates) storage file at path and maps it into memory.
+ * The tiles of a new file are zero-filled by the operating system.
+ *
+ * *path:	Path of storage file.
+ * size_x:	Width of vegetation layer.
+ * size_y:	Height of vegetation layer.
+ *
+ * Returns:	Pointer to Grid_Storage, or NULL if storage could not be created.
+ */
+Grid_Storage *StorageCreate(const char *path, int size_x, int size_y) {
+#ifndef _WIN32
+	Grid_Storage *storage;
+	Storage_Header *header;
+	int file_descriptor;
+
+	file_descriptor = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file_descriptor == -1) {
+		printf("Failed to create vegetation layer storage %s.\n", path);
+		return NULL;
+	}
+	if (ftruncate(file_descriptor, (off_t)STORAGE_TILE_OFFSET +
+		(off_t)size_x*size_y*(off_t)sizeof(Tile)) == -1) {
+		printf("Failed to reserve vegetation layer storage %s.\n", path);
+		close(file_descriptor);
+		return NULL;
+	}
+	storage = StorageMap(file_descriptor, size_x, size_y);
+	if (storage == NULL) {
+		close(file_descriptor);
+		return NULL;
+	}
+	header = storage->mapping;
+	memcpy(header->magic, STORAGE_MAGIC, sizeof(header->magic));
+	header->version = STORAGE_VERSION;
+	header->tile_size = (int)sizeof(Tile);
+	header->size_x = size_x;
+	header->size_y = size_y;
+	header->n_fish = 0;
+	return storage;
+#else
+	printf("Memory-mapped vegetation layer storage not supported.\n");
+	return NULL;
+#endif
+}
+/* Function: StorageOpen
+ * ---------------------
+ * Opens and maps existing storage file. The file must have been created
+ * for a vegetation layer of the same size.
+ *
+ * *path:	Path of storage file.
+ * size_x:	Width of vegetation layer.
+ * size_y:	Height of vegetation layer.
+ *
+ * Returns:	Pointer to Grid_Storage, or NULL if storage could not be opened.
+ */
+Grid_Storage *StorageOpen(const char *path, int size_x, int size_y) {
+#ifndef _WIN32
+	Grid_Storage *storage;
+	Storage_Header *header;
+	struct stat file_stat;
+	int file_descriptor;
+
+	file_descriptor = open(path, O_RDWR);
+	if (file_descriptor == -1) {
+		printf("Failed to open vegetation layer storage %s.\n", path);
+		return NULL;
+	}
+	if (fstat(file_descriptor, &file_stat) == -1 || file_stat.st_size <
+		(off_t)STORAGE_TILE_OFFSET + (off_t)size_x*size_y*(off_t)sizeof(Tile)) {
+		printf("Vegetation layer storage %s is too small.\n", path);
+		close(file_descriptor);
+		return NULL;
+	}
+	storage = StorageMap(file_descriptor, size_x, size_y);
+	if (storage == NULL) {
+		close(file_descriptor);
+		return NULL;
+	}
+	header = storage->mapping;
+	if (memcmp(header->magic, STORAGE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != STORAGE_VERSION || header->tile_size != (int)sizeof(Tile) ||
+		header->size_x != size_x || header->size_y != size_y) {
+		printf("Vegetation layer storage %s does not match settings.\n", path);
+		StorageRelease(storage);
+		return NULL;
+	}
+	return storage;
+#else
+	printf("Memory-mapped vegetation layer storage not supported.\n");
+	return NULL;
+#endif
+}
+/* Function: StorageWriteFish
+ * --------------------------
+ * Writes the fish pools after the tiles and flushes the whole storage
+ * to the file, i.e. creates a checkpoint of the simulation.
+ *
+ * *storage:	Storage of fishery.
+ * *fish_list:	Fish population of fishery.
+ *
+ * Returns:		1 if successful, 0 otherwise.
+ */
+int StorageWriteFish(Grid_Storage *storage, LList_Node *fish_list) {
+#ifndef _WIN32
+	Fish_Pool *buffer;
+	LList_Node *node;
+	off_t offset;
+	long long n_fish = 0;
+	int buffer_n = 0;
+
+	buffer = malloc(sizeof(Fish_Pool)*STORAGE_FISH_BUFFER);
+	if (buffer == NULL)
+		return 0;
+	offset = (off_t)STORAGE_TILE_OFFSET + (off_t)storage->n_tiles*(off_t)sizeof(Tile);
+	node = fish_list;
+	while (node != NULL && node->node_value != NULL) {
+		buffer[buffer_n++] = *((Fish_Pool *)node->node_value);
+		node = node->next;
+		if (buffer_n == STORAGE_FISH_BUFFER || node == NULL || node->node_value == NULL) {
+			/* Buffer full or last fish pool reached. */
+			if (pwrite(storage->file_descriptor, buffer, sizeof(Fish_Pool)*buffer_n,
+				offset) != (ssize_t)(sizeof(Fish_Pool)*buffer_n)) {
+				free(buffer);
+				return 0;
+			}
+			offset += (off_t)sizeof(Fish_Pool)*buffer_n;
+			n_fish += buffer_n;
+			buffer_n = 0;
+		}
+	}
+	free(buffer);
+	if (ftruncate(storage->file_descriptor, offset) == -1)
+		return 0;
+	((Storage_Header *)storage->mapping)->n_fish = n_fish;
+	if (msync(storage->mapping, storage->mapping_size, MS_SYNC) == -1)
+		return 0;
+	return 1;
+#else
+	return 0;
+#endif
+}
+/* Function: StorageReadFish
+ * -------------------------
+ * Reads fish pools written by StorageWriteFish.
+ *
+ * *storage:		Storage of fishery.
+ * **fish_pools:	Set to array of fish pools, which the caller frees.
+ *
+ * Returns:			Number of fish pools read, -1 if reading failed.
+ */
+long long StorageReadFish(Grid_Storage *storage, Fish_Pool **fish_pools) {
+#ifndef _WIN32
+	long long n_fish = ((Storage_Header *)storage->mapping)->n_fish;
+	size_t bytes = sizeof(Fish_Pool)*(size_t)n_fish;
+
+	*fish_pools = malloc(bytes > 0 ? bytes : 1);
+	if (*fish_pools == NULL)
+		return -1;
+	if (bytes > 0 && pread(storage->file_descriptor, *fish_pools, bytes,
+		(off_t)STORAGE_TILE_OFFSET + (off_t)storage->n_tiles*(off_t)sizeof(Tile))
+		!= (ssize_t)bytes) {
+		free(*fish_pools);
+		*fish_pools = NULL;
+		return -1;
+	}
+	return n_fish;
+#else
+	*fish_pools = NULL;
+	return -1;
+#endif
+}
+/* Function: StorageRelease
+ * ------------------------
+ * Unmaps and closes storage. Changes to the tiles remain in the file.
+ *
+ * *storage:	Storage to release.
+ */
+void StorageRelease(Grid_Storage *storage) {
+	if (storage == NULL)
+		return;
+#ifndef _WIN32
+	munmap(storage->mapping, storage->mapping_size);
+	close(storage->file_descriptor);
+#endif
+	free(storage);
+}
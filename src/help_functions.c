@@ -5,9 +5,22 @@
 * fishery simulation.														 *
 *																			 *
 ******************************************************************************/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include "help_functions.h"
+#include "fishery_layout.h"
+#include "fishery_index.h"
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+Fishery_RNG *fishery_rng_stream = NULL;	/* Set while a fishery with a private
+										   stream is updated. */
 
 
 /* Function: LListCreate
@@ -72,6 +85,33 @@ LList_Node *LListAdd(
 
 	return next;
 }
+/* Function: LListAppend
+ * ---------------------
+ * Adds node pointing to node_value directly after the given node. 
+ * Used to build long lists in order without walking to the end of 
+ * the list for every added value.
+ *
+ * tail:		LList_Node pointer to last node of linked list.
+ * node_value:	Pointer to value to be stored in list.
+ *
+ * Returns:		LList_Node pointer to new last node in linked list.
+ */
+LList_Node *LListAppend(
+	LList_Node *tail, void *node_value) {
+	LList_Node *next;
+
+	if (LListIsEmpty(tail)) {
+		tail->node_value = node_value;
+		return tail;
+	}
+
+	next = malloc(sizeof(LList_Node));
+	next->next = tail->next;
+	next->node_value = node_value;
+	tail->next = next;
+
+	return next;
+}
 /* Function LListPop
  * -----------------
  * Pops (i.e. removes from list and returns) node_value. 
@@ -155,6 +195,37 @@ void *LListPop(
 		return found_node_value;
 	}
 }
+/* Function: LListRemove
+ * ----------------------
+ * Removes node from linked list in constant time. As in LListPop, the 
+ * value of the second node is moved to the root if the root is removed.
+ *
+ * *root:	Pointer to first node of linked list.
+ * *prev:	Node before node, NULL if node is root.
+ * *node:	Node to remove.
+ *
+ * Returns:	Value of removed node. The node following prev (or the root) 
+ *			is the node which followed the removed node.
+ */
+void *LListRemove(LList_Node *root, LList_Node *prev, LList_Node *node) {
+	LList_Node *next;
+	void *found_node_value = node->node_value;
+
+	if (prev != NULL) {
+		prev->next = node->next;
+		free(node);
+	}
+	else if (root->next != NULL) {
+		/* Set root to contain next node value. */
+		next = root->next;
+		root->node_value = next->node_value;
+		root->next = next->next;
+		free(next);
+	}
+	else
+		root->node_value = NULL;
+	return found_node_value;
+}
 /* Function LListSearch
  * --------------------
  * Searches for node_value in linked list. Returns pointer to value
@@ -210,13 +281,142 @@ void LListDestroy(LList_Node *root, void (*FreeValue)(void *node_value)) {
 	FreeValue(root->node_value);
 	free(root);
 }
+/* Function: SeedRNG
+ * ------------------
+ * Seeds random number stream.
+ *
+ * *rng:	Random number stream.
+ * seed:	Seed of stream.
+ */
+void SeedRNG(Fishery_RNG *rng, unsigned long long seed) {
+	rng->state = seed;
+}
+/* Function: NextRNG
+ * -----------------
+ * Draws the next number of a random number stream (splitmix64). Streams 
+ * with different seeds are independent, so each fishery can have its own.
+ *
+ * *rng:	Random number stream.
+ *
+ * Returns:	Random integer in [0, RAND_MAX], like rand().
+ */
+int NextRNG(Fishery_RNG *rng) {
+	unsigned long long z = (rng->state += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return (int)((z >> 33) % ((unsigned long long)RAND_MAX + 1));
+}
+/* Function: GenerateRandLong
+ * ---------------------------
+ * Generates random integer between a and b (inclusive). Uses a single 
+ * rand() call like GENERATERANDINT when the range fits in the resolution
+ * of rand(), otherwise several calls are combined so that large vegetation
+ * layers are sampled evenly.
+ *
+ * a:		Smallest possible value.
+ * b:		Largest possible value.
+ *
+ * Returns:	Random integer in [a, b].
+ */
+long long GenerateRandLong(long long a, long long b) {
+	double span = (double)(b - a) + 1.0, rand_value = 0.0, scale = 1.0;
+	long long rand_long;
+
+	if (span <= RAND_MAX + 1.0)
+		return (long long)((double)FISHERY_RAND() / (RAND_MAX + 1L) * span) + a;
+	/* Combine draws until the resolution is well beyond the span. */
+	do {
+		scale /= (RAND_MAX + 1.0);
+		rand_value += FISHERY_RAND() * scale;
+	} while (1.0 / scale < span * 1024.0);
+	rand_long = (long long)(rand_value * span) + a;
+	return rand_long > b ? b : rand_long;
+}
+/* Function: GenerateRandSample
+ * -----------------------------
+ * Draws k distinct integers from [0, n - 1] with a partial Fisher-Yates
+ * shuffle of the integers, i.e. draw i picks one of the n - i integers 
+ * not yet drawn with GenerateRandLong. When k is small compared to n, 
+ * only the moved integers are stored in a hash map instead of shuffling
+ * an array of all n integers. Both give the same sample.
+ *
+ * n:		Number of integers to draw from.
+ * k:		Number of integers to draw, at most n.
+ *
+ * Returns:	Array of the drawn integers in the order of drawing, freed by
+ *			the caller. NULL if memory could not be reserved.
+ */
+long long *GenerateRandSample(long long n, long long k) {
+	long long *sample, *avail, *keys, *values, i, pos, last, slot, mask, capacity;
+	int shift;
+
+	sample = malloc(sizeof(long long)*(size_t)(k > 0 ? k : 1));
+	if (sample == NULL)
+		return NULL;
+	if (k*8 >= n) {
+		/* Dense sample, shuffle all integers. */
+		avail = malloc(sizeof(long long)*(size_t)(n > 0 ? n : 1));
+		if (avail == NULL) {
+			free(sample);
+			return NULL;
+		}
+		for (i = 0; i < n; i++)
+			avail[i] = i;
+		for (i = 0; i < k; i++) {
+			pos = GenerateRandLong(0, n - 1 - i);
+			sample[i] = avail[pos];
+			avail[pos] = avail[n - 1 - i];
+		}
+		free(avail);
+		return sample;
+	}
+	/* Sparse sample. Integer pos is at position pos unless the map has an
+	   entry for it, each draw adds at most one entry. */
+	for (capacity = 16, shift = 60; capacity < 2*k; capacity *= 2, shift--);
+	mask = capacity - 1;
+	keys = malloc(sizeof(long long)*(size_t)capacity);
+	values = malloc(sizeof(long long)*(size_t)capacity);
+	if (keys == NULL || values == NULL) {
+		free(keys);
+		free(values);
+		free(sample);
+		return NULL;
+	}
+	for (i = 0; i < capacity; i++)
+		keys[i] = -1;
+	for (i = 0; i < k; i++) {
+		pos = GenerateRandLong(0, n - 1 - i);
+		/* Integer at the last position, which leaves the range. */
+		last = n - 1 - i;
+		for (slot = (long long)(((unsigned long long)last * 0x9E3779B97F4A7C15ULL) >> shift);
+			keys[slot] != -1 && keys[slot] != last; slot = (slot + 1) & mask);
+		if (keys[slot] == last)
+			last = values[slot];
+		for (slot = (long long)(((unsigned long long)pos * 0x9E3779B97F4A7C15ULL) >> shift);
+			keys[slot] != -1 && keys[slot] != pos; slot = (slot + 1) & mask);
+		sample[i] = keys[slot] == pos ? values[slot] : pos;
+		keys[slot] = pos;
+		values[slot] = last;
+	}
+	free(keys);
+	free(values);
+	return sample;
+}
 /* Function GetNewCoords().
  * Generates new, random coordinates for fish pool. New coordinates
  * are checked to be not out of bounds of the vegetation layer and to 
  * not contain any fish pools. Coordinates are prioritized according 
  * to vegetation level. Returns -1 if no coordinates can be generated.
+ * With the toroidal option of the fishery, the window of new coordinates
+ * continues across the borders, unless it covers the whole width or 
+ * height of the vegetation layer. During fish population updates with a
+ * large move radius, the window of an occupied tile is searched with the
+ * move index instead, see SampleMoveIndex.
  * 
- * cur_coords:	Current coordinates of fish pool in one dimension.
+ * cur_coords:	Current coordinates of fish pool in one dimension, i.e. 
+ *				index of its tile in the layout of the vegetation layer.
  * radius:		Largest allowed distance from current coordinates to
  *			    new coordinates.
  * size_x:		Width of vegetation layer in fishery simulation.
@@ -226,46 +426,71 @@ void LListDestroy(LList_Node *root, void (*FreeValue)(void *node_value)) {
  * Returns:		Return value. New coordinates in one dimension.
  *				Returns -1 if no possible coordinates are available.
  */
-int GetNewCoords(
-	int cur_coords, int radius, int size_x, int size_y, Fishery *fishery) {
-	int i, j, new_pos = -1, coords_x, coords_y, *poss_coords, *poss_veg_coords,
-		candidate_coords, start_x, start_y, end_x, end_y, valid_coords = 0,
-		valid_veg_coords = 0, rand_number=0;
+long long GetNewCoords(
+	long long cur_coords, int radius, int size_x, int size_y, Fishery *fishery) {
+	long long new_pos = -1, candidate_coords, row_coords, *poss_coords, *poss_veg_coords,
+		stack_coords[9], stack_veg_coords[9];
+	Tile *tile;
+	int i, j, window, coords_x, coords_y, start_x, start_y, end_x, end_y, valid_coords = 0,
+		valid_veg_coords = 0, rand_number=0, inside, stride, free_tile, veg_tile,
+		toroidal_x, toroidal_y;
 
-	if (cur_coords < 0 || cur_coords > size_x*size_y - 1)
+	if (cur_coords < 0 || cur_coords > fishery->layout.n_tiles - 1)
 		/* Invalid current coordinates. */
 		return -1;
+	/* Count the free tiles of large windows with the move index. */
+	if (radius >= MOVE_INDEX_MIN_RADIUS && fishery->move_index != NULL && fishery->move_index->valid &&
+		fishery->vegetation_layer[cur_coords].local_fish != NULL)
+		return SampleMoveIndex(fishery->move_index, fishery, cur_coords, radius);
 	/* Find possible coordinates. */
-	/* coords_x = cur_coords % size_x; */
-	coords_x = cur_coords / size_y;
-	/* coords_y = cur_coords / size_x; */
-	coords_y = cur_coords % size_y;
-	start_x = coords_x - radius < 0 ? 0 : coords_x - radius;
-	start_y = coords_y - radius < 0 ? 0 : coords_y - radius;
-	end_x = coords_x + radius > size_x - 1 ? size_x - 1 : coords_x + radius;
-	end_y = coords_y + radius > size_y - 1 ? size_y - 1 : coords_y + radius;
-	poss_coords = malloc(sizeof(int)* // for all coords
-		(end_x - start_x + 1)*(end_y - start_y + 1));
-	poss_veg_coords = malloc(sizeof(int)* // for coords with vegetation
-		(end_x - start_x + 1)*(end_y - start_y + 1));
+	LayoutCoords(&fishery->layout, cur_coords, &coords_x, &coords_y);
+	toroidal_x = fishery->options.toroidal && 2*radius + 1 < size_x;
+	toroidal_y = fishery->options.toroidal && 2*radius + 1 < size_y;
+	start_x = coords_x - radius < 0 && !toroidal_x ? 0 : coords_x - radius;
+	start_y = coords_y - radius < 0 && !toroidal_y ? 0 : coords_y - radius;
+	end_x = coords_x + radius > size_x - 1 && !toroidal_x ? size_x - 1 : coords_x + radius;
+	end_y = coords_y + radius > size_y - 1 && !toroidal_y ? size_y - 1 : coords_y + radius;
+	window = (end_x - start_x + 1)*(end_y - start_y + 1);
+	/* Window inside the vegetation layer does not wrap. In columns, and
+	   inside a block of tiled layout, its tiles are at fixed offsets from
+	   the current coordinates. */
+	inside = start_x >= 0 && start_y >= 0 && end_x < size_x && end_y < size_y;
+	stride = 0;
+	if (inside && fishery->layout.type == FISHERY_LAYOUT_COLUMNS)
+		stride = size_y;
+	else if (inside && fishery->layout.type == FISHERY_LAYOUT_TILED &&
+		(start_x >> FISHERY_BLOCK_SHIFT) == (end_x >> FISHERY_BLOCK_SHIFT) &&
+		(start_y >> FISHERY_BLOCK_SHIFT) == (end_y >> FISHERY_BLOCK_SHIFT))
+		stride = FISHERY_BLOCK_SIZE;
+	if (window <= 9) {
+		/* Radius of one, no need to reserve memory. */
+		poss_coords = stack_coords;
+		poss_veg_coords = stack_veg_coords;
+	}
+	else {
+		poss_coords = malloc(sizeof(long long)*window); // for all coords
+		poss_veg_coords = malloc(sizeof(long long)*window); // for coords with vegetation
+	}
 	/* Determine if vegetation tile is empty of fish and if it contains
-	vegetation. */
+	vegetation. Each candidate is written to both lists and kept by the
+	one it belongs to, without branching on the tile. */
 	for (i = start_x; i <= end_x; i++) {
+		row_coords = cur_coords + (long long)(i - coords_x)*stride - coords_y;
 		for (j = start_y; j <= end_y;j++ ) {
-			/* candidate_coords = i + j*size_x; */
-			candidate_coords = j + i*size_y;
-			if (fishery->vegetation_layer[candidate_coords].local_fish == NULL 
-				&& candidate_coords != cur_coords && 
-				fishery->vegetation_layer[candidate_coords]
-					.vegetation_level > 1) {
-				poss_veg_coords[valid_veg_coords] = candidate_coords;
-				valid_veg_coords++;
-			}
-			else if (fishery->vegetation_layer[candidate_coords].local_fish == NULL &&
-				candidate_coords != cur_coords) {
-				poss_coords[valid_coords] = candidate_coords;
-				valid_coords++;
-			}
+			if (stride > 0)
+				candidate_coords = row_coords + j;
+			else if (!inside)
+				candidate_coords = LayoutIndex(&fishery->layout, 
+					(i + size_x) % size_x, (j + size_y) % size_y);
+			else
+				candidate_coords = LayoutIndex(&fishery->layout, i, j);
+			tile = &fishery->vegetation_layer[candidate_coords];
+			free_tile = tile->local_fish == NULL && candidate_coords != cur_coords;
+			veg_tile = free_tile && tile->vegetation_level > 1;
+			poss_veg_coords[valid_veg_coords] = candidate_coords;
+			valid_veg_coords += veg_tile;
+			poss_coords[valid_coords] = candidate_coords;
+			valid_coords += free_tile && !veg_tile;
 		}
 	}
 	/* Choose random coordinates if possible.*/
@@ -278,8 +503,10 @@ int GetNewCoords(
 		new_pos = poss_coords[rand_number];
 	}
 
-	free(poss_coords);
-	free(poss_veg_coords);
+	if (poss_coords != stack_coords) {
+		free(poss_coords);
+		free(poss_veg_coords);
+	}
 	return new_pos;
 }
 /* Function: CompareInts
@@ -326,4 +553,25 @@ int CompareFisheries(const void *fishery1, const void *fishery_id) {
 		return 1;
 	else
 		return 0;
-}
\ No newline at end of file
+}
+/* Function: GetTimeSeconds
+ * ------------------------
+ * Reads monotonic high-resolution clock. Only differences between two 
+ * readings are meaningful.
+ *
+ * Returns:	Current time of clock in seconds.
+ */
+double GetTimeSeconds(void) {
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / frequency.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+#endif
+}
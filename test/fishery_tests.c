@@ -7,6 +7,7 @@ Contains functions for testing different properties of the fishery simulation.
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include "fishery_tests.h"
 
 /* Function TestFisheryAll()
@@ -26,8 +27,29 @@ int TestFisheryAll() {
 	printf("-----------\n");
 	TestFisherySettings();
 	TestInitialFishery();
+	TestCreateFisheryFromState();
 	TestAddSettings();
 	TestGetNewCoords();
+	TestGenerateRandLong();
+	TestGenerateRandSample();
+	TestFisheryStorage();
+	TestFisheryPlan();
+	TestFisheryProfile();
+	TestFisheryEvents();
+	TestFishingSampling();
+	TestUpdateFisheryCallback();
+	TestFisheryEnsemble();
+	TestFisheryLayout();
+	TestVegetationSpread();
+	TestDirectedMoves();
+	TestToroidal();
+	TestPhasedMetabolism();
+	TestSpatialSort();
+	TestQuiescence();
+	TestMoveIndex();
+	TestFisheryDomains();
+	TestJobTable();
+	TestReferenceEngine();
 	printf("-----------\n");
 	printf("All tests passed.\n");
 	printf("-----------\n");
@@ -104,6 +126,15 @@ int TestFisherySettings() {
 	assert(ValidateSettings(settings, 0) == 0);
 	settings.initial_fish_size = 10;
 
+	/* Dimensions within limits, but too many cells in total. */
+	settings.size_x = FISHERY_MAX_SIZE_DIM + 1;
+	assert(ValidateSettings(settings, 0) == 0);
+	settings.size_x = FISHERY_MAX_SIZE_DIM;
+	settings.size_y = FISHERY_MAX_SIZE_DIM;
+	assert(ValidateSettings(settings, 0) == 0);
+	settings.size_x = 10;
+	settings.size_y = 10;
+
 	printf("Test passed.\n");
 	return 1;
 }
@@ -233,6 +264,89 @@ int TestInitialFishery(void) {
 	printf("Test passed.\n");
 	return 1;
 }
+int TestCreateFisheryFromState(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *state_fishery;
+	Fishery_Results results, state_results;
+	LList_Node *node;
+	Fish_Pool *fish_pools;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	int *vegetation_levels, *soil_energies;
+	long long i, n_fish = 0;
+
+	settings.size_x = 30;
+	settings.size_y = 20;
+	settings.initial_vegetation_size = 100;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 50;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing CreateFisheryFromState()!\n");
+	srand(17);
+	fishery = CreateFishery(settings);
+	UpdateFishery(fishery, settings, 10);
+	/* Copy state of fishery. */
+	vegetation_levels = malloc(sizeof(int)*settings.size_x*settings.size_y);
+	soil_energies = malloc(sizeof(int)*settings.size_x*settings.size_y);
+	fish_pools = malloc(sizeof(Fish_Pool)*settings.size_x*settings.size_y);
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		vegetation_levels[i] = fishery->vegetation_layer[i].vegetation_level;
+		soil_energies[i] = fishery->vegetation_layer[i].soil_energy;
+	}
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		fish_pools[n_fish++] = *(Fish_Pool *)node->node_value;
+	state_fishery = CreateFisheryFromState(settings, vegetation_levels, soil_energies,
+		fish_pools, n_fish);
+	assert(state_fishery != NULL);
+	assert(CheckFishMemory(state_fishery, settings));
+	/* Same state and random numbers must produce the same simulation. */
+	srand(18);
+	results = UpdateFishery(fishery, settings, 20);
+	srand(18);
+	state_results = UpdateFishery(state_fishery, settings, 20);
+	assert(results.fish_n == state_results.fish_n && results.yield == state_results.yield &&
+		results.vegetation_n == state_results.vegetation_n);
+	DestroyFishery(state_fishery);
+
+	/* Fish pools growing past a level can be left with negative food. */
+	fish_pools[0].food_level = -1;
+	state_fishery = CreateFisheryFromState(settings, vegetation_levels, soil_energies, fish_pools, 1);
+	assert(state_fishery != NULL);
+	DestroyFishery(state_fishery);
+	/* Invalid states. */
+	fish_pools[1] = fish_pools[0];
+	assert(CreateFisheryFromState(settings, vegetation_levels, NULL, fish_pools, 2) == NULL);
+	fish_pools[0].pos_x = settings.size_x;
+	assert(CreateFisheryFromState(settings, vegetation_levels, NULL, fish_pools, 1) == NULL);
+	vegetation_levels[0] = settings.vegetation_level_max + 1;
+	assert(CreateFisheryFromState(settings, vegetation_levels, NULL, NULL, 0) == NULL);
+	vegetation_levels[0] = 0;
+	state_fishery = CreateFisheryFromState(settings, vegetation_levels, NULL, NULL, 0);
+	assert(state_fishery != NULL && LListIsEmpty(state_fishery->fish_list));
+	assert(state_fishery->vegetation_layer[0].soil_energy == settings.soil_energy_increase_turn);
+	DestroyFishery(state_fishery);
+	DestroyFishery(fishery);
+	free(vegetation_levels);
+	free(soil_energies);
+	free(fish_pools);
+	printf("Test passed.\n");
+	return 1;
+}
 int TestGetNewCoords(void) {
 	Fishery_Settings settings;
 	Fishery *fishery;
@@ -286,3 +400,1444 @@ int TestGetNewCoords(void) {
 	printf("Test passed.\n");
 	return 1;
 }
+
+int TestGenerateRandLong(void) {
+	long long i, rand_long, below_half = 0, large = 1LL << 34;
+
+	printf("Testing GenerateRandLong()!\n");
+	for (i = 0; i < 1000; i++) {
+		rand_long = GenerateRandLong(0, 9);
+		assert(rand_long >= 0 && rand_long <= 9);
+		rand_long = GenerateRandLong(large, 2 * large);
+		assert(rand_long >= large && rand_long <= 2 * large);
+		if (rand_long < large + large / 2)
+			below_half++;
+	}
+	/* Values beyond the range of rand() must be reachable. */
+	assert(below_half > 400 && below_half < 600);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestGenerateRandSample(void) {
+	long long n[] = { 1, 10, 1000, 100000, 3000000000LL };
+	long long k[] = { 1, 10, 50, 5000, 2000 };
+	long long *sample, *avail, i, j, pos;
+	
+	printf("Testing GenerateRandSample()!\n");
+	for (i = 0; i < (long long)(sizeof(n) / sizeof(n[0])); i++) {
+		/* Sparse samples must match the shuffle of all integers. */
+		srand(16);
+		sample = GenerateRandSample(n[i], k[i] < n[i] ? k[i] : n[i]);
+		assert(sample != NULL);
+		if (n[i] <= 100000) {
+			avail = malloc(sizeof(long long)*n[i]);
+			for (j = 0; j < n[i]; j++)
+				avail[j] = j;
+			srand(16);
+			for (j = 0; j < k[i] && j < n[i]; j++) {
+				pos = GenerateRandLong(0, n[i] - 1 - j);
+				assert(sample[j] == avail[pos]);
+				avail[pos] = avail[n[i] - 1 - j];
+			}
+			free(avail);
+		}
+		for (j = 0; j < k[i] && j < n[i]; j++) {
+			assert(sample[j] >= 0 && sample[j] < n[i]);
+			for (pos = 0; pos < j && n[i] > 100000; pos++)
+				assert(sample[pos] != sample[j]);
+		}
+		free(sample);
+	}
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFisheryStorage(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *fishery_mapped;
+	Fishery_Results results, results_mapped;
+	LList_Node *node, *node_mapped;
+	Fish_Pool *fish, *fish_mapped;
+	long long i;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	const char *path = "fishery_storage_test.bin";
+
+	/* Columns of the vegetation layer span several words of the bitboards. */
+	settings.size_x = 300;
+	settings.size_y = 250;
+	settings.initial_vegetation_size = 2000;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 500;
+	settings.fish_growth_req = 2;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 3;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 10;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing CreateFisheryMapped()!\n");
+	/* Same random numbers must produce the same simulation. */
+	srand(5);
+	fishery = CreateFishery(settings);
+	results = UpdateFishery(fishery, settings, 20);
+	srand(5);
+	fishery_mapped = CreateFisheryMapped(settings, path);
+	assert(fishery_mapped != NULL);
+	results_mapped = UpdateFishery(fishery_mapped, settings, 20);
+	assert(results.fish_n == results_mapped.fish_n);
+	assert(results.yield == results_mapped.yield);
+	assert(results.vegetation_n == results_mapped.vegetation_n);
+
+	/* Reopened checkpoint must match the simulation. */
+	assert(SyncFishery(fishery_mapped) == 1);
+	DestroyFishery(fishery_mapped);
+	fishery_mapped = OpenFisheryMapped(settings, path);
+	assert(fishery_mapped != NULL);
+	assert(CheckFishMemory(fishery_mapped, settings));
+	for (i = 0; i < (long long)settings.size_x*settings.size_y; i++) {
+		assert(fishery->vegetation_layer[i].vegetation_level ==
+			fishery_mapped->vegetation_layer[i].vegetation_level);
+		assert(fishery->vegetation_layer[i].soil_energy ==
+			fishery_mapped->vegetation_layer[i].soil_energy);
+	}
+	node = fishery->fish_list;
+	node_mapped = fishery_mapped->fish_list;
+	while (node != NULL && node->node_value != NULL) {
+		assert(node_mapped != NULL && node_mapped->node_value != NULL);
+		fish = node->node_value;
+		fish_mapped = node_mapped->node_value;
+		assert(fish->pos_x == fish_mapped->pos_x && fish->pos_y == fish_mapped->pos_y);
+		assert(fish->pop_level == fish_mapped->pop_level);
+		assert(fish->food_level == fish_mapped->food_level);
+		node = node->next;
+		node_mapped = node_mapped->next;
+	}
+	assert(node_mapped == NULL || node_mapped->node_value == NULL);
+	/* Settings of different size do not match storage. */
+	settings.size_x = 10;
+	assert(OpenFisheryMapped(settings, path) == NULL);
+
+	DestroyFishery(fishery);
+	DestroyFishery(fishery_mapped);
+	remove(path);
+	printf("Test passed.\n");
+	return 1;
+}int TestFisheryPlan(void) {
+	Fishery_Settings settings;
+	Fishery_Plan *plan;
+	Fishery *fishery;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+
+	settings.size_x = 20;
+	settings.size_y = 20;
+	settings.initial_vegetation_size = 50;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 10;
+	settings.fish_growth_req = 2;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 3;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 25;
+
+	printf("Testing CreatePlan()!\n");
+	plan = CreatePlan(settings);
+	assert(plan != NULL);
+	assert(plan->fish_appetite[3] == 3 * 2 + 2);
+	assert(plan->fish_growth_threshold[3] == 3 + 2);
+	assert(!plan->vegetation_spreads[2] && plan->vegetation_spreads[3]);
+	assert(plan->fishing_probability == 0.25);
+	assert(plan->fish_kernel == FISH_KERNEL_SPLIT);
+	assert(PlanMatchesSettings(plan, settings));
+	/* Plan keeps its own copy of the lists. */
+	fish_consumption[3] = 4;
+	assert(!PlanMatchesSettings(plan, settings));
+	fish_consumption[3] = 3;
+	settings.random_fishes_interval = 10;
+	assert(!PlanMatchesSettings(plan, settings));
+	DestroyPlan(plan);
+
+	/* Fishery rebuilds plan when settings change between updates. */
+	fishery = CreateFishery(settings);
+	UpdateFishery(fishery, settings, 2);
+	settings.fishing_chance = 50;
+	UpdateFishery(fishery, settings, 2);
+	assert(fishery->plan->fishing_probability == 0.5);
+	assert(fishery->plan->fish_kernel == (FISH_KERNEL_SPLIT | FISH_KERNEL_SPAWN));
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFisheryProfile(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+
+	settings.size_x = 20;
+	settings.size_y = 20;
+	settings.initial_vegetation_size = 50;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 10;
+	settings.fish_growth_req = 2;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 3;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 10;
+
+	settings.fishing_chance = 25;
+
+	printf("Testing ResetFisheryProfile()!\n");
+	fishery = CreateFishery(settings);
+	assert(fishery->profile.steps == 0 && fishery->profile.fish_time == 0.0);
+	UpdateFishery(fishery, settings, 5);
+	UpdateFishery(fishery, settings, 3);
+	assert(fishery->profile.steps == 8);
+	assert(fishery->profile.vegetation_time >= 0.0 && fishery->profile.fish_time >= 0.0 &&
+		fishery->profile.fishing_time >= 0.0 && fishery->profile.statistics_time >= 0.0);
+#ifdef FISHERY_PROFILE
+	assert(fishery->profile.vegetation_time + fishery->profile.fish_time +
+		fishery->profile.fishing_time + fishery->profile.statistics_time > 0.0);
+#endif
+	ResetFisheryProfile(fishery);
+	assert(fishery->profile.steps == 0 && fishery->profile.vegetation_time == 0.0);
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFisheryEvents(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	Fishery_Results results;
+	LList_Node *node;
+	long long fish_pools_before, fish_pools_after;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+
+	settings.size_x = 15;
+	settings.size_y = 10;
+	settings.initial_vegetation_size = 50;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 40;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing event counts of UpdateFishery()!\n");
+	srand(3);
+	fishery = CreateFishery(settings);
+	UpdateFishery(fishery, settings, 10);
+	fish_pools_before = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		fish_pools_before++;
+	results = UpdateFishery(fishery, settings, 50);
+	fish_pools_after = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		fish_pools_after++;
+	/* Counts are for the latest call and explain the change in fish pools. */
+	assert(fish_pools_after == fish_pools_before + results.events.splits + 
+		results.events.spawns - results.events.starvation_deaths - 
+		results.events.fishing_deaths);
+	assert(results.events.moves > 0);
+	assert(results.events.failed_moves >= 0 && results.events.failed_splits >= 0);
+	/* No splitting or fishing, no such events. */
+	settings.split_fishes_at_max = 0;
+	settings.fishing_chance = 0;
+	results = UpdateFishery(fishery, settings, 20);
+	assert(results.events.splits == 0 && results.events.failed_splits == 0);
+	assert(results.events.fishing_deaths == 0);
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFishingSampling(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	LList_Node *node;
+	Fish_Pool *fish;
+	long long yield[2] = { 0, 0 }, deaths[2] = { 0, 0 }, fish_n = 0;
+	double expected_yield, expected_deaths;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	int mode, rep;
+
+	settings.size_x = 50;
+	settings.size_y = 50;
+	settings.initial_vegetation_size = 0;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 2000;
+	settings.fish_growth_req = 2;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 3;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 30;
+
+	printf("Testing FishingEvent() with fishing_sampling!\n");
+	/* Fish pools of level 3 yield k or more with probability 0.3^k. */
+	for (mode = 0; mode < 2; mode++) {
+		srand(11);
+		for (rep = 0; rep < 20; rep++) {
+			fishery = CreateFishery(settings);
+			fishery->options.fishing_sampling = mode;
+			for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next) {
+				fish = node->node_value;
+				fish->pop_level = 3;
+			}
+			yield[mode] += FishingEvent(fishery, settings);
+			deaths[mode] += fishery->events.fishing_deaths;
+			assert(CheckFishMemory(fishery, settings));
+			DestroyFishery(fishery);
+		}
+	}
+	fish_n = 20 * (long long)settings.initial_fish_size;
+	expected_yield = (0.3 + 0.3*0.3 + 0.3*0.3*0.3) * fish_n;
+	expected_deaths = 0.3*0.3*0.3 * fish_n;
+	for (mode = 0; mode < 2; mode++) {
+		assert(fabs(yield[mode] - expected_yield) < 0.03 * expected_yield);
+		assert(fabs(deaths[mode] - expected_deaths) < 0.15 * expected_deaths);
+	}
+	printf("Test passed.\n");
+	return 1;
+}
+/* Records the steps passed to the callback and stops at step data[0]. */
+static int StopAtStep(void *data, const Fishery_Step *step) {
+	long long *steps = data;
+
+	steps[1]++;
+	steps[2] += step->yield;
+	return step->step >= steps[0];
+}
+int TestUpdateFisheryCallback(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	Fishery_Results results, callback_results;
+	Fishery_Step step;
+	long long i, steps[3], yield = 0;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+
+	settings.size_x = 15;
+	settings.size_y = 10;
+	settings.initial_vegetation_size = 50;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 40;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing UpdateFisheryCallback() and StepFishery()!\n");
+	srand(5);
+	fishery = CreateFishery(settings);
+	results = UpdateFishery(fishery, settings, 60);
+	DestroyFishery(fishery);
+
+	/* Callbacks do not change the simulation. */
+	srand(5);
+	fishery = CreateFishery(settings);
+	steps[0] = 1000;
+	steps[1] = steps[2] = 0;
+	callback_results = UpdateFisheryCallback(fishery, settings, 60, 1, StopAtStep, steps);
+	assert(steps[1] == 60 && steps[2] == results.yield);
+	assert(callback_results.steps == 60 && callback_results.yield == results.yield &&
+		callback_results.fish_n == results.fish_n &&
+		callback_results.vegetation_n == results.vegetation_n);
+	DestroyFishery(fishery);
+
+	/* Single steps progress the simulation like an update. */
+	srand(5);
+	fishery = CreateFishery(settings);
+	for (i = 0; i < 60; i++) {
+		step = StepFishery(fishery, settings);
+		yield += step.yield;
+	}
+	assert(yield == results.yield);
+	/* Callback every 4 steps stops the update at step 20. */
+	steps[0] = 20;
+	steps[1] = 0;
+	callback_results = UpdateFisheryCallback(fishery, settings, 100, 4, StopAtStep, steps);
+	assert(steps[1] == 5 && callback_results.steps == 20);
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFisheryEnsemble(void) {
+	Fishery_Settings settings;
+	Fishery *lanes[3], *shared_lanes[3], *fisheries[3];
+	Fishery_Ensemble *ensemble;
+	Fishery_Results ensemble_results[3], results;
+	long long i;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	int l;
+
+	settings.size_x = 30;
+	settings.size_y = 30;
+	settings.initial_vegetation_size = 200;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 40;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing UpdateEnsemble()!\n");
+	/* Fisheries with own random number streams, updated in an ensemble and
+	   one at a time. */
+	for (l = 0; l < 3; l++) {
+		srand(20 + l);
+		lanes[l] = CreateFishery(settings);
+		SeedFisheryRNG(lanes[l], 100 + l);
+		srand(20 + l);
+		fisheries[l] = CreateFishery(settings);
+		SeedFisheryRNG(fisheries[l], 100 + l);
+	}
+	ensemble = CreateEnsemble(lanes, 3, settings);
+	assert(ensemble != NULL);
+	UpdateEnsemble(ensemble, settings, 40, ensemble_results);
+	for (l = 0; l < 3; l++) {
+		results = UpdateFishery(fisheries[l], settings, 40);
+		assert(ensemble_results[l].yield == results.yield);
+		assert(ensemble_results[l].fish_n == results.fish_n);
+		assert(ensemble_results[l].vegetation_n == results.vegetation_n);
+		assert(ensemble_results[l].events.moves == results.events.moves);
+		for (i = 0; i < (long long)settings.size_x*settings.size_y; i++) {
+			assert(lanes[l]->vegetation_layer[i].vegetation_level ==
+				fisheries[l]->vegetation_layer[i].vegetation_level);
+			assert(lanes[l]->vegetation_layer[i].soil_energy ==
+				fisheries[l]->vegetation_layer[i].soil_energy);
+		}
+		assert(CheckFishMemory(lanes[l], settings));
+	}
+	/* The streams of the fisheries differ. */
+	assert(ensemble_results[0].fish_n != ensemble_results[1].fish_n ||
+		ensemble_results[1].fish_n != ensemble_results[2].fish_n);
+	/* A fishery can not be a lane twice. */
+	shared_lanes[0] = shared_lanes[1] = lanes[0];
+	shared_lanes[2] = lanes[2];
+	assert(CreateEnsemble(shared_lanes, 3, settings) == NULL);
+	DestroyEnsemble(ensemble);
+	for (l = 0; l < 3; l++) {
+		DestroyFishery(fisheries[l]);
+		DestroyFishery(lanes[l]);
+	}
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFisheryLayout(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *tiled_fishery;
+	Fishery_Results results, tiled_results;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	int pos_x, pos_y, coords_x, coords_y;
+
+	/* Size not divisible by the blocks of the tiled layout. */
+	settings.size_x = 21;
+	settings.size_y = 13;
+	settings.initial_vegetation_size = 60;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 30;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing SetFisheryLayout()!\n");
+	srand(8);
+	fishery = CreateFishery(settings);
+	srand(8);
+	tiled_fishery = CreateFishery(settings);
+	assert(SetFisheryLayout(tiled_fishery, FISHERY_LAYOUT_TILED));
+	assert(tiled_fishery->layout.n_tiles == 24 * 16);
+	for (pos_x = 0; pos_x < settings.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+			LayoutCoords(&tiled_fishery->layout, 
+				LayoutIndex(&tiled_fishery->layout, pos_x, pos_y), &coords_x, &coords_y);
+			assert(coords_x == pos_x && coords_y == pos_y);
+		}
+	}
+	assert(CheckFishMemory(tiled_fishery, settings));
+	/* The layout does not change the simulation. */
+	srand(9);
+	results = UpdateFishery(fishery, settings, 60);
+	srand(9);
+	tiled_results = UpdateFishery(tiled_fishery, settings, 60);
+	assert(results.yield == tiled_results.yield && results.fish_n == tiled_results.fish_n &&
+		results.vegetation_n == tiled_results.vegetation_n);
+	assert(CheckFishMemory(tiled_fishery, settings));
+	/* Back to columns, the vegetation layers are equal. */
+	assert(SetFisheryLayout(tiled_fishery, FISHERY_LAYOUT_COLUMNS));
+	for (pos_x = 0; pos_x < settings.size_x*settings.size_y; pos_x++) {
+		assert(fishery->vegetation_layer[pos_x].vegetation_level == 
+			tiled_fishery->vegetation_layer[pos_x].vegetation_level);
+		assert(fishery->vegetation_layer[pos_x].soil_energy == 
+			tiled_fishery->vegetation_layer[pos_x].soil_energy);
+	}
+	assert(!SetFisheryLayout(tiled_fishery, FISHERY_LAYOUT_N));
+	DestroyFishery(fishery);
+	DestroyFishery(tiled_fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestVegetationSpread(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	/* Spreading tiles at the borders of the words of the bitboards. */
+	int seeds[][2] = { { 0, 0 }, { 2, 63 }, { 0, 64 }, { 4, 127 }, { 3, 129 } };
+	int i, j, k, pos_x, pos_y, expected;
+	Tile *tile;
+
+	settings.size_x = 5;
+	settings.size_y = 130;
+	settings.initial_vegetation_size = 10;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 0;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 0;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 0;
+
+	printf("Testing vegetation spread of UpdateFisheryVegetation()!\n");
+	srand(10);
+	fishery = CreateFishery(settings);
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		fishery->vegetation_layer[i].vegetation_level = 0;
+		fishery->vegetation_layer[i].soil_energy = 0;
+	}
+	for (i = 0; i < (int)(sizeof(seeds) / sizeof(seeds[0])); i++) {
+		tile = &fishery->vegetation_layer[seeds[i][1] + seeds[i][0]*settings.size_y];
+		tile->vegetation_level = 3;
+		tile->soil_energy = 10;
+	}
+	UpdateFisheryVegetation(fishery, settings);
+	for (pos_x = 0; pos_x < settings.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+			tile = &fishery->vegetation_layer[pos_y + pos_x*settings.size_y];
+			expected = 0;
+			for (i = 0; i < (int)(sizeof(seeds) / sizeof(seeds[0])); i++) {
+				j = seeds[i][0] - pos_x;
+				k = seeds[i][1] - pos_y;
+				if (j == 0 && k == 0) {
+					expected = 4;
+					break;
+				}
+				if (j >= -1 && j <= 1 && k >= -1 && k <= 1)
+					expected = 1;
+			}
+			assert(tile->vegetation_level == expected);
+		}
+	}
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestDirectedMoves(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	Fish_Pool *fish;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	long long i;
+
+	settings.size_x = 15;
+	settings.size_y = 15;
+	settings.initial_vegetation_size = 40;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 1;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 20;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing directed_moves option!\n");
+	srand(11);
+	fishery = CreateFishery(settings);
+	fishery->options.directed_moves = 1;
+	/* Single fish pool in a corner, vegetation in the opposite corner. */
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		fishery->vegetation_layer[i].vegetation_level = 0;
+		fishery->vegetation_layer[i].local_fish = NULL;
+	}
+	fishery->vegetation_layer[settings.size_x*settings.size_y - 1].vegetation_level = 5;
+	fish = fishery->fish_list->node_value;
+	fish->pos_x = 0;
+	fish->pos_y = 0;
+	fish->pop_level = 2;
+	fish->food_level = 0;
+	fishery->vegetation_layer[0].local_fish = fish;
+	UpdateFisheryFishPopulation(fishery, settings);
+	/* The fish pool crosses the diagonal in one move and eats. */
+	assert(fish->pos_x == settings.size_x - 1 && fish->pos_y == settings.size_y - 1);
+	assert(fishery->events.moves == settings.size_x - 1);
+	assert(fishery->vegetation_layer[settings.size_x*settings.size_y - 1].vegetation_level < 5);
+	assert(CheckFishMemory(fishery, settings));
+	DestroyFishery(fishery);
+
+	/* Longer simulation keeps the fish pools consistent. */
+	settings.size_x = 40;
+	settings.size_y = 30;
+	settings.initial_vegetation_size = 100;
+	settings.initial_fish_size = 200;
+	settings.random_fishes_interval = 30;
+	srand(12);
+	fishery = CreateFishery(settings);
+	fishery->options.directed_moves = 1;
+	UpdateFishery(fishery, settings, 30);
+	assert(CheckFishMemory(fishery, settings));
+	assert(SetFisheryLayout(fishery, FISHERY_LAYOUT_TILED));
+	UpdateFishery(fishery, settings, 30);
+	assert(CheckFishMemory(fishery, settings));
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestToroidal(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *tiled_fishery;
+	Fishery_Results results, tiled_results;
+	Fish_Pool fish;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	/* Spreading tiles at the borders of the vegetation layer. */
+	int seeds[][2] = { { 0, 0 }, { 4, 129 }, { 2, 64 } };
+	int i, j, k, pos_x, pos_y, expected;
+	Tile *tile;
+
+	settings.size_x = 5;
+	settings.size_y = 130;
+	settings.initial_vegetation_size = 10;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 0;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 0;
+
+	printf("Testing toroidal option!\n");
+	srand(13);
+	fishery = CreateFishery(settings);
+	fishery->options.toroidal = 1;
+	for (i = 0; i < settings.size_x*settings.size_y; i++) {
+		fishery->vegetation_layer[i].vegetation_level = 0;
+		fishery->vegetation_layer[i].soil_energy = 0;
+	}
+	for (i = 0; i < (int)(sizeof(seeds) / sizeof(seeds[0])); i++) {
+		tile = &fishery->vegetation_layer[seeds[i][1] + seeds[i][0]*settings.size_y];
+		tile->vegetation_level = 3;
+		tile->soil_energy = 10;
+	}
+	UpdateFisheryVegetation(fishery, settings);
+	for (pos_x = 0; pos_x < settings.size_x; pos_x++) {
+		for (pos_y = 0; pos_y < settings.size_y; pos_y++) {
+			tile = &fishery->vegetation_layer[pos_y + pos_x*settings.size_y];
+			expected = 0;
+			for (i = 0; i < (int)(sizeof(seeds) / sizeof(seeds[0])); i++) {
+				/* Distances across the borders. */
+				j = (seeds[i][0] - pos_x + settings.size_x + 1) % settings.size_x - 1;
+				k = (seeds[i][1] - pos_y + settings.size_y + 1) % settings.size_y - 1;
+				if (j == 0 && k == 0) {
+					expected = 4;
+					break;
+				}
+				if (j <= 1 && k <= 1)
+					expected = 1;
+			}
+			assert(tile->vegetation_level == expected);
+		}
+	}
+	/* The only free tile next to a corner is the opposite corner. */
+	for (i = 0; i < settings.size_x*settings.size_y; i++)
+		fishery->vegetation_layer[i].local_fish = &fish;
+	fishery->vegetation_layer[settings.size_x*settings.size_y - 1].local_fish = NULL;
+	assert(GetNewCoords(0, 1, settings.size_x, settings.size_y, fishery) == 
+		settings.size_x*settings.size_y - 1);
+	fishery->options.toroidal = 0;
+	assert(GetNewCoords(0, 1, settings.size_x, settings.size_y, fishery) == -1);
+	for (i = 0; i < settings.size_x*settings.size_y; i++)
+		fishery->vegetation_layer[i].local_fish = NULL;
+	DestroyFishery(fishery);
+
+	/* Layouts update toroidal fisheries the same way. */
+	settings.size_x = 21;
+	settings.size_y = 13;
+	settings.initial_vegetation_size = 60;
+	settings.initial_fish_size = 30;
+	settings.random_fishes_interval = 30;
+	settings.fishing_chance = 10;
+	srand(14);
+	fishery = CreateFishery(settings);
+	fishery->options.toroidal = 1;
+	srand(14);
+	tiled_fishery = CreateFishery(settings);
+	tiled_fishery->options.toroidal = 1;
+	assert(SetFisheryLayout(tiled_fishery, FISHERY_LAYOUT_TILED));
+	srand(15);
+	results = UpdateFishery(fishery, settings, 60);
+	srand(15);
+	tiled_results = UpdateFishery(tiled_fishery, settings, 60);
+	assert(results.yield == tiled_results.yield && results.fish_n == tiled_results.fish_n &&
+		results.vegetation_n == tiled_results.vegetation_n);
+	assert(CheckFishMemory(fishery, settings));
+	assert(CheckFishMemory(tiled_fishery, settings));
+	DestroyFishery(fishery);
+	DestroyFishery(tiled_fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestPhasedMetabolism(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *tiled_fishery;
+	Fishery_Results results, tiled_results;
+	Fish_Pool *fishes[4];
+	LList_Node *node;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	/* Population and food levels before and after the update: starving, 
+	   shrinking, splitting and growing fish pools. */
+	int levels[4][4] = { { 1, 0, 0, 0 }, { 3, 0, 2, 0 }, { 5, 50, 5, 44 }, { 2, 20, 5, 5 } };
+	long long i, fish_n;
+
+	settings.size_x = 10;
+	settings.size_y = 10;
+	settings.initial_vegetation_size = 10;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 4;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 2;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 0;
+
+	printf("Testing phased_metabolism option!\n");
+	srand(16);
+	fishery = CreateFishery(settings);
+	fishery->options.phased_metabolism = 1;
+	/* Without vegetation the metabolism does not depend on the moves. */
+	for (i = 0; i < settings.size_x*settings.size_y; i++)
+		fishery->vegetation_layer[i].vegetation_level = 0;
+	for (node = fishery->fish_list, i = 0; i < 4; node = node->next, i++) {
+		fishes[i] = node->node_value;
+		fishes[i]->pop_level = levels[i][0];
+		fishes[i]->food_level = levels[i][1];
+	}
+	UpdateFisheryFishPopulation(fishery, settings);
+	assert(fishery->events.starvation_deaths == 1 && fishery->events.splits == 1);
+	for (i = 1; i < 4; i++)
+		assert(fishes[i]->pop_level == levels[i][2] && fishes[i]->food_level == levels[i][3]);
+	fish_n = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		fish_n++;
+	assert(fish_n == 4);
+	assert(CheckFishMemory(fishery, settings));
+	DestroyFishery(fishery);
+
+	/* Layouts update phased fisheries the same way. */
+	settings.size_x = 40;
+	settings.size_y = 30;
+	settings.initial_vegetation_size = 200;
+	settings.initial_fish_size = 150;
+	settings.random_fishes_interval = 30;
+	settings.fishing_chance = 10;
+	srand(17);
+	fishery = CreateFishery(settings);
+	fishery->options.phased_metabolism = 1;
+	srand(17);
+	tiled_fishery = CreateFishery(settings);
+	tiled_fishery->options.phased_metabolism = 1;
+	assert(SetFisheryLayout(tiled_fishery, FISHERY_LAYOUT_TILED));
+	srand(18);
+	results = UpdateFishery(fishery, settings, 60);
+	srand(18);
+	tiled_results = UpdateFishery(tiled_fishery, settings, 60);
+	assert(results.yield == tiled_results.yield && results.fish_n == tiled_results.fish_n &&
+		results.vegetation_n == tiled_results.vegetation_n);
+	assert(CheckFishMemory(fishery, settings));
+	assert(CheckFishMemory(tiled_fishery, settings));
+	DestroyFishery(fishery);
+	DestroyFishery(tiled_fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestSpatialSort(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *tiled_fishery;
+	Fishery_Results results, tiled_results;
+	LList_Node *node;
+	Fish_Pool *fish;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	long long fish_n, sorted_n, pos, previous_pos;
+
+	settings.size_x = 70;
+	settings.size_y = 50;
+	settings.initial_vegetation_size = 500;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 600;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing spatial_sort option!\n");
+	srand(19);
+	fishery = CreateFishery(settings);
+	fishery->options.spatial_sort = 1;
+	srand(19);
+	tiled_fishery = CreateFishery(settings);
+	tiled_fishery->options.spatial_sort = 1;
+	assert(SetFisheryLayout(tiled_fishery, FISHERY_LAYOUT_TILED));
+	srand(20);
+	results = UpdateFishery(fishery, settings, 40);
+	srand(20);
+	tiled_results = UpdateFishery(tiled_fishery, settings, 40);
+	/* The order of the fish pools does not depend on the layout. */
+	assert(results.yield == tiled_results.yield && results.fish_n == tiled_results.fish_n &&
+		results.vegetation_n == tiled_results.vegetation_n);
+	assert(CheckFishMemory(fishery, settings));
+	assert(CheckFishMemory(tiled_fishery, settings));
+	DestroyFishery(tiled_fishery);
+	/* Sorting keeps every fish pool and orders them column by column. */
+	fish_n = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		fish_n++;
+	assert(SortFisheryFish(fishery));
+	sorted_n = 0;
+	previous_pos = -1;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next) {
+		fish = node->node_value;
+		pos = fish->pos_y + (long long)fish->pos_x*settings.size_y;
+		assert(pos > previous_pos);
+		previous_pos = pos;
+		sorted_n++;
+	}
+	assert(sorted_n == fish_n);
+	assert(CheckFishMemory(fishery, settings));
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestQuiescence(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *stepped_fishery;
+	Fishery_Results results, stepped_results;
+	Fishery_Step step;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	long long i, n = 3000;
+
+	settings.size_x = 60;
+	settings.size_y = 45;
+	settings.initial_vegetation_size = 30;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	/* Heavy fishing wipes out the fish pools. */
+	settings.initial_fish_size = 100;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 0;
+
+	settings.fishing_chance = 60;
+
+	printf("Testing fast-forward of quiescent fisheries!\n");
+	srand(21);
+	fishery = CreateFishery(settings);
+	srand(21);
+	stepped_fishery = CreateFishery(settings);
+	srand(22);
+	results = UpdateFishery(fishery, settings, n);
+	assert(LListIsEmpty(fishery->fish_list));
+	/* The same steps one by one. */
+	srand(22);
+	InitFisheryResults(&stepped_results, stepped_fishery);
+	for (i = 0; i < n; i++) {
+		step = StepFishery(stepped_fishery, settings);
+		AddFisheryStep(&stepped_results, &step);
+	}
+	FinishFisheryResults(&stepped_results, stepped_fishery, n);
+	assert(results.steps == stepped_results.steps && results.yield == stepped_results.yield &&
+		results.fish_n == stepped_results.fish_n && 
+		results.vegetation_n == stepped_results.vegetation_n &&
+		results.debug_stuff == stepped_results.debug_stuff);
+	assert(results.yield_std_dev == stepped_results.yield_std_dev &&
+		results.fish_n_std_dev == stepped_results.fish_n_std_dev &&
+		results.vegetation_n_std_dev == stepped_results.vegetation_n_std_dev);
+	assert(memcmp(&results.events, &stepped_results.events, sizeof(Fishery_Events)) == 0);
+	assert(memcmp(fishery->vegetation_layer, stepped_fishery->vegetation_layer, 
+		sizeof(Tile)*(size_t)fishery->layout.n_tiles) == 0);
+	/* Fewer simulated steps than the run. */
+	assert(fishery->profile.steps < stepped_fishery->profile.steps);
+	DestroyFishery(fishery);
+	DestroyFishery(stepped_fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestMoveIndex(void) {
+	Fishery_Settings settings;
+	Fishery *fishery;
+	Fishery_Move_Index *built;
+	LList_Node *node;
+	Fish_Pool *fish;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	long long pos, indexed_pos, scanned_pos, n_cells;
+	int i, radius, toroidal, layout, phased;
+
+	settings.size_x = 45;
+	settings.size_y = 70;
+	settings.initial_vegetation_size = 900;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 1200;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+	n_cells = (long long)settings.size_x*settings.size_y;
+
+	printf("Testing move index!\n");
+	for (layout = 0; layout < FISHERY_LAYOUT_N; layout++) {
+		srand(23);
+		fishery = CreateFishery(settings);
+		assert(SetFisheryLayout(fishery, layout));
+		UpdateFishery(fishery, settings, 5);
+		fishery->move_index = CreateMoveIndex(settings.size_x, settings.size_y);
+		assert(fishery->move_index != NULL);
+		BuildMoveIndex(fishery->move_index, fishery);
+		/* The index finds the same coordinates as the scan of the window. */
+		for (toroidal = 0; toroidal < 2; toroidal++) {
+			fishery->options.toroidal = toroidal;
+			node = fishery->fish_list;
+			for (i = 0; i < 300 && node != NULL && node->node_value != NULL; i++, node = node->next) {
+				fish = node->node_value;
+				pos = LayoutIndex(&fishery->layout, fish->pos_x, fish->pos_y);
+				radius = MOVE_INDEX_MIN_RADIUS + i % 30;
+				fishery->move_index->valid = 1;
+				srand(100 + i);
+				indexed_pos = GetNewCoords(pos, radius, settings.size_x, settings.size_y, fishery);
+				fishery->move_index->valid = 0;
+				srand(100 + i);
+				scanned_pos = GetNewCoords(pos, radius, settings.size_x, settings.size_y, fishery);
+				assert(indexed_pos == scanned_pos);
+			}
+		}
+		DestroyFishery(fishery);
+	}
+	/* The index stays up to date during fish population updates. */
+	for (phased = 0; phased < 2; phased++) {
+		srand(24);
+		fishery = CreateFishery(settings);
+		fishery->options.move_radius = 6;
+		fishery->options.phased_metabolism = phased;
+		built = CreateMoveIndex(settings.size_x, settings.size_y);
+		for (i = 0; i < 20; i++) {
+			UpdateFisheryVegetation(fishery, settings);
+			UpdateFisheryFishPopulation(fishery, settings);
+			BuildMoveIndex(built, fishery);
+			assert(memcmp(built->free_counts, fishery->move_index->free_counts, 
+				sizeof(int)*(size_t)n_cells) == 0);
+			assert(memcmp(built->vegetation_counts, fishery->move_index->vegetation_counts, 
+				sizeof(int)*(size_t)n_cells) == 0);
+			FishingEvent(fishery, settings);
+		}
+		assert(fishery->events.moves > 0);
+		assert(CheckFishMemory(fishery, settings));
+		DestroyMoveIndex(built);
+		DestroyFishery(fishery);
+	}
+	printf("Test passed.\n");
+	return 1;
+}
+int TestFisheryDomains(void) {
+	Fishery_Settings settings;
+	Fishery *fishery, *socket_fishery;
+	Fishery_Results results, socket_results;
+	LList_Node *node, *socket_node;
+	Fish_Pool *fish, *socket_fish;
+	Tile *tile, *socket_tile;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	/* Population, food and position of the fish pools of the full domain
+	   test, all except the one at (2, 1) are fed. */
+	Fish_Pool fish_pools[7] = { { 1, 100, 0, 0 }, { 1, 100, 0, 1 }, { 5, 100, 1, 0 },
+		{ 1, 100, 2, 0 }, { 2, 0, 2, 1 }, { 1, 100, 3, 0 }, { 1, 100, 3, 1 } };
+	long long i, n = 40, n_spawn = 2000, n_pools;
+	int vegetation_levels[8], n_domains;
+
+	settings.size_x = 50;
+	settings.size_y = 30;
+	settings.initial_vegetation_size = 400;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 300;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 30;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing domain-decomposed fisheries!\n");
+	srand(25);
+	fishery = CreateFishery(settings);
+	srand(25);
+	socket_fishery = CreateFishery(settings);
+	/* Unsupported options and too narrow domains. */
+	fishery->options.toroidal = 1;
+	assert(UpdateFisheryDomains(fishery, settings, n, 3, FISHERY_TRANSPORT_LOCAL, 7, &results) == 0);
+	fishery->options.toroidal = 0;
+	assert(UpdateFisheryDomains(fishery, settings, n, settings.size_x, 
+		FISHERY_TRANSPORT_LOCAL, 7, &results) == 0);
+	assert(UpdateFisheryDomains(fishery, settings, n, 3, 
+		FISHERY_TRANSPORT_SOCKETS + 1, 7, &results) == 0);
+	assert(CheckFishMemory(fishery, settings));
+	/* Domains in one process and in a process each give the same results. */
+	assert(UpdateFisheryDomains(fishery, settings, n, 3, FISHERY_TRANSPORT_LOCAL, 7, &results));
+	assert(UpdateFisheryDomains(socket_fishery, settings, n, 3, FISHERY_TRANSPORT_SOCKETS, 7, 
+		&socket_results));
+	assert(results.steps == n && results.fish_n > 0 && results.yield > 0);
+	assert(results.events.moves > 0 && results.events.splits > 0 && results.events.spawns > 0);
+	assert(results.yield == socket_results.yield && results.fish_n == socket_results.fish_n &&
+		results.vegetation_n == socket_results.vegetation_n &&
+		results.debug_stuff == socket_results.debug_stuff);
+	assert(results.yield_std_dev == socket_results.yield_std_dev &&
+		results.fish_n_std_dev == socket_results.fish_n_std_dev &&
+		results.vegetation_n_std_dev == socket_results.vegetation_n_std_dev);
+	assert(memcmp(&results.events, &socket_results.events, sizeof(Fishery_Events)) == 0);
+	for (i = 0; i < fishery->layout.n_tiles; i++) {
+		tile = &fishery->vegetation_layer[i];
+		socket_tile = &socket_fishery->vegetation_layer[i];
+		assert(tile->vegetation_level == socket_tile->vegetation_level &&
+			tile->soil_energy == socket_tile->soil_energy);
+	}
+	node = fishery->fish_list;
+	socket_node = socket_fishery->fish_list;
+	while (node != NULL && node->node_value != NULL) {
+		assert(socket_node != NULL && socket_node->node_value != NULL);
+		fish = node->node_value;
+		socket_fish = socket_node->node_value;
+		assert(memcmp(fish, socket_fish, sizeof(Fish_Pool)) == 0);
+		node = node->next;
+		socket_node = socket_node->next;
+	}
+	assert(socket_node == NULL || socket_node->node_value == NULL);
+	assert(CheckFishMemory(fishery, settings));
+	assert(CheckFishMemory(socket_fishery, settings));
+	/* The fishery continues from the state of the domains. */
+	results = UpdateFishery(fishery, settings, 5);
+	assert(results.steps == 5);
+	DestroyFishery(fishery);
+	DestroyFishery(socket_fishery);
+	/* Progressed fisheries, in which fish pools that grew can have negative
+	   food levels, are decomposed, and decomposed again after a run. */
+	srand(25);
+	fishery = CreateFishery(settings);
+	srand(25);
+	socket_fishery = CreateFishery(settings);
+	srand(26);
+	UpdateFishery(fishery, settings, 2);
+	srand(26);
+	UpdateFishery(socket_fishery, settings, 2);
+	n_pools = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		n_pools += ((Fish_Pool *)node->node_value)->food_level < 0;
+	assert(n_pools > 0);
+	for (n_domains = 3; n_domains <= 4; n_domains++) {
+		assert(UpdateFisheryDomains(fishery, settings, n, n_domains, FISHERY_TRANSPORT_LOCAL,
+			8, &results));
+		assert(UpdateFisheryDomains(socket_fishery, settings, n, n_domains,
+			FISHERY_TRANSPORT_SOCKETS, 8, &socket_results));
+		assert(results.steps == n && results.fish_n > 0);
+		assert(results.yield == socket_results.yield && results.fish_n == socket_results.fish_n &&
+			results.vegetation_n == socket_results.vegetation_n);
+		assert(memcmp(&results.events, &socket_results.events, sizeof(Fishery_Events)) == 0);
+		assert(CheckFishMemory(fishery, settings));
+		assert(CheckFishMemory(socket_fishery, settings));
+	}
+	DestroyFishery(fishery);
+	DestroyFishery(socket_fishery);
+	/* A migrant arriving in a domain which filled up in the same step dies
+	   as a starvation death. The right domain's hungry fish pool at (2, 1) 
+	   can only move to (1, 1), into which the fish pool at (1, 0) of the 
+	   left domain splits. */
+	settings.size_x = 4;
+	settings.size_y = 2;
+	settings.random_fishes_interval = 0;
+	settings.fishing_chance = 0;
+	memset(vegetation_levels, 0, sizeof(vegetation_levels));
+	fishery = CreateFisheryFromState(settings, vegetation_levels, NULL, fish_pools, 7);
+	assert(fishery != NULL);
+	assert(UpdateFisheryDomains(fishery, settings, 1, 2, FISHERY_TRANSPORT_LOCAL, 7, &results));
+	assert(results.events.splits == 1 && results.events.starvation_deaths == 1);
+	n_pools = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		n_pools++;
+	assert(n_pools == 7);
+	assert(CheckFishMemory(fishery, settings));
+	DestroyFishery(fishery);
+	/* The spawn rate does not depend on the number of domains. Spawns are
+	   binomial with a standard deviation of about 13 here. */
+	settings.size_x = 64;
+	settings.size_y = 16;
+	settings.initial_fish_size = 20;
+	settings.random_fishes_interval = 10;
+	srand(25);
+	fishery = CreateFishery(settings);
+	results = UpdateFishery(fishery, settings, n_spawn);
+	DestroyFishery(fishery);
+	for (n_domains = 1; n_domains <= 8; n_domains *= 2) {
+		srand(25);
+		fishery = CreateFishery(settings);
+		assert(UpdateFisheryDomains(fishery, settings, n_spawn, n_domains,
+			FISHERY_TRANSPORT_LOCAL, 7, &socket_results));
+		assert(llabs(socket_results.events.spawns - results.events.spawns) < 70);
+		DestroyFishery(fishery);
+	}
+	printf("Test passed.\n");
+	return 1;
+}
+/* Records the totals of the steps of TestJobTable. */
+static int RecordTestStep(void *data, const Fishery_Step *step) {
+	Fishery_Step *series = data;
+
+	series[step->step - 1] = *step;
+	return 0;
+}
+int TestJobTable(void) {
+	Fishery_Settings settings, job_settings[6];
+	Fishery *fishery, *expected, *job_fisheries[6];
+	Fishery_Job_Table *table;
+	Fishery_Job_Result *result;
+	Fishery_Results results;
+	Fishery_Step series[30];
+	LList_Node *node;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	unsigned long long seeds[6] = { 1, 2, 3, 4, 5, 1 };
+	long long i, n = 30, n_jobs = 6, n_negative;
+
+	settings.size_x = 30;
+	settings.size_y = 25;
+	settings.initial_vegetation_size = 200;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 80;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 10;
+
+	settings.fishing_chance = 10;
+
+	printf("Testing job tables!\n");
+	srand(26);
+	fishery = CreateFishery(settings);
+	assert(SetFisheryLayout(fishery, FISHERY_LAYOUT_TILED));
+	for (i = 0; i < n_jobs; i++) {
+		job_fisheries[i] = fishery;
+		job_settings[i] = settings;
+	}
+	assert(CreateJobTable(0, n, 0) == NULL);
+	table = CreateJobTable(n_jobs, n, 1);
+	assert(table != NULL);
+	assert(RunJobTable(table, job_fisheries, job_settings, seeds, 0) == -1);
+	assert(RunJobTable(table, job_fisheries, job_settings, seeds, 3) == n_jobs);
+	/* The fishery of the jobs is not changed. */
+	assert(fishery->profile.steps == 0);
+	for (i = 0; i < n_jobs; i++) {
+		result = &table->results[i];
+		assert(result->status == FISHERY_JOB_DONE && result->worker > 0);
+		srand(26);
+		expected = CreateFishery(settings);
+		expected->options.private_rng = 1;
+		SeedFisheryRNG(expected, seeds[i]);
+		results = UpdateFisheryCallback(expected, settings, n, 1, RecordTestStep, series);
+		assert(result->results.steps == n && result->results.yield == results.yield &&
+			result->results.fish_n == results.fish_n &&
+			result->results.vegetation_n == results.vegetation_n);
+		assert(memcmp(&result->results.events, &results.events, sizeof(Fishery_Events)) == 0);
+		assert(memcmp(&table->series[i*n], series, sizeof(Fishery_Step)*n) == 0);
+		DestroyFishery(expected);
+	}
+	/* Equal seeds give equal results. */
+	assert(memcmp(&table->results[0].results, &table->results[5].results, 
+		sizeof(Fishery_Results)) == 0);
+	/* A worker crashing on a missing fishery is replaced, the other jobs 
+	   are done. */
+	job_fisheries[2] = NULL;
+	results = table->results[3].results;
+	assert(RunJobTable(table, job_fisheries, job_settings, seeds, 2) == n_jobs - 1);
+	for (i = 0; i < n_jobs; i++)
+		assert(table->results[i].status == (i == 2 ? FISHERY_JOB_FAILED : FISHERY_JOB_DONE));
+	assert(memcmp(&table->results[3].results, &results, sizeof(Fishery_Results)) == 0);
+	/* Jobs run on a progressed fishery, in which fish pools that grew can
+	   have negative food levels. */
+	srand(27);
+	UpdateFishery(fishery, settings, 2);
+	n_negative = 0;
+	for (node = fishery->fish_list; node != NULL && node->node_value != NULL; node = node->next)
+		n_negative += ((Fish_Pool *)node->node_value)->food_level < 0;
+	assert(n_negative > 0);
+	job_fisheries[2] = fishery;
+	assert(RunJobTable(table, job_fisheries, job_settings, seeds, 3) == n_jobs);
+	for (i = 0; i < n_jobs; i++) {
+		result = &table->results[i];
+		assert(result->status == FISHERY_JOB_DONE);
+		srand(26);
+		expected = CreateFishery(settings);
+		srand(27);
+		UpdateFishery(expected, settings, 2);
+		SeedFisheryRNG(expected, seeds[i]);
+		results = UpdateFishery(expected, settings, n);
+		assert(result->results.steps == n && result->results.yield == results.yield &&
+			result->results.fish_n == results.fish_n &&
+			result->results.vegetation_n == results.vegetation_n);
+		assert(memcmp(&result->results.events, &results.events, sizeof(Fishery_Events)) == 0);
+		DestroyFishery(expected);
+	}
+	DestroyJobTable(table);
+	DestroyFishery(fishery);
+	printf("Test passed.\n");
+	return 1;
+}
+int TestReferenceEngine(void) {
+	Fishery_Settings settings;
+	Fishery *reference, *fishery;
+	Fishery_Step step, reference_step;
+	LList_Node *node;
+	int consumption[] = { 0, 1, 1, 2, 2, 3 };
+	int fish_consumption[] = { 0, 1, 2, 3, 4, 5 };
+	int i, layout, private_rng;
+
+	settings.size_x = 21;
+	settings.size_y = 19;
+	settings.initial_vegetation_size = 100;
+	settings.vegetation_level_max = 5;
+	settings.vegetation_level_spread_at = 3;
+	settings.vegetation_level_growth_req = 3;
+	settings.vegetation_consumption = consumption;
+	settings.soil_energy_increase_turn = 3;
+	settings.soil_energy_max = 10;
+
+	settings.initial_fish_size = 60;
+	settings.fish_growth_req = 1;
+	settings.fish_level_max = 5;
+	settings.fish_moves_turn = 5;
+	settings.fish_consumption = fish_consumption;
+
+	settings.split_fishes_at_max = 1;
+	settings.random_fishes_interval = 20;
+
+	settings.fishing_chance = 15;
+
+	printf("Testing reference engine!\n");
+	for (layout = 0; layout < FISHERY_LAYOUT_N; layout++) {
+		for (private_rng = 0; private_rng <= 1; private_rng++) {
+			srand(50);
+			reference = CreateFishery(settings);
+			srand(50);
+			fishery = CreateFishery(settings);
+			assert(layout == FISHERY_LAYOUT_COLUMNS || SetFisheryLayout(fishery, layout));
+			if (private_rng) {
+				SeedFisheryRNG(reference, 50);
+				SeedFisheryRNG(fishery, 50);
+			}
+			assert(CompareFisheryState(reference, fishery, settings, 1));
+			for (i = 0; i < 40; i++) {
+				srand(51 + i);
+				reference_step = ReferenceStepFishery(reference, settings);
+				srand(51 + i);
+				step = StepFishery(fishery, settings);
+				assert(step.fish_n == reference_step.fish_n && step.yield == reference_step.yield &&
+					step.vegetation_n == reference_step.vegetation_n);
+				assert(CompareFisheryState(reference, fishery, settings, 1));
+			}
+			/* A changed tile or fish pool is found. */
+			fishery->vegetation_layer[LayoutIndex(&fishery->layout, 20, 18)].soil_energy++;
+			assert(!CompareFisheryState(reference, fishery, settings, 0));
+			fishery->vegetation_layer[LayoutIndex(&fishery->layout, 20, 18)].soil_energy--;
+			node = fishery->fish_list;
+			if (node->node_value != NULL) {
+				((Fish_Pool *)node->node_value)->food_level++;
+				assert(!CompareFisheryState(reference, fishery, settings, 0));
+			}
+			DestroyFishery(reference);
+			DestroyFishery(fishery);
+		}
+	}
+	printf("Test passed.\n");
+	return 1;
+}
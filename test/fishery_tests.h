@@ -9,6 +9,7 @@ Contains functions for testing different properties of the fishery simulation.
 #define FISHERY_TESTS_H_
 
 #include <stdlib.h>
+#include <math.h>
 #include "fishery_data_types.h"
 #include "fishery_functions.h"
 #include "fishery_settings.h"
@@ -19,6 +20,27 @@ int TestFisheryAll(void);
 int TestFisherySettings(void);
 int TestAddSettings(void);
 int TestInitialFishery(void);
+int TestCreateFisheryFromState(void);
 
 int TestGetNewCoords(void);
+int TestGenerateRandLong(void);
+int TestGenerateRandSample(void);
+int TestFisheryStorage(void);
+int TestFisheryPlan(void);
+int TestFisheryProfile(void);
+int TestFisheryEvents(void);
+int TestFishingSampling(void);
+int TestUpdateFisheryCallback(void);
+int TestFisheryEnsemble(void);
+int TestFisheryLayout(void);
+int TestVegetationSpread(void);
+int TestDirectedMoves(void);
+int TestToroidal(void);
+int TestPhasedMetabolism(void);
+int TestSpatialSort(void);
+int TestQuiescence(void);
+int TestMoveIndex(void);
+int TestFisheryDomains(void);
+int TestJobTable(void);
+int TestReferenceEngine(void);
 #endif /* FISHERY_TESTS_H_ */
\ No newline at end of file